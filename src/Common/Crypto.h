@@ -48,6 +48,9 @@ extern "C" {
 // VeraCrypt Argon2id header key material size, in bytes, for the current volume format.
 // This is intentionally fixed for compatibility and must not depend on GetMaxPkcs5OutSize().
 #define ARGON2_HEADER_KEYDATA_SIZE	192
+// Maximum number of Argon2id lanes a header key may be derived with. Headers use a single lane
+// unless another number of lanes is selected when the volume is created.
+#define ARGON2_MAX_HEADER_LANES		8
 #endif
 
 // The first PRF to try when mounting
@@ -36,6 +36,21 @@
 #include "Pkcs5.h"
 #include "Crypto.h"
 
+#if !defined (TC_WINDOWS_BOOT) && !defined (TC_WINDOWS_DRIVER) && !defined (_UEFI) && CRYPTOPP_BOOL_X64
+/* Output blocks of PBKDF2-HMAC-SHA-256/512 and PBKDF2-HMAC-BLAKE2s are derived together on the lanes of a
+   multi-buffer kernel. A group of lanes costs about as much as 6 single SHA-NI chains, so it is only used from
+   there, but as much as a single BLAKE2s chain. */
+#define PKCS5_SHA2_MB_AVAILABLE
+#if CRYPTOPP_SHANI_AVAILABLE
+#define SHA256_MB_MIN_BLOCKS	(HasSHA256 () ? 6 : 3)
+#else
+#define SHA256_MB_MIN_BLOCKS	3
+#endif
+#define SHA512_MB_MIN_BLOCKS	2
+#define PKCS5_BLAKE2S_MB_AVAILABLE
+#define BLAKE2S_MB_MIN_BLOCKS	2
+#endif
+
 #if !defined(TC_WINDOWS_BOOT) || defined(TC_WINDOWS_BOOT_SHA2)
 
 typedef struct hmac_sha256_ctx_struct
@@ -204,12 +219,55 @@ static void derive_u_sha256 (const unsigned char *salt, int salt_len, uint32 ite
 	}
 }
 
+#ifdef PKCS5_SHA2_MB_AVAILABLE
+/* Derives count consecutive output blocks starting at block number b, each one on a lane of the
+   multi-buffer kernel, and writes the first size bytes of them to dk. Returns 0 if aborted. */
+static int derive_u_sha256_mb (const unsigned char *salt, int salt_len, uint32 iterations, int b, int count, hmac_sha256_ctx* hmac, unsigned char *dk, int size, long volatile *pAbortKeyDerivation)
+{
+	CRYPTOPP_ALIGN_DATA(32) uint_32t u[SHA256_MB_LANES][8];
+	unsigned char* k = hmac->k;
+	uint32 blockNumber;
+	int lane, i, result;
+
+	memset (u, 0, sizeof (u));
+
+	/* iteration 1 of each block */
+	for (lane = 0; lane < count; lane++)
+	{
+		memcpy (k, salt, salt_len);
+		blockNumber = BE32 ((uint32) (b + lane));
+		memcpy (&k[salt_len], &blockNumber, 4);
+
+		hmac_sha256_internal (k, salt_len + 4, hmac);
+		memcpy (u[lane], k, SHA256_DIGESTSIZE);
+		for (i = 0; i < 8; i++)
+			u[lane][i] = BE32 (u[lane][i]);
+	}
+
+	/* remaining iterations */
+	result = sha256_pbkdf2_avx2 (hmac->inner_digest_ctx.hash, hmac->outer_digest_ctx.hash, u, iterations, pAbortKeyDerivation);
+	if (result)
+	{
+		for (lane = 0; lane < count; lane++)
+		{
+			for (i = 0; i < 8; i++)
+				u[lane][i] = BE32 (u[lane][i]);
+		}
+
+		memcpy (dk, u, size);
+	}
+
+	burn (u, sizeof (u));
+	return result;
+}
+#endif
+
 
-void derive_key_sha256 (const unsigned char *pwd, int pwd_len, const unsigned char *salt, int salt_len, uint32 iterations, unsigned char *dk, int dklen
 #ifndef TC_WINDOWS_BOOT
-	, long volatile *pAbortKeyDerivation
+void derive_key_sha256_blocks (const unsigned char *pwd, int pwd_len, const unsigned char *salt, int salt_len, uint32 iterations, unsigned char *dk, int dklen, int first_block, long volatile *pAbortKeyDerivation)
+#else
+void derive_key_sha256 (const unsigned char *pwd, int pwd_len, const unsigned char *salt, int salt_len, uint32 iterations, unsigned char *dk, int dklen)
 #endif
-)
 {	
 	hmac_sha256_ctx hmac;
 	sha256_ctx* ctx;
@@ -275,7 +333,31 @@ void derive_key_sha256 (const unsigned char *pwd, int pwd_len, const unsigned ch
 	sha256_hash (buf, SHA256_BLOCKSIZE, ctx);
 
 	/* first l - 1 blocks */
+#ifndef TC_WINDOWS_BOOT
+	l += first_block;
+	b = first_block + 1;
+#ifdef PKCS5_SHA2_MB_AVAILABLE
+	/* As long as enough blocks remain, they are derived SHA256_MB_LANES at a time, the last one included */
+	while (l - b + 1 >= SHA256_MB_MIN_BLOCKS && HasSAVX2 () && sha2_mb_has_avx2 ())
+	{
+		int count = (l - b + 1 < SHA256_MB_LANES) ? l - b + 1 : SHA256_MB_LANES;
+		int size = (b + count > l) ? (count - 1) * SHA256_DIGESTSIZE + r : count * SHA256_DIGESTSIZE;
+
+		if (!derive_u_sha256_mb (salt, salt_len, iterations, b, count, &hmac, dk, size, pAbortKeyDerivation))
+			goto cancelled;
+
+		dk += size;
+		b += count;
+	}
+
+	/* all the blocks are derived, only the cleanup remains */
+	if (b > l)
+		goto cancelled;
+#endif
+	for (; b < l; b++)
+#else
 	for (b = 1; b < l; b++)
+#endif
 	{
 #ifndef TC_WINDOWS_BOOT
 		derive_u_sha256 (salt, salt_len, iterations, b, &hmac, pAbortKeyDerivation);
@@ -314,6 +396,22 @@ void derive_key_sha256 (const unsigned char *pwd, int pwd_len, const unsigned ch
 #endif
 }
 
+#ifndef TC_WINDOWS_BOOT
+void derive_key_sha256 (const unsigned char *pwd, int pwd_len, const unsigned char *salt, int salt_len, uint32 iterations, unsigned char *dk, int dklen, long volatile *pAbortKeyDerivation)
+{
+	derive_key_sha256_blocks (pwd, pwd_len, salt, salt_len, iterations, dk, dklen, 0, pAbortKeyDerivation);
+}
+
+int derive_key_sha256_min_blocks (void)
+{
+#ifdef PKCS5_SHA2_MB_AVAILABLE
+	if (HasSAVX2 () && sha2_mb_has_avx2 ())
+		return SHA256_MB_MIN_BLOCKS;
+#endif
+	return 1;
+}
+#endif
+
 #endif
 
 #ifndef TC_WINDOWS_BOOT
@@ -453,8 +551,51 @@ static void derive_u_sha512 (const unsigned char *salt, int salt_len, uint32 ite
 	}
 }
 
+#ifdef PKCS5_SHA2_MB_AVAILABLE
+/* Derives count consecutive output blocks starting at block number b, each one on a lane of the
+   multi-buffer kernel, and writes the first size bytes of them to dk. Returns 0 if aborted. */
+static int derive_u_sha512_mb (const unsigned char *salt, int salt_len, uint32 iterations, int b, int count, hmac_sha512_ctx* hmac, unsigned char *dk, int size, long volatile *pAbortKeyDerivation)
+{
+	CRYPTOPP_ALIGN_DATA(32) uint_64t u[SHA512_MB_LANES][8];
+	unsigned char* k = hmac->k;
+	uint32 blockNumber;
+	int lane, i, result;
+
+	memset (u, 0, sizeof (u));
 
-void derive_key_sha512 (const unsigned char *pwd, int pwd_len, const unsigned char *salt, int salt_len, uint32 iterations, unsigned char *dk, int dklen, long volatile *pAbortKeyDerivation)
+	/* iteration 1 of each block */
+	for (lane = 0; lane < count; lane++)
+	{
+		memcpy (k, salt, salt_len);
+		blockNumber = BE32 ((uint32) (b + lane));
+		memcpy (&k[salt_len], &blockNumber, 4);
+
+		hmac_sha512_internal (k, salt_len + 4, hmac);
+		memcpy (u[lane], k, SHA512_DIGESTSIZE);
+		for (i = 0; i < 8; i++)
+			u[lane][i] = BE64 (u[lane][i]);
+	}
+
+	/* remaining iterations */
+	result = sha512_pbkdf2_avx2 (hmac->inner_digest_ctx.hash, hmac->outer_digest_ctx.hash, u, iterations, pAbortKeyDerivation);
+	if (result)
+	{
+		for (lane = 0; lane < count; lane++)
+		{
+			for (i = 0; i < 8; i++)
+				u[lane][i] = BE64 (u[lane][i]);
+		}
+
+		memcpy (dk, u, size);
+	}
+
+	burn (u, sizeof (u));
+	return result;
+}
+#endif
+
+
+void derive_key_sha512_blocks (const unsigned char *pwd, int pwd_len, const unsigned char *salt, int salt_len, uint32 iterations, unsigned char *dk, int dklen, int first_block, long volatile *pAbortKeyDerivation)
 {
 	hmac_sha512_ctx hmac;
 	sha512_ctx* ctx;
@@ -519,7 +660,27 @@ void derive_key_sha512 (const unsigned char *pwd, int pwd_len, const unsigned ch
 	sha512_hash (buf, SHA512_BLOCKSIZE, ctx);
 
 	/* first l - 1 blocks */
-	for (b = 1; b < l; b++)
+	l += first_block;
+	b = first_block + 1;
+#ifdef PKCS5_SHA2_MB_AVAILABLE
+	/* As long as enough blocks remain, they are derived SHA512_MB_LANES at a time, the last one included */
+	while (l - b + 1 >= SHA512_MB_MIN_BLOCKS && HasSAVX2 () && sha2_mb_has_avx2 ())
+	{
+		int count = (l - b + 1 < SHA512_MB_LANES) ? l - b + 1 : SHA512_MB_LANES;
+		int size = (b + count > l) ? (count - 1) * SHA512_DIGESTSIZE + r : count * SHA512_DIGESTSIZE;
+
+		if (!derive_u_sha512_mb (salt, salt_len, iterations, b, count, &hmac, dk, size, pAbortKeyDerivation))
+			goto cancelled;
+
+		dk += size;
+		b += count;
+	}
+
+	/* all the blocks are derived, only the cleanup remains */
+	if (b > l)
+		goto cancelled;
+#endif
+	for (; b < l; b++)
 	{
 		derive_u_sha512 (salt, salt_len, iterations, b, &hmac, pAbortKeyDerivation);
 		// Check if the derivation was aborted
@@ -546,6 +707,20 @@ void derive_key_sha512 (const unsigned char *pwd, int pwd_len, const unsigned ch
 	burn (key, sizeof(key));
 }
 
+void derive_key_sha512 (const unsigned char *pwd, int pwd_len, const unsigned char *salt, int salt_len, uint32 iterations, unsigned char *dk, int dklen, long volatile *pAbortKeyDerivation)
+{
+	derive_key_sha512_blocks (pwd, pwd_len, salt, salt_len, iterations, dk, dklen, 0, pAbortKeyDerivation);
+}
+
+int derive_key_sha512_min_blocks (void)
+{
+#ifdef PKCS5_SHA2_MB_AVAILABLE
+	if (HasSAVX2 () && sha2_mb_has_avx2 ())
+		return SHA512_MB_MIN_BLOCKS;
+#endif
+	return 1;
+}
+
 #endif // TC_WINDOWS_BOOT
 
 #if !defined(TC_WINDOWS_BOOT) || defined(TC_WINDOWS_BOOT_BLAKE2S)
@@ -705,12 +880,45 @@ static void derive_u_blake2s (const unsigned char *salt, int salt_len, uint32 it
 	}
 }
 
+#ifdef PKCS5_BLAKE2S_MB_AVAILABLE
+/* Derives count consecutive output blocks starting at block number b, each one on a lane of the
+   multi-buffer kernel, and writes the first size bytes of them to dk. Returns 0 if aborted. */
+static int derive_u_blake2s_mb (const unsigned char *salt, int salt_len, uint32 iterations, int b, int count, hmac_blake2s_ctx* hmac, unsigned char *dk, int size, volatile long *pAbortKeyDerivation)
+{
+	CRYPTOPP_ALIGN_DATA(32) uint32 u[BLAKE2S_MB_LANES][8];
+	unsigned char* k = hmac->k;
+	uint32 blockNumber;
+	int lane, result;
+
+	memset (u, 0, sizeof (u));
+
+	/* iteration 1 of each block, the digest words being little-endian as the host */
+	for (lane = 0; lane < count; lane++)
+	{
+		memcpy (k, salt, salt_len);
+		blockNumber = bswap_32 ((uint32) (b + lane));
+		memcpy (&k[salt_len], &blockNumber, 4);
+
+		hmac_blake2s_internal (k, salt_len + 4, hmac);
+		memcpy (u[lane], k, BLAKE2S_DIGESTSIZE);
+	}
+
+	/* remaining iterations */
+	result = blake2s_pbkdf2_avx2 (&hmac->inner_digest_ctx, &hmac->outer_digest_ctx, u, iterations, pAbortKeyDerivation);
+	if (result)
+		memcpy (dk, u, size);
+
+	burn (u, sizeof (u));
+	return result;
+}
+#endif
+
 
-void derive_key_blake2s (const unsigned char *pwd, int pwd_len, const unsigned char *salt, int salt_len, uint32 iterations, unsigned char *dk, int dklen
 #ifndef TC_WINDOWS_BOOT
-	, volatile long *pAbortKeyDerivation
+void derive_key_blake2s_blocks (const unsigned char *pwd, int pwd_len, const unsigned char *salt, int salt_len, uint32 iterations, unsigned char *dk, int dklen, int first_block, volatile long *pAbortKeyDerivation)
+#else
+void derive_key_blake2s (const unsigned char *pwd, int pwd_len, const unsigned char *salt, int salt_len, uint32 iterations, unsigned char *dk, int dklen)
 #endif
-)
 {	
 	hmac_blake2s_ctx hmac;
 	blake2s_state* ctx;
@@ -770,7 +978,31 @@ void derive_key_blake2s (const unsigned char *pwd, int pwd_len, const unsigned c
 	blake2s_update (ctx, buf, BLAKE2S_BLOCKSIZE);
 
 	/* first l - 1 blocks */
+#ifndef TC_WINDOWS_BOOT
+	l += first_block;
+	b = first_block + 1;
+#ifdef PKCS5_BLAKE2S_MB_AVAILABLE
+	/* As long as enough blocks remain, they are derived BLAKE2S_MB_LANES at a time, the last one included */
+	while (l - b + 1 >= BLAKE2S_MB_MIN_BLOCKS && HasSAVX2 () && blake2s_mb_has_avx2 ())
+	{
+		int count = (l - b + 1 < BLAKE2S_MB_LANES) ? l - b + 1 : BLAKE2S_MB_LANES;
+		int size = (b + count > l) ? (count - 1) * BLAKE2S_DIGESTSIZE + r : count * BLAKE2S_DIGESTSIZE;
+
+		if (!derive_u_blake2s_mb (salt, salt_len, iterations, b, count, &hmac, dk, size, pAbortKeyDerivation))
+			goto cancelled;
+
+		dk += size;
+		b += count;
+	}
+
+	/* all the blocks are derived, only the cleanup remains */
+	if (b > l)
+		goto cancelled;
+#endif
+	for (; b < l; b++)
+#else
 	for (b = 1; b < l; b++)
+#endif
 	{
 #ifndef TC_WINDOWS_BOOT
 		derive_u_blake2s (salt, salt_len, iterations, b, &hmac, pAbortKeyDerivation);
@@ -805,6 +1037,22 @@ void derive_key_blake2s (const unsigned char *pwd, int pwd_len, const unsigned c
 #endif
 }
 
+#ifndef TC_WINDOWS_BOOT
+void derive_key_blake2s (const unsigned char *pwd, int pwd_len, const unsigned char *salt, int salt_len, uint32 iterations, unsigned char *dk, int dklen, volatile long *pAbortKeyDerivation)
+{
+	derive_key_blake2s_blocks (pwd, pwd_len, salt, salt_len, iterations, dk, dklen, 0, pAbortKeyDerivation);
+}
+
+int derive_key_blake2s_min_blocks (void)
+{
+#ifdef PKCS5_BLAKE2S_MB_AVAILABLE
+	if (HasSAVX2 () && blake2s_mb_has_avx2 ())
+		return BLAKE2S_MB_MIN_BLOCKS;
+#endif
+	return 1;
+}
+#endif
+
 #endif
 
 #ifndef TC_WINDOWS_BOOT
@@ -931,7 +1179,7 @@ static void derive_u_whirlpool (const unsigned char *salt, int salt_len, uint32
 	}
 }
 
-void derive_key_whirlpool (const unsigned char *pwd, int pwd_len, const unsigned char *salt, int salt_len, uint32 iterations, unsigned char *dk, int dklen, volatile long *pAbortKeyDerivation)
+void derive_key_whirlpool_blocks (const unsigned char *pwd, int pwd_len, const unsigned char *salt, int salt_len, uint32 iterations, unsigned char *dk, int dklen, int first_block, volatile long *pAbortKeyDerivation)
 {
 	hmac_whirlpool_ctx hmac;
 	WHIRLPOOL_CTX* ctx;
@@ -989,7 +1237,8 @@ void derive_key_whirlpool (const unsigned char *pwd, int pwd_len, const unsigned
 	WHIRLPOOL_add (buf, WHIRLPOOL_BLOCKSIZE, ctx);
 
 	/* first l - 1 blocks */
-	for (b = 1; b < l; b++)
+	l += first_block;
+	for (b = first_block + 1; b < l; b++)
 	{
 		derive_u_whirlpool (salt, salt_len, iterations, b, &hmac, pAbortKeyDerivation);
 		// Check if the derivation was aborted
@@ -1011,6 +1260,11 @@ void derive_key_whirlpool (const unsigned char *pwd, int pwd_len, const unsigned
 	burn (key, sizeof(key));
 }
 
+void derive_key_whirlpool (const unsigned char *pwd, int pwd_len, const unsigned char *salt, int salt_len, uint32 iterations, unsigned char *dk, int dklen, volatile long *pAbortKeyDerivation)
+{
+	derive_key_whirlpool_blocks (pwd, pwd_len, salt, salt_len, iterations, dk, dklen, 0, pAbortKeyDerivation);
+}
+
 
 typedef struct hmac_streebog_ctx_struct
 {
@@ -1134,7 +1388,7 @@ static void derive_u_streebog (const unsigned char *salt, int salt_len, uint32 i
 	}
 }
 
-void derive_key_streebog (const unsigned char *pwd, int pwd_len, const unsigned char *salt, int salt_len, uint32 iterations, unsigned char *dk, int dklen, volatile long *pAbortKeyDerivation)
+void derive_key_streebog_blocks (const unsigned char *pwd, int pwd_len, const unsigned char *salt, int salt_len, uint32 iterations, unsigned char *dk, int dklen, int first_block, volatile long *pAbortKeyDerivation)
 {
 	hmac_streebog_ctx hmac;
 	STREEBOG_CTX* ctx;
@@ -1192,7 +1446,8 @@ void derive_key_streebog (const unsigned char *pwd, int pwd_len, const unsigned
 	STREEBOG_add (ctx, buf, STREEBOG_BLOCKSIZE);
 
 	/* first l - 1 blocks */
-	for (b = 1; b < l; b++)
+	l += first_block;
+	for (b = first_block + 1; b < l; b++)
 	{
 		derive_u_streebog (salt, salt_len, iterations, b, &hmac, pAbortKeyDerivation);
 		// Check if the derivation was aborted
@@ -1214,6 +1469,11 @@ void derive_key_streebog (const unsigned char *pwd, int pwd_len, const unsigned
 	burn (key, sizeof(key));
 }
 
+void derive_key_streebog (const unsigned char *pwd, int pwd_len, const unsigned char *salt, int salt_len, uint32 iterations, unsigned char *dk, int dklen, volatile long *pAbortKeyDerivation)
+{
+	derive_key_streebog_blocks (pwd, pwd_len, salt, salt_len, iterations, dk, dklen, 0, pAbortKeyDerivation);
+}
+
 wchar_t *get_kdf_name (int kdf_id)
 {
 	switch (kdf_id)
@@ -1317,6 +1577,11 @@ int is_pkcs5_prf_supported (int pkcs5_prf_id, PRF_BOOT_TYPE bootType)
 
 #ifndef VC_DCS_DISABLE_ARGON2
 int derive_key_argon2(const unsigned char *pwd, int pwd_len, const unsigned char *salt, int salt_len, uint32 iterations, uint32 memcost, unsigned char *dk, int dklen, volatile long *pAbortKeyDerivation)
+{
+	return derive_key_argon2_lanes (pwd, pwd_len, salt, salt_len, iterations, memcost, 1, NULL, NULL, NULL, NULL, dk, dklen, pAbortKeyDerivation);
+}
+
+int derive_key_argon2_lanes(const unsigned char *pwd, int pwd_len, const unsigned char *salt, int salt_len, uint32 iterations, uint32 memcost, uint32 lanes, argon2_run_lanes_fptr run_lanes, void *run_lanes_data, allocate_fptr allocate, deallocate_fptr deallocate, unsigned char *dk, int dklen, volatile long *pAbortKeyDerivation)
 {
 	int result;
 #if defined (DEVICE_DRIVER) && !defined(_M_ARM64)
@@ -1325,15 +1590,22 @@ int derive_key_argon2(const unsigned char *pwd, int pwd_len, const unsigned char
 	if (HasSAVX2())
 		saveStatus = KeSaveExtendedProcessorState(XSTATE_MASK_GSSE, &SaveState);
 #endif
-	result = argon2id_hash_raw(
-		iterations, // number of iterations
-		memcost, // memory cost in KiB
-		1, // parallelism factor (number of threads)
-		pwd, pwd_len, // password and its length
-		salt, salt_len, // salt and its length
-		dk, dklen,// derived key and its length
-		pAbortKeyDerivation 
-	);
+	if (lanes < 1)
+		result = ARGON2_LANES_TOO_FEW;
+	else if (lanes > ARGON2_MAX_HEADER_LANES)
+		result = ARGON2_LANES_TOO_MANY;
+	else
+		result = argon2id_hash_raw_lanes(
+			iterations, // number of iterations
+			memcost, // memory cost in KiB
+			lanes, // parallelism factor (number of lanes)
+			pwd, pwd_len, // password and its length
+			salt, salt_len, // salt and its length
+			dk, dklen,// derived key and its length
+			pAbortKeyDerivation,
+			allocate, deallocate, // memory allocator
+			run_lanes, run_lanes_data // lane scheduler
+		);
 	if (0 != result)
 	{
 		// If the Argon2 derivation fails, ensure unchecked legacy callers cannot use stale data.
@@ -15,6 +15,9 @@
 #define TC_HEADER_PKCS5
 
 #include "Tcdefs.h"
+#if !defined (TC_WINDOWS_BOOT) && !defined (VC_DCS_DISABLE_ARGON2)
+#include "argon2.h"
+#endif
 
 #if defined(__cplusplus)
 extern "C"
@@ -22,30 +25,47 @@ extern "C"
 #endif
 
 #ifndef TC_WINDOWS_BOOT
+/* The derive_key_xxx_blocks functions compute the PBKDF2 output blocks following the first first_block ones
+   (which are skipped) and write dklen bytes of them to dk, so that distinct parts of a key can be derived concurrently */
+
 /* output written to input_digest which must be at lease 32 bytes long */
 void hmac_blake2s (unsigned char *key, int keylen, unsigned char *input_digest, int len);
 void derive_key_blake2s (const unsigned char *pwd, int pwd_len, const unsigned char *salt, int salt_len, uint32 iterations, unsigned char *dk, int dklen, long volatile *pAbortKeyDerivation);
+void derive_key_blake2s_blocks (const unsigned char *pwd, int pwd_len, const unsigned char *salt, int salt_len, uint32 iterations, unsigned char *dk, int dklen, int first_block, long volatile *pAbortKeyDerivation);
+/* number of blocks from which derive_key_blake2s_blocks uses a multi-buffer kernel (1 if none is available) */
+int derive_key_blake2s_min_blocks (void);
 
 /* output written to d which must be at lease 32 bytes long */
 void hmac_sha256 (unsigned char *k, int lk, unsigned char *d, int ld);
 void derive_key_sha256 (const unsigned char *pwd, int pwd_len, const unsigned char *salt, int salt_len, uint32 iterations, unsigned char *dk, int dklen, long volatile *pAbortKeyDerivation);
+void derive_key_sha256_blocks (const unsigned char *pwd, int pwd_len, const unsigned char *salt, int salt_len, uint32 iterations, unsigned char *dk, int dklen, int first_block, long volatile *pAbortKeyDerivation);
+/* number of blocks from which derive_key_sha256_blocks uses a multi-buffer kernel (1 if none is available) */
+int derive_key_sha256_min_blocks (void);
 
 /* output written to d which must be at lease 64 bytes long */
 void hmac_sha512 (unsigned char *k, int lk, unsigned char *d, int ld);
 void derive_key_sha512 (const unsigned char *pwd, int pwd_len, const unsigned char *salt, int salt_len, uint32 iterations, unsigned char *dk, int dklen, long volatile *pAbortKeyDerivation);
+void derive_key_sha512_blocks (const unsigned char *pwd, int pwd_len, const unsigned char *salt, int salt_len, uint32 iterations, unsigned char *dk, int dklen, int first_block, long volatile *pAbortKeyDerivation);
+/* number of blocks from which derive_key_sha512_blocks uses a multi-buffer kernel (1 if none is available) */
+int derive_key_sha512_min_blocks (void);
 
 /* output written to d which must be at lease 64 bytes long */
 void hmac_whirlpool (unsigned char *k, int lk, unsigned char *d, int ld);
 void derive_key_whirlpool (const unsigned char *pwd, int pwd_len, const unsigned char *salt, int salt_len, uint32 iterations, unsigned char *dk, int dklen, long volatile *pAbortKeyDerivation);
+void derive_key_whirlpool_blocks (const unsigned char *pwd, int pwd_len, const unsigned char *salt, int salt_len, uint32 iterations, unsigned char *dk, int dklen, int first_block, long volatile *pAbortKeyDerivation);
 
 void hmac_streebog (unsigned char *k, int lk, unsigned char *d, int ld);
 void derive_key_streebog (const unsigned char *pwd, int pwd_len, const unsigned char *salt, int salt_len, uint32 iterations, unsigned char *dk, int dklen, long volatile *pAbortKeyDerivation);
+void derive_key_streebog_blocks (const unsigned char *pwd, int pwd_len, const unsigned char *salt, int salt_len, uint32 iterations, unsigned char *dk, int dklen, int first_block, long volatile *pAbortKeyDerivation);
 
 int get_pkcs5_iteration_count (int pkcs5_prf_id, int pim, BOOL bBoot, int* pMemoryCost);
 wchar_t *get_kdf_name (int kdf_id);
 
 #ifndef VC_DCS_DISABLE_ARGON2
 int derive_key_argon2(const unsigned char *pwd, int pwd_len, const unsigned char *salt, int salt_len, uint32 iterations, uint32 memcost, unsigned char *dk, int dklen, long volatile *pAbortKeyDerivation);
+/* Derives the key on the given number of lanes, the lanes of each slice being filled by run_lanes (sequentially if NULL).
+   The memory is obtained from allocate and released to deallocate after being wiped (TCalloc/TCfree if NULL). */
+int derive_key_argon2_lanes(const unsigned char *pwd, int pwd_len, const unsigned char *salt, int salt_len, uint32 iterations, uint32 memcost, uint32 lanes, argon2_run_lanes_fptr run_lanes, void *run_lanes_data, allocate_fptr allocate, deallocate_fptr deallocate, unsigned char *dk, int dklen, long volatile *pAbortKeyDerivation);
 void get_argon2_params(int pim, int* pIterations, int* pMemcost);
 #endif
 
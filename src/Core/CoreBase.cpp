@@ -14,6 +14,7 @@
 
 #include "CoreBase.h"
 #include "RandomNumberGenerator.h"
+#include "Volume/Argon2Arena.h"
 #include "Volume/Volume.h"
 
 namespace VeraCrypt
@@ -55,6 +56,9 @@ namespace VeraCrypt
 
 		shared_ptr <VolumePassword> password (Keyfile::ApplyListToPassword (newKeyfiles, newPassword, emvSupportEnabled));
 
+		// Header key derivations of all the wipe passes reuse the same Argon2 memory
+		Argon2Arena::Scope argon2Arena;
+
 		bool backupHeader = false;
 		while (true)
 		{
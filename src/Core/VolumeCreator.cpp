@@ -119,20 +119,52 @@ namespace VeraCrypt
 				// Empty sectors are encrypted with different key to randomize plaintext
 				Core->RandomizeEncryptionAlgorithmKey (Options->EA);
 
+				// The next fragment is encrypted while the current one is written
 				SecureBuffer outputBuffer (File::GetOptimalWriteSize());
-				uint64 dataFragmentLength = outputBuffer.Size();
+				SecureBuffer nextOutputBuffer (outputBuffer.Size());
+				SecureBuffer *currentBuffer = &outputBuffer;
+				SecureBuffer *nextBuffer = &nextOutputBuffer;
+				uint64 dataFragmentLength = 0;
 
-				while (!AbortRequested && WriteOffset < endOffset)
+				EncryptionAlgorithm::Request encryptionRequest;
+				// Only an exception can leave a request pending, which still encrypts into one of the buffers. Its
+				// own error is swallowed by the guard in favor of the exception being propagated.
+				finally_do_arg (EncryptionAlgorithm::Request*, &encryptionRequest, { if (*finally_arg) (*finally_arg)->Wait(); });
+
+				while (!AbortRequested)
 				{
-					if (WriteOffset + dataFragmentLength > endOffset)
-						dataFragmentLength = endOffset - WriteOffset;
+					uint64 nextOffset = WriteOffset + dataFragmentLength;
+					uint64 nextFragmentLength = 0;
+
+					if (nextOffset < endOffset)
+					{
+						nextFragmentLength = min ((uint64) nextBuffer->Size(), endOffset - nextOffset);
+						nextBuffer->Zero();
+						encryptionRequest = Options->EA->BeginEncryptSectors (*nextBuffer, nextOffset / ENCRYPTION_DATA_UNIT_SIZE, nextFragmentLength / ENCRYPTION_DATA_UNIT_SIZE, ENCRYPTION_DATA_UNIT_SIZE);
+					}
+
+					if (dataFragmentLength > 0)
+					{
+						VolumeFile->Write (*currentBuffer, (size_t) dataFragmentLength);
 
-					outputBuffer.Zero();
-					Options->EA->EncryptSectors (outputBuffer, WriteOffset / ENCRYPTION_DATA_UNIT_SIZE, dataFragmentLength / ENCRYPTION_DATA_UNIT_SIZE, ENCRYPTION_DATA_UNIT_SIZE);
-					VolumeFile->Write (outputBuffer, (size_t) dataFragmentLength);
+						WriteOffset += dataFragmentLength;
+						SizeDone.Set (WriteOffset - DataStart);
+					}
+
+					if (nextFragmentLength == 0)
+						break;
+
+					encryptionRequest->Wait();
+					encryptionRequest.reset();
 
-					WriteOffset += dataFragmentLength;
-					SizeDone.Set (WriteOffset - DataStart);
+					swap (currentBuffer, nextBuffer);
+					dataFragmentLength = nextFragmentLength;
+				}
+
+				if (encryptionRequest)
+				{
+					encryptionRequest->Wait();
+					encryptionRequest.reset();
 				}
 			}
 
@@ -29,6 +29,12 @@ void VC_CDECL aes_hw_cpu_decrypt_32_blocks (const uint8 *ks, uint8 *data);
 void aes_hw_cpu_encrypt (const uint8 *ks, uint8 *data);
 void VC_CDECL aes_hw_cpu_encrypt_32_blocks (const uint8 *ks, uint8 *data);
 
+/* XTS over blockCount blocks starting at block startBlock of data unit dataUnitNo (VAES/VPCLMULQDQ, x64 only).
+   ks is the primary key schedule for the operation, ks2 the secondary (tweak) encryption key schedule.
+   in and out may point to the same buffer. */
+void aes_hw_vaes_xts_decrypt (const uint8 *ks, const uint8 *ks2, const uint8 *in, uint8 *out, uint64 dataUnitNo, unsigned int startBlock, uint64 blockCount);
+void aes_hw_vaes_xts_encrypt (const uint8 *ks, const uint8 *ks2, const uint8 *in, uint8 *out, uint64 dataUnitNo, unsigned int startBlock, uint64 blockCount);
+
 #if defined(__cplusplus)
 }
 #endif
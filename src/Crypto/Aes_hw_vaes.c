@@ -0,0 +1,209 @@
+/*
+ VeraCrypt source code
+ Copyright (c) 2026 AM Crypto
+
+ This file is part of VeraCrypt and is governed by the Apache License 2.0
+ the full text of which is contained in the file License.txt included in
+ VeraCrypt binary and source code distribution packages.
+*/
+
+/* AES-XTS using VAES and VPCLMULQDQ on 512-bit registers.
+ *
+ * The whitening values of four consecutive blocks are kept in one register and
+ * advanced with a single shift/carry-less multiply per 128-bit lane, so tweak
+ * generation, pre-whitening, encryption and post-whitening are done in one pass
+ * over the data without going through a stack array of whitening values.
+ * The input and output buffers may be the same (in-place operation).
+ *
+ * The key schedules have the layout used by aes_hw_cpu_encrypt/aes_hw_cpu_decrypt
+ * (15 consecutive 128-bit round keys, decryption schedule already reversed).
+ */
+
+#include "Aes_hw_cpu.h"
+#include "Crypto/cpu.h"
+#include "Crypto/misc.h"
+#include "Common/Crypto.h"
+
+#if CRYPTOPP_VAES_AVAILABLE
+
+#include <immintrin.h>
+
+#define AES_XTS_ROUNDS	14
+
+/* Multiplies every 128-bit lane of t by x^n in GF(2^128) (n <= 56). The bits shifted out of the
+   low 64-bit half move into the high half; the ones shifted out of the high half are reduced with
+   the field polynomial x^128 + x^7 + x^2 + x + 1 (0x87). */
+VC_INLINE __m512i xts_mul_x_n (__m512i t, const unsigned int n, __m512i poly, __m512i highMask)
+{
+	__m512i carry = _mm512_srli_epi64 (t, 64 - n);
+	__m512i reduced = _mm512_clmulepi64_epi128 (carry, poly, 0x01);
+	carry = _mm512_and_si512 (_mm512_shuffle_epi32 (carry, _MM_PERM_BADC), highMask);
+	return _mm512_ternarylogic_epi64 (_mm512_slli_epi64 (t, n), reduced, carry, 0x96);
+}
+
+/* Single lane variant used for the data unit tweak seed. */
+VC_INLINE __m128i xts_mul_x (__m128i t)
+{
+	__m128i carry = _mm_srli_epi64 (t, 63);
+	__m128i reduced = _mm_clmulepi64_si128 (carry, _mm_cvtsi32_si128 (0x87), 0x01);
+	carry = _mm_slli_si128 (carry, 8);
+	return _mm_xor_si128 (_mm_xor_si128 (_mm_slli_epi64 (t, 1), reduced), carry);
+}
+
+/* Spreads the whitening value of the first block into four lanes (t, t*x, t*x^2, t*x^3). */
+VC_INLINE __m512i xts_first_tweaks (__m128i t, __m512i poly, __m512i highMask)
+{
+	__m512i tweaks = _mm512_broadcast_i32x4 (t);
+	__m512i carry = _mm512_srlv_epi64 (tweaks, _mm512_set_epi64 (61, 61, 62, 62, 63, 63, 64, 64));
+	__m512i reduced = _mm512_clmulepi64_epi128 (carry, poly, 0x01);
+	carry = _mm512_and_si512 (_mm512_shuffle_epi32 (carry, _MM_PERM_BADC), highMask);
+	return _mm512_ternarylogic_epi64 (_mm512_sllv_epi64 (tweaks, _mm512_set_epi64 (3, 3, 2, 2, 1, 1, 0, 0)), reduced, carry, 0x96);
+}
+
+VC_INLINE __m128i aes_encrypt_block_ni (__m128i b, const uint8 *ks)
+{
+	int round;
+	b = _mm_xor_si128 (b, _mm_loadu_si128 ((const __m128i *) ks));
+	for (round = 1; round < AES_XTS_ROUNDS; ++round)
+		b = _mm_aesenc_si128 (b, _mm_loadu_si128 ((const __m128i *) (ks + 16 * round)));
+	return _mm_aesenclast_si128 (b, _mm_loadu_si128 ((const __m128i *) (ks + 16 * AES_XTS_ROUNDS)));
+}
+
+#define AES_VAES_ROUND(decrypt, b, k) \
+	(b) = (decrypt) ? _mm512_aesdec_epi128 ((b), (k)) : _mm512_aesenc_epi128 ((b), (k))
+
+#define AES_VAES_LAST_ROUND(decrypt, b, k) \
+	(b) = (decrypt) ? _mm512_aesdeclast_epi128 ((b), (k)) : _mm512_aesenclast_epi128 ((b), (k))
+
+VC_INLINE void aes_hw_vaes_xts (const uint8 *ks, const uint8 *ks2, const uint8 *in, uint8 *out, uint64 dataUnitNo, unsigned int startBlock, uint64 blockCount, const int decrypt)
+{
+	const __m512i poly = _mm512_set_epi64 (0, 0x87, 0, 0x87, 0, 0x87, 0, 0x87);
+	const __m512i highMask = _mm512_set_epi64 (-1, 0, -1, 0, -1, 0, -1, 0);
+	__m512i k[AES_XTS_ROUNDS + 1];
+	int round;
+
+	for (round = 0; round <= AES_XTS_ROUNDS; ++round)
+		k[round] = _mm512_broadcast_i32x4 (_mm_loadu_si128 ((const __m128i *) (ks + 16 * round)));
+
+	while (blockCount > 0)
+	{
+		unsigned int count = BLOCKS_PER_XTS_DATA_UNIT - startBlock;
+		unsigned int i;
+		__m128i seed;
+		__m512i t0;
+
+		if (blockCount < count)
+			count = (unsigned int) blockCount;
+
+		// Encrypt the data unit number using the secondary key to obtain the first whitening value
+		seed = aes_encrypt_block_ni (_mm_set_epi64x (0, (long long) dataUnitNo), ks2);
+		for (i = 0; i < startBlock; ++i)
+			seed = xts_mul_x (seed);
+
+		t0 = xts_first_tweaks (seed, poly, highMask);
+
+		blockCount -= count;
+
+		while (count >= 16)
+		{
+			__m512i t1 = xts_mul_x_n (t0, 4, poly, highMask);
+			__m512i t2 = xts_mul_x_n (t0, 8, poly, highMask);
+			__m512i t3 = xts_mul_x_n (t0, 12, poly, highMask);
+
+			__m512i b0 = _mm512_xor_si512 (_mm512_loadu_si512 ((const void *) in), t0);
+			__m512i b1 = _mm512_xor_si512 (_mm512_loadu_si512 ((const void *) (in + 64)), t1);
+			__m512i b2 = _mm512_xor_si512 (_mm512_loadu_si512 ((const void *) (in + 128)), t2);
+			__m512i b3 = _mm512_xor_si512 (_mm512_loadu_si512 ((const void *) (in + 192)), t3);
+
+			b0 = _mm512_xor_si512 (b0, k[0]);
+			b1 = _mm512_xor_si512 (b1, k[0]);
+			b2 = _mm512_xor_si512 (b2, k[0]);
+			b3 = _mm512_xor_si512 (b3, k[0]);
+
+			for (round = 1; round < AES_XTS_ROUNDS; ++round)
+			{
+				AES_VAES_ROUND (decrypt, b0, k[round]);
+				AES_VAES_ROUND (decrypt, b1, k[round]);
+				AES_VAES_ROUND (decrypt, b2, k[round]);
+				AES_VAES_ROUND (decrypt, b3, k[round]);
+			}
+
+			AES_VAES_LAST_ROUND (decrypt, b0, k[AES_XTS_ROUNDS]);
+			AES_VAES_LAST_ROUND (decrypt, b1, k[AES_XTS_ROUNDS]);
+			AES_VAES_LAST_ROUND (decrypt, b2, k[AES_XTS_ROUNDS]);
+			AES_VAES_LAST_ROUND (decrypt, b3, k[AES_XTS_ROUNDS]);
+
+			_mm512_storeu_si512 ((void *) out, _mm512_xor_si512 (b0, t0));
+			_mm512_storeu_si512 ((void *) (out + 64), _mm512_xor_si512 (b1, t1));
+			_mm512_storeu_si512 ((void *) (out + 128), _mm512_xor_si512 (b2, t2));
+			_mm512_storeu_si512 ((void *) (out + 192), _mm512_xor_si512 (b3, t3));
+
+			t0 = xts_mul_x_n (t0, 16, poly, highMask);
+			in += 256;
+			out += 256;
+			count -= 16;
+		}
+
+		while (count >= 4)
+		{
+			__m512i b0 = _mm512_xor_si512 (_mm512_loadu_si512 ((const void *) in), t0);
+
+			b0 = _mm512_xor_si512 (b0, k[0]);
+			for (round = 1; round < AES_XTS_ROUNDS; ++round)
+				AES_VAES_ROUND (decrypt, b0, k[round]);
+			AES_VAES_LAST_ROUND (decrypt, b0, k[AES_XTS_ROUNDS]);
+
+			_mm512_storeu_si512 ((void *) out, _mm512_xor_si512 (b0, t0));
+
+			t0 = xts_mul_x_n (t0, 4, poly, highMask);
+			in += 64;
+			out += 64;
+			count -= 4;
+		}
+
+		if (count > 0)
+		{
+			// Fewer than four blocks remain in this data unit: the lanes of t0 hold their whitening values
+			CRYPTOPP_ALIGN_DATA(64) uint8 tweaks[64];
+			_mm512_store_si512 ((void *) tweaks, t0);
+
+			for (i = 0; i < count; ++i)
+			{
+				__m128i t = _mm_load_si128 ((const __m128i *) (tweaks + 16 * i));
+				__m128i b = _mm_xor_si128 (_mm_loadu_si128 ((const __m128i *) in), t);
+
+				b = _mm_xor_si128 (b, _mm_loadu_si128 ((const __m128i *) ks));
+				for (round = 1; round < AES_XTS_ROUNDS; ++round)
+				{
+					__m128i rk = _mm_loadu_si128 ((const __m128i *) (ks + 16 * round));
+					b = decrypt ? _mm_aesdec_si128 (b, rk) : _mm_aesenc_si128 (b, rk);
+				}
+
+				b = decrypt
+					? _mm_aesdeclast_si128 (b, _mm_loadu_si128 ((const __m128i *) (ks + 16 * AES_XTS_ROUNDS)))
+					: _mm_aesenclast_si128 (b, _mm_loadu_si128 ((const __m128i *) (ks + 16 * AES_XTS_ROUNDS)));
+
+				_mm_storeu_si128 ((__m128i *) out, _mm_xor_si128 (b, t));
+				in += 16;
+				out += 16;
+			}
+
+			burn (tweaks, sizeof (tweaks));
+		}
+
+		startBlock = 0;
+		dataUnitNo++;
+	}
+}
+
+void aes_hw_vaes_xts_encrypt (const uint8 *ks, const uint8 *ks2, const uint8 *in, uint8 *out, uint64 dataUnitNo, unsigned int startBlock, uint64 blockCount)
+{
+	aes_hw_vaes_xts (ks, ks2, in, out, dataUnitNo, startBlock, blockCount, 0);
+}
+
+void aes_hw_vaes_xts_decrypt (const uint8 *ks, const uint8 *ks2, const uint8 *in, uint8 *out, uint64 dataUnitNo, unsigned int startBlock, uint64 blockCount)
+{
+	aes_hw_vaes_xts (ks, ks2, in, out, dataUnitNo, startBlock, blockCount, 1);
+}
+
+#endif // CRYPTOPP_VAES_AVAILABLE
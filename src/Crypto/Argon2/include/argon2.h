@@ -174,6 +174,17 @@ typedef enum Argon2_ErrorCodes {
 typedef int (*allocate_fptr)(uint8_t **memory, size_t bytes_to_allocate);
 typedef void (*deallocate_fptr)(uint8_t *memory, size_t bytes_to_allocate);
 
+/* Lane scheduler type --- for filling the lanes of a slice on external threads.
+ * The scheduler calls fill_lane(lane_data, lane) once for each lane from 0 to
+ * lanes - 1, in any order and possibly concurrently since the lanes of a slice
+ * are independent, and returns when all of them have completed. It returns
+ * ARGON2_OK or one of the error codes returned by fill_lane.
+ */
+typedef int (*argon2_fill_lane_fptr)(void *lane_data, uint32_t lane);
+typedef int (*argon2_run_lanes_fptr)(argon2_fill_lane_fptr fill_lane,
+                                     void *lane_data, uint32_t lanes,
+                                     void *scheduler_data);
+
 /* Argon2 external data structures */
 
 /*
@@ -227,6 +238,10 @@ typedef struct Argon2_Context {
     /* Cancellation token for VeraCrypt */
     long volatile *pAbortKeyDerivation;
 
+    /* Lane scheduler for VeraCrypt (if NULL, lanes are filled one after the other) */
+    argon2_run_lanes_fptr run_lanes_cbk;
+    void *run_lanes_data;
+
     allocate_fptr allocate_cbk; /* pointer to memory allocator */
     deallocate_fptr free_cbk;   /* pointer to memory deallocator */
 
@@ -295,6 +310,26 @@ ARGON2_PUBLIC int argon2id_hash_raw(const uint32_t t_cost,
                                     const size_t saltlen, void *hash,
                                     const size_t hashlen, long volatile *pAbortKeyDerivation);
 
+/**
+ * Hashes a password with Argon2id using the given number of lanes, the lanes
+ * of each slice being filled by run_lanes_cbk (sequentially if NULL)
+ * @param allocate_cbk Memory allocator (internal allocation if NULL)
+ * @param free_cbk Memory deallocator, given if and only if allocate_cbk is
+ * @param run_lanes_cbk Lane scheduler
+ * @param run_lanes_data Data passed to the lane scheduler
+ * @pre   Same as argon2id_hash_raw with parallelism set to lanes
+ */
+ARGON2_PUBLIC int argon2id_hash_raw_lanes(const uint32_t t_cost,
+                                          const uint32_t m_cost,
+                                          const uint32_t lanes, const void *pwd,
+                                          const size_t pwdlen, const void *salt,
+                                          const size_t saltlen, void *hash,
+                                          const size_t hashlen, long volatile *pAbortKeyDerivation,
+                                          allocate_fptr allocate_cbk,
+                                          deallocate_fptr free_cbk,
+                                          argon2_run_lanes_fptr run_lanes_cbk,
+                                          void *run_lanes_data);
+
 /* generic function underlying the above ones */
 ARGON2_PUBLIC int argon2_hash(const uint32_t t_cost, const uint32_t m_cost,
                               const uint32_t parallelism, const void *pwd,
@@ -232,6 +232,45 @@ static int fill_memory_blocks_st(argon2_instance_t *instance) {
     return ARGON2_OK;
 }
 
+/* Slice handed to the lane scheduler of the context */
+typedef struct Argon2_slice_t {
+    argon2_instance_t *instance;
+    uint32_t pass;
+    uint8_t slice;
+} argon2_slice_t;
+
+static int fill_slice_lane(void *lane_data, uint32_t lane) {
+    argon2_slice_t *slice = (argon2_slice_t *)lane_data;
+    argon2_position_t position = {slice->pass, lane, slice->slice, 0};
+    return fill_segment(slice->instance, position);
+}
+
+/* Version for p > 1 with the lanes of each slice filled by the scheduler of the context */
+static int fill_memory_blocks_scheduled(argon2_instance_t *instance) {
+    argon2_context *context = instance->context_ptr;
+    argon2_slice_t slice;
+    uint32_t r, s;
+    int result;
+
+    slice.instance = instance;
+    for (r = 0; r < instance->passes; ++r) {
+        for (s = 0; s < ARGON2_SYNC_POINTS; ++s) {
+            slice.pass = r;
+            slice.slice = (uint8_t)s;
+            result = context->run_lanes_cbk(&fill_slice_lane, &slice,
+                                            instance->lanes,
+                                            context->run_lanes_data);
+            if (result != ARGON2_OK) {
+                return result;
+            }
+        }
+#ifdef GENKAT
+        internal_kat(instance, r); /* Print all memory blocks */
+#endif
+    }
+    return ARGON2_OK;
+}
+
 #if !defined(ARGON2_NO_THREADS)
 
 #ifdef _WIN32
@@ -335,6 +374,9 @@ int fill_memory_blocks(argon2_instance_t *instance) {
 	if (instance == NULL || instance->lanes == 0) {
 	    return ARGON2_INCORRECT_PARAMETER;
     }
+    if (instance->lanes > 1 && instance->context_ptr->run_lanes_cbk != NULL) {
+        return fill_memory_blocks_scheduled(instance);
+    }
 #if defined(ARGON2_NO_THREADS)
     return fill_memory_blocks_st(instance);
 #else
@@ -208,8 +208,21 @@ extern int fill_segment_avx2(const argon2_instance_t* instance,
 	argon2_position_t position);
 #endif
 
+#if CRYPTOPP_BOOL_X64 && !defined(CRYPTOPP_DISABLE_ASM) && !defined(TC_WINDOWS_DRIVER) && !defined(_UEFI)
+#define ARGON2_AVX512_AVAILABLE
+extern int argon2_has_avx512();
+extern int fill_segment_avx512(const argon2_instance_t* instance,
+	argon2_position_t position);
+#endif
+
 int fill_segment(const argon2_instance_t* instance,
     argon2_position_t position) {
+#ifdef ARGON2_AVX512_AVAILABLE
+	if (HasAVX512F() && argon2_has_avx512())
+	{
+		return fill_segment_avx512(instance, position);
+	}
+#endif
 #if CRYPTOPP_BOOL_X64 || CRYPTOPP_BOOL_X86 || CRYPTOPP_BOOL_X32
 	if (HasSAVX2())
 	{
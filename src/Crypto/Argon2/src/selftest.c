@@ -93,6 +93,8 @@ static int argon2_selftest_ctx (void)
    context.flags = ARGON2_DEFAULT_FLAGS;
    context.version = ARGON2_VERSION_13;
    context.pAbortKeyDerivation = NULL; /* No abort function */
+   context.run_lanes_cbk = NULL;       /* Lanes filled sequentially */
+   context.run_lanes_data = NULL;
 
    /* Test execution for Argon2d, Argon2i, Argon2id */
 
@@ -58,6 +58,13 @@ void camellia_dec_blk2(const uint8 *ctx, uint8 *dst, const uint8 *src);
 void camellia_ecb_enc_16way(const uint8 *ctx, uint8 *dst, const uint8 *src);
 void camellia_ecb_dec_16way(const uint8 *ctx, uint8 *dst, const uint8 *src);
 
+#if !defined (TC_WINDOWS_DRIVER) && !defined (_UEFI)
+#define CAMELLIA_GFNI_AVAILABLE
+int camellia_has_gfni ();
+void camellia_gfni_encrypt_blocks_32 (const uint8 *ks, const uint8 *in_blk, uint8 *out_blk);
+void camellia_gfni_decrypt_blocks_32 (const uint8 *ks, const uint8 *in_blk, uint8 *out_blk);
+#endif
+
 /* key constants */
 
 #define CAMELLIA_SIGMA1L (0xA09E667FL)
@@ -1095,6 +1102,19 @@ void camellia_decrypt(const unsigned __int8 *inBlock,  unsigned __int8 *outBlock
 
 void camellia_encrypt_blocks(unsigned __int8 *instance, const uint8* in_blk, uint8* out_blk, uint32 blockCount)
 {
+#ifdef CAMELLIA_GFNI_AVAILABLE
+	if ((blockCount >= 32) && HasAVX512BW() && HasGFNI() && camellia_has_gfni())
+	{
+		while (blockCount >= 32)
+		{
+			camellia_gfni_encrypt_blocks_32 (instance, in_blk, out_blk);
+			out_blk += 32 * 16;
+			in_blk += 32 * 16;
+			blockCount -= 32;
+		}
+	}
+#endif
+
 #if !defined (_UEFI)
 	if ((blockCount >= 16) && IsCpuIntel() && IsAesHwCpuSupported () && HasSAVX() && HasSSSE3()) /* on AMD cpu, AVX is too slow */
 	{
@@ -1131,6 +1151,19 @@ void camellia_encrypt_blocks(unsigned __int8 *instance, const uint8* in_blk, uin
 
 void camellia_decrypt_blocks(unsigned __int8 *instance, const uint8* in_blk, uint8* out_blk, uint32 blockCount)
 {
+#ifdef CAMELLIA_GFNI_AVAILABLE
+	if ((blockCount >= 32) && HasAVX512BW() && HasGFNI() && camellia_has_gfni())
+	{
+		while (blockCount >= 32)
+		{
+			camellia_gfni_decrypt_blocks_32 (instance, in_blk, out_blk);
+			out_blk += 32 * 16;
+			in_blk += 32 * 16;
+			blockCount -= 32;
+		}
+	}
+#endif
+
 #if !defined (_UEFI)
 	if ((blockCount >= 16) && IsCpuIntel() && IsAesHwCpuSupported () && HasSAVX() && HasSSSE3()) /* on AMD cpu, AVX is too slow */
 	{
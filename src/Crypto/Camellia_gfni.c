@@ -0,0 +1,201 @@
+/*
+ VeraCrypt source code
+ Copyright (c) 2026 AM Crypto
+
+ This file is part of VeraCrypt and is governed by the Apache License 2.0
+ the full text of which is contained in the file License.txt included in
+ VeraCrypt binary and source code distribution packages.
+*/
+
+/* Camellia processing 32 blocks in parallel using AVX-512 and GFNI.
+ *
+ * Each group of 8 blocks is held in two registers: one with the left 64-bit halves and one
+ * with the right halves, as big-endian words. Camellia's s1 is affine equivalent to the
+ * inversion in GF(2^8), so the S-boxes are evaluated on all 64 bytes of a register with an
+ * affine pre-filter (GF2P8AFFINEQB) followed by an inversion with an affine post-filter
+ * (GF2P8AFFINEINVQB). s2, s3 and s4 are bit rotations of s1 which are folded into the filter
+ * matrices and merged under byte masks.
+ *
+ * The key schedule is the one produced by camellia_set_key for the x64 assembly: whitening
+ * keys are absorbed into the round keys and the round key is XORed at the end of F.
+ */
+
+#include "Camellia.h"
+#include "Crypto/cpu.h"
+#include "Crypto/misc.h"
+
+#if CRYPTOPP_BOOL_X64 && !defined(CRYPTOPP_DISABLE_ASM) && defined(__AVX512BW__) && (defined(__GFNI__) || defined(_MSC_VER))
+
+#include <immintrin.h>
+
+/* s1(x) = POST_S1 * inv(PRE * x + 0x45) + 0x6e; the s4 pre-filter includes the rotation of
+   its input and the s2/s3 post-filters the rotation of their output */
+#define CAMELLIA_GFNI_PRE		0xb74c0bcd30253461ULL
+#define CAMELLIA_GFNI_PRE_S4	0xdb2685e618921ab0ULL
+#define CAMELLIA_GFNI_POST_S1	0x80667dd8717afe38ULL
+#define CAMELLIA_GFNI_POST_S2	0x3880667dd8717afeULL
+#define CAMELLIA_GFNI_POST_S3	0x667dd8717afe3880ULL
+
+/* Positions of the bytes going through s2, s3 and s4 in each 64-bit half (t1 is the most
+   significant byte: s1 t1, s2 t2, s3 t3, s4 t4, s2 t5, s3 t6, s4 t7, s1 t8) */
+#define CAMELLIA_GFNI_S2_MASK	0x4848484848484848ULL
+#define CAMELLIA_GFNI_S3_MASK	0x2424242424242424ULL
+#define CAMELLIA_GFNI_S4_MASK	0x1212121212121212ULL
+
+/* Masks selecting the most and least significant 32-bit word of each 64-bit half */
+#define CAMELLIA_GFNI_HI32		0xAAAA
+#define CAMELLIA_GFNI_LO32		0x5555
+
+#define CAMELLIA_GFNI_SWAP32(x)	_mm512_shuffle_epi32 ((x), _MM_PERM_CDAB)
+
+#define CAMELLIA_GFNI_KEY(ks, i)	_mm512_set1_epi64 ((long long) (((uint64) (ks)[2 * (i)] << 32) | (ks)[2 * (i) + 1]))
+
+/* F-function without the key XOR: P (S (x)) */
+VC_INLINE __m512i camellia_gfni_f (__m512i x)
+{
+	__m512i t, y, s, u;
+
+	/* S-function */
+	t = _mm512_gf2p8affine_epi64_epi8 (x, _mm512_set1_epi64 ((long long) CAMELLIA_GFNI_PRE), 0x45);
+	t = _mm512_mask_gf2p8affine_epi64_epi8 (t, CAMELLIA_GFNI_S4_MASK, x, _mm512_set1_epi64 ((long long) CAMELLIA_GFNI_PRE_S4), 0x45);
+	y = _mm512_gf2p8affineinv_epi64_epi8 (t, _mm512_set1_epi64 ((long long) CAMELLIA_GFNI_POST_S1), 0x6e);
+	y = _mm512_mask_gf2p8affineinv_epi64_epi8 (y, CAMELLIA_GFNI_S2_MASK, t, _mm512_set1_epi64 ((long long) CAMELLIA_GFNI_POST_S2), 0xdc);
+	y = _mm512_mask_gf2p8affineinv_epi64_epi8 (y, CAMELLIA_GFNI_S3_MASK, t, _mm512_set1_epi64 ((long long) CAMELLIA_GFNI_POST_S3), 0x37);
+
+	/* P-function. With y = (a, b) as 32-bit words and S(w) the XOR of the four bytes of w
+	   replicated in each byte:
+	     il = S(a) ^ rol(a, 8), ir = S(b) ^ b
+	     z = (il ^ ir, il ^ ir ^ ror(il, 8)) */
+	s = _mm512_xor_si512 (y, _mm512_rol_epi32 (y, 16));
+	s = _mm512_xor_si512 (s, _mm512_rol_epi32 (s, 8));
+	t = _mm512_mask_xor_epi32 (_mm512_xor_si512 (s, y), CAMELLIA_GFNI_HI32, s, _mm512_rol_epi32 (y, 8));
+	u = CAMELLIA_GFNI_SWAP32 (t);
+	y = _mm512_xor_si512 (t, u);
+	return _mm512_mask_xor_epi32 (y, CAMELLIA_GFNI_LO32, y, _mm512_ror_epi32 (u, 8));
+}
+
+/* dst ^= F (src) ^ k for the four groups */
+#define CAMELLIA_GFNI_ROUND(dst, src, ks, i) \
+	k = CAMELLIA_GFNI_KEY (ks, i); \
+	dst##0 = _mm512_ternarylogic_epi64 (dst##0, camellia_gfni_f (src##0), k, 0x96); \
+	dst##1 = _mm512_ternarylogic_epi64 (dst##1, camellia_gfni_f (src##1), k, 0x96); \
+	dst##2 = _mm512_ternarylogic_epi64 (dst##2, camellia_gfni_f (src##2), k, 0x96); \
+	dst##3 = _mm512_ternarylogic_epi64 (dst##3, camellia_gfni_f (src##3), k, 0x96);
+
+/* FL applied to the left halves and FL^-1 to the right halves */
+VC_INLINE void camellia_gfni_fls (__m512i *l, __m512i *r, __m512i kl, __m512i kr)
+{
+	__m512i t;
+
+	/* FL: lr ^= rol (ll & kll, 1); ll ^= (lr | klr) */
+	t = _mm512_rol_epi32 (_mm512_and_si512 (*l, kl), 1);
+	*l = _mm512_mask_xor_epi32 (*l, CAMELLIA_GFNI_LO32, *l, CAMELLIA_GFNI_SWAP32 (t));
+	t = _mm512_or_si512 (*l, kl);
+	*l = _mm512_mask_xor_epi32 (*l, CAMELLIA_GFNI_HI32, *l, CAMELLIA_GFNI_SWAP32 (t));
+
+	/* FL^-1: rl ^= (rr | krr); rr ^= rol (rl & krl, 1) */
+	t = _mm512_or_si512 (*r, kr);
+	*r = _mm512_mask_xor_epi32 (*r, CAMELLIA_GFNI_HI32, *r, CAMELLIA_GFNI_SWAP32 (t));
+	t = _mm512_rol_epi32 (_mm512_and_si512 (*r, kr), 1);
+	*r = _mm512_mask_xor_epi32 (*r, CAMELLIA_GFNI_LO32, *r, CAMELLIA_GFNI_SWAP32 (t));
+}
+
+/* Loads 8 blocks and splits them into left and right halves */
+VC_INLINE void camellia_gfni_load (const uint8 *in, __m512i bswap, __m512i *l, __m512i *r)
+{
+	__m512i a = _mm512_shuffle_epi8 (_mm512_loadu_si512 ((const void *) in), bswap);
+	__m512i b = _mm512_shuffle_epi8 (_mm512_loadu_si512 ((const void *) (in + 64)), bswap);
+	*l = _mm512_unpacklo_epi64 (a, b);
+	*r = _mm512_unpackhi_epi64 (a, b);
+}
+
+/* Stores 8 blocks, swapping the halves as required after the last round */
+VC_INLINE void camellia_gfni_store (uint8 *out, __m512i bswap, __m512i l, __m512i r)
+{
+	_mm512_storeu_si512 ((void *) out, _mm512_shuffle_epi8 (_mm512_unpacklo_epi64 (r, l), bswap));
+	_mm512_storeu_si512 ((void *) (out + 64), _mm512_shuffle_epi8 (_mm512_unpackhi_epi64 (r, l), bswap));
+}
+
+VC_INLINE void camellia_gfni_crypt_32 (const uint32 *ks, const uint8 *in_blk, uint8 *out_blk, const int decrypt)
+{
+	const __m512i bswap = _mm512_broadcast_i32x4 (_mm_set_epi8 (8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7));
+	__m512i l0, l1, l2, l3, r0, r1, r2, r3, k;
+	int segment, round;
+
+	camellia_gfni_load (in_blk, bswap, &l0, &r0);
+	camellia_gfni_load (in_blk + 128, bswap, &l1, &r1);
+	camellia_gfni_load (in_blk + 256, bswap, &l2, &r2);
+	camellia_gfni_load (in_blk + 384, bswap, &l3, &r3);
+
+	k = CAMELLIA_GFNI_KEY (ks, decrypt ? 32 : 0);
+	l0 = _mm512_xor_si512 (l0, k);
+	l1 = _mm512_xor_si512 (l1, k);
+	l2 = _mm512_xor_si512 (l2, k);
+	l3 = _mm512_xor_si512 (l3, k);
+
+	// Four groups of six rounds separated by FL/FL^-1 layers, round keys 2..31
+	for (segment = 0; segment < 4; ++segment)
+	{
+		const int base = decrypt ? 8 * (3 - segment) : 8 * segment;
+
+		for (round = 0; round < 6; round += 2)
+		{
+			CAMELLIA_GFNI_ROUND (r, l, ks, decrypt ? base + 7 - round : base + 2 + round);
+			CAMELLIA_GFNI_ROUND (l, r, ks, decrypt ? base + 6 - round : base + 3 + round);
+		}
+
+		if (segment < 3)
+		{
+			__m512i kl = CAMELLIA_GFNI_KEY (ks, decrypt ? base + 1 : base + 8);
+			__m512i kr = CAMELLIA_GFNI_KEY (ks, decrypt ? base : base + 9);
+
+			camellia_gfni_fls (&l0, &r0, kl, kr);
+			camellia_gfni_fls (&l1, &r1, kl, kr);
+			camellia_gfni_fls (&l2, &r2, kl, kr);
+			camellia_gfni_fls (&l3, &r3, kl, kr);
+		}
+	}
+
+	k = CAMELLIA_GFNI_KEY (ks, decrypt ? 0 : 32);
+	r0 = _mm512_xor_si512 (r0, k);
+	r1 = _mm512_xor_si512 (r1, k);
+	r2 = _mm512_xor_si512 (r2, k);
+	r3 = _mm512_xor_si512 (r3, k);
+
+	camellia_gfni_store (out_blk, bswap, l0, r0);
+	camellia_gfni_store (out_blk + 128, bswap, l1, r1);
+	camellia_gfni_store (out_blk + 256, bswap, l2, r2);
+	camellia_gfni_store (out_blk + 384, bswap, l3, r3);
+}
+
+int camellia_has_gfni ()
+{
+	return 1;
+}
+
+void camellia_gfni_encrypt_blocks_32 (const uint8 *ks, const uint8 *in_blk, uint8 *out_blk)
+{
+	camellia_gfni_crypt_32 ((const uint32 *) ks, in_blk, out_blk, 0);
+}
+
+void camellia_gfni_decrypt_blocks_32 (const uint8 *ks, const uint8 *in_blk, uint8 *out_blk)
+{
+	camellia_gfni_crypt_32 ((const uint32 *) ks, in_blk, out_blk, 1);
+}
+
+#else
+
+int camellia_has_gfni ()
+{
+	return 0;
+}
+
+void camellia_gfni_encrypt_blocks_32 (const uint8 *ks, const uint8 *in_blk, uint8 *out_blk)
+{
+}
+
+void camellia_gfni_decrypt_blocks_32 (const uint8 *ks, const uint8 *in_blk, uint8 *out_blk)
+{
+}
+
+#endif
@@ -0,0 +1,319 @@
+/*
+ VeraCrypt source code
+ Copyright (c) 2026 AM Crypto
+
+ This file is part of VeraCrypt and is governed by the Apache License 2.0
+ the full text of which is contained in the file License.txt included in
+ VeraCrypt binary and source code distribution packages.
+*/
+
+/* Registry of the implementations available for each primitive.
+ *
+ * Each primitive has a table of candidate kernels in order of preference, each one with the
+ * function telling whether it can be used on this host. The conditions are the ones checked
+ * by the dispatch code of the primitive (the multi-block kernels are reported by the widest
+ * one, which is used as soon as enough blocks are processed at once). The last candidate is
+ * the portable implementation, which is always available.
+ */
+
+#include "Kernels.h"
+#include "Crypto/cpu.h"
+#include "Crypto/misc.h"
+
+extern int IsAesHwCpuSupported ();
+
+#if defined(_UEFI) || defined(CRYPTOPP_DISABLE_ASM)
+#define NO_OPTIMIZED_VERSIONS
+#endif
+
+typedef struct
+{
+	const char *Name;
+	int (*IsAvailable) ();	// NULL for the portable implementation
+} CryptoKernelCandidate;
+
+typedef struct
+{
+	const char *Primitive;
+	const CryptoKernelCandidate *Candidates;
+} CryptoKernelClass;
+
+static int AesHwAvailable ()
+{
+	return IsAesHwCpuSupported () ? 1 : 0;
+}
+
+#if CRYPTOPP_BOOL_X86 || CRYPTOPP_BOOL_X32 || CRYPTOPP_BOOL_X64
+
+int serpent_simd_has_avx2 ();
+int serpent_simd_has_avx512 ();
+int twofish_has_avx2 ();
+int camellia_has_gfni ();
+int kuznyechik_has_gfni ();
+int blake2s_has_sse2 ();
+int blake2s_has_ssse3 ();
+int blake2s_has_sse41 ();
+int sha2_mb_has_avx2 ();
+int blake2s_mb_has_avx2 ();
+int whirlpool_has_avx2 ();
+int argon2_has_avx512 ();
+int sm4_aesni_available ();
+int sm4_gfni_available ();
+
+static int AesXtsVaesAvailable ()	{ return IsAesHwCpuSupported () && HasAVX512F () && HasVAES () && HasVPCLMULQDQ (); }
+static int SerpentAvx512Available ()	{ return HasAVX512F () && serpent_simd_has_avx512 (); }
+static int SerpentAvx2Available ()	{ return HasSAVX2 () && serpent_simd_has_avx2 (); }
+static int Sse2Available ()			{ return HasSSE2 (); }
+static int Sse41Available ()		{ return HasSSE41 (); }
+static int Avx2Available ()			{ return HasSAVX2 (); }
+static int TwofishAvx2Available ()	{ return HasSAVX2 () && twofish_has_avx2 (); }
+static int CamelliaGfniAvailable ()	{ return HasAVX512BW () && HasGFNI () && camellia_has_gfni (); }
+static int CamelliaAesniAvailable ()	{ return IsCpuIntel () && IsAesHwCpuSupported () && HasSAVX () && HasSSSE3 (); }
+static int KuznyechikGfniAvailable ()	{ return HasAVX512VBMI () && HasGFNI () && kuznyechik_has_gfni (); }
+static int ShaNiAvailable ()		{ return HasSHA256 (); }
+static int ShaIntelAvx2Available ()	{ return IsCpuIntel () && HasSAVX2 () && HasSBMI2 (); }
+static int ShaIntelAvxAvailable ()	{ return IsCpuIntel () && HasSAVX (); }
+static int Blake2sSse41Available ()	{ return HasSSE2 () && blake2s_has_sse2 () && HasSSE41 () && blake2s_has_sse41 (); }
+static int Blake2sSsse3Available ()	{ return HasSSE2 () && blake2s_has_sse2 () && HasSSSE3 () && blake2s_has_ssse3 (); }
+static int Blake2sSse2Available ()	{ return HasSSE2 () && blake2s_has_sse2 (); }
+static int WhirlpoolSse2Available ()	{ return HasISSE (); }
+static int Sha2MbAvx2Available ()	{ return HasSAVX2 () && sha2_mb_has_avx2 (); }
+static int Blake2sMbAvx2Available ()	{ return HasSAVX2 () && blake2s_mb_has_avx2 (); }
+static int WhirlpoolAvx2Available ()	{ return HasSAVX2 () && whirlpool_has_avx2 (); }
+static int Argon2Avx512Available ()	{ return HasAVX512F () && argon2_has_avx512 (); }
+#if !CRYPTOPP_BOOL_X64
+static int Sha512Ssse3Available ()	{ return HasSSSE3 () && HasMMX (); }
+#endif
+
+#elif CRYPTOPP_BOOL_ARMV8
+
+static int ShaArmAvailable ()		{ return HasSHA256 (); }
+
+#endif
+
+static const CryptoKernelCandidate AesKernels[] =
+{
+#if CRYPTOPP_BOOL_X86 || CRYPTOPP_BOOL_X32 || CRYPTOPP_BOOL_X64
+	{ "AES-NI", AesHwAvailable },
+#elif CRYPTOPP_BOOL_ARMV8
+	{ "ARMv8 Crypto Extensions", AesHwAvailable },
+#endif
+	{ "generic", NULL }
+};
+
+static const CryptoKernelCandidate AesXtsKernels[] =
+{
+#if (CRYPTOPP_BOOL_X86 || CRYPTOPP_BOOL_X32 || CRYPTOPP_BOOL_X64) && CRYPTOPP_VAES_AVAILABLE
+	{ "VAES/VPCLMULQDQ (16 blocks)", AesXtsVaesAvailable },
+#endif
+	{ "generic", NULL }
+};
+
+static const CryptoKernelCandidate SerpentKernels[] =
+{
+#if (CRYPTOPP_BOOL_X86 || CRYPTOPP_BOOL_X32 || CRYPTOPP_BOOL_X64) && CRYPTOPP_BOOL_SSE2_INTRINSICS_AVAILABLE
+	{ "AVX-512 (16 blocks)", SerpentAvx512Available },
+	{ "AVX2 (8 blocks)", SerpentAvx2Available },
+	{ "SSE2 (4 blocks)", Sse2Available },
+#endif
+	{ "generic", NULL }
+};
+
+static const CryptoKernelCandidate TwofishKernels[] =
+{
+#if CRYPTOPP_BOOL_X64 && !defined(CRYPTOPP_DISABLE_ASM)
+	{ "AVX2 (16 blocks)", TwofishAvx2Available },
+	{ "x86-64 assembly", NULL },
+#endif
+	{ "generic", NULL }
+};
+
+static const CryptoKernelCandidate CamelliaKernels[] =
+{
+#if CRYPTOPP_BOOL_X64 && !defined(CRYPTOPP_DISABLE_ASM)
+	{ "AVX-512/GFNI (32 blocks)", CamelliaGfniAvailable },
+	{ "AES-NI/AVX (16 blocks)", CamelliaAesniAvailable },
+	{ "x86-64 assembly", NULL },
+#endif
+	{ "generic", NULL }
+};
+
+static const CryptoKernelCandidate KuznyechikKernels[] =
+{
+#if (CRYPTOPP_BOOL_X86 || CRYPTOPP_BOOL_X32 || CRYPTOPP_BOOL_X64) && CRYPTOPP_BOOL_SSE2_INTRINSICS_AVAILABLE
+	{ "AVX-512/GFNI (64 blocks)", KuznyechikGfniAvailable },
+	{ "SSE2", Sse2Available },
+#endif
+	{ "generic", NULL }
+};
+
+static const CryptoKernelCandidate Sm4Kernels[] =
+{
+#if CRYPTOPP_BOOL_X86 || CRYPTOPP_BOOL_X32 || CRYPTOPP_BOOL_X64
+	{ "AVX2/GFNI (16 blocks)", sm4_gfni_available },
+	{ "AES-NI (8 blocks)", sm4_aesni_available },
+#endif
+	{ "generic", NULL }
+};
+
+static const CryptoKernelCandidate Sha256Kernels[] =
+{
+#ifndef NO_OPTIMIZED_VERSIONS
+#if CRYPTOPP_BOOL_X64
+#if CRYPTOPP_SHANI_AVAILABLE
+	{ "SHA-NI", ShaNiAvailable },
+#endif
+	{ "AVX2/BMI2", ShaIntelAvx2Available },
+	{ "AVX", ShaIntelAvxAvailable },
+	{ "SSE4.1", Sse41Available },
+#endif
+#if (defined(CRYPTOPP_X86_ASM_AVAILABLE) || defined(CRYPTOPP_X32_ASM_AVAILABLE))
+	{ "SSE2 assembly", Sse2Available },
+#endif
+#if CRYPTOPP_ARM_SHA2_AVAILABLE
+	{ "ARMv8 Crypto Extensions", ShaArmAvailable },
+#endif
+#if CRYPTOPP_BOOL_X86 || CRYPTOPP_BOOL_X32
+	{ "x86 assembly", NULL },
+#endif
+#endif
+	{ "generic", NULL }
+};
+
+static const CryptoKernelCandidate Sha512Kernels[] =
+{
+#ifndef NO_OPTIMIZED_VERSIONS
+#if CRYPTOPP_BOOL_X64
+	{ "AVX2/BMI2", ShaIntelAvx2Available },
+	{ "AVX", ShaIntelAvxAvailable },
+	{ "SSE4.1", Sse41Available },
+	{ "x86-64 assembly", Sse2Available },
+#elif (CRYPTOPP_BOOL_X86 || CRYPTOPP_BOOL_X32) && !defined (TC_MACOSX)
+	{ "SSSE3 assembly", Sha512Ssse3Available },
+#endif
+#endif
+	{ "generic", NULL }
+};
+
+/* PBKDF2 output blocks derived together, used when enough of them are requested at once */
+static const CryptoKernelCandidate Pbkdf2Sha256Kernels[] =
+{
+#if CRYPTOPP_BOOL_X64 && !defined(CRYPTOPP_DISABLE_ASM)
+	{ "AVX2 (8 chains)", Sha2MbAvx2Available },
+#endif
+	{ "single chain", NULL }
+};
+
+static const CryptoKernelCandidate Pbkdf2Sha512Kernels[] =
+{
+#if CRYPTOPP_BOOL_X64 && !defined(CRYPTOPP_DISABLE_ASM)
+	{ "AVX2 (4 chains)", Sha2MbAvx2Available },
+#endif
+	{ "single chain", NULL }
+};
+
+static const CryptoKernelCandidate Pbkdf2Blake2sKernels[] =
+{
+#if CRYPTOPP_BOOL_X64 && !defined(CRYPTOPP_DISABLE_ASM)
+	{ "AVX2 (8 chains)", Blake2sMbAvx2Available },
+#endif
+	{ "single chain", NULL }
+};
+
+static const CryptoKernelCandidate Blake2sKernels[] =
+{
+#if (CRYPTOPP_BOOL_X86 || CRYPTOPP_BOOL_X32 || CRYPTOPP_BOOL_X64) && CRYPTOPP_BOOL_SSE2_INTRINSICS_AVAILABLE
+	{ "SSE4.1", Blake2sSse41Available },
+	{ "SSSE3", Blake2sSsse3Available },
+	{ "SSE2", Blake2sSse2Available },
+#endif
+	{ "generic", NULL }
+};
+
+static const CryptoKernelCandidate WhirlpoolKernels[] =
+{
+#if CRYPTOPP_BOOL_X64 && !defined(CRYPTOPP_DISABLE_ASM)
+	{ "AVX2", WhirlpoolAvx2Available },
+#endif
+#if (CRYPTOPP_BOOL_X86 || CRYPTOPP_BOOL_X32 || CRYPTOPP_BOOL_X64) && CRYPTOPP_BOOL_SSE2_ASM_AVAILABLE
+	{ "SSE2 assembly", WhirlpoolSse2Available },
+#endif
+	{ "generic", NULL }
+};
+
+static const CryptoKernelCandidate StreebogKernels[] =
+{
+#if (CRYPTOPP_BOOL_X86 || CRYPTOPP_BOOL_X32 || CRYPTOPP_BOOL_X64) && CRYPTOPP_BOOL_SSE2_INTRINSICS_AVAILABLE
+#if CRYPTOPP_BOOL_SSE41_INTRINSICS_AVAILABLE
+	{ "SSE4.1", Sse41Available },
+#endif
+	{ "SSE2", Sse2Available },
+#endif
+	{ "generic", NULL }
+};
+
+static const CryptoKernelCandidate Argon2Kernels[] =
+{
+#if CRYPTOPP_BOOL_X64 && !defined(CRYPTOPP_DISABLE_ASM)
+	{ "AVX-512", Argon2Avx512Available },
+#endif
+#if CRYPTOPP_BOOL_X86 || CRYPTOPP_BOOL_X32 || CRYPTOPP_BOOL_X64
+	{ "AVX2", Avx2Available },
+	{ "SSE2", Sse2Available },
+#endif
+	{ "generic", NULL }
+};
+
+static const CryptoKernelClass CryptoKernelClasses[] =
+{
+	{ "AES", AesKernels },
+	{ "AES-XTS", AesXtsKernels },
+	{ "Serpent", SerpentKernels },
+	{ "Twofish", TwofishKernels },
+	{ "Camellia", CamelliaKernels },
+	{ "Kuznyechik", KuznyechikKernels },
+	{ "SM4", Sm4Kernels },
+	{ "SHA-256", Sha256Kernels },
+	{ "SHA-512", Sha512Kernels },
+	{ "PBKDF2-HMAC-SHA-256", Pbkdf2Sha256Kernels },
+	{ "PBKDF2-HMAC-SHA-512", Pbkdf2Sha512Kernels },
+	{ "PBKDF2-HMAC-BLAKE2s", Pbkdf2Blake2sKernels },
+	{ "BLAKE2s", Blake2sKernels },
+	{ "Whirlpool", WhirlpoolKernels },
+	{ "Streebog", StreebogKernels },
+	{ "Argon2", Argon2Kernels }
+};
+
+#define CRYPTO_KERNEL_CLASS_COUNT (sizeof (CryptoKernelClasses) / sizeof (CryptoKernelClasses[0]))
+
+static CryptoKernelInfo CryptoKernels[CRYPTO_KERNEL_CLASS_COUNT];
+static int CryptoKernelsSelected = 0;
+
+void SelectCryptoKernels ()
+{
+	size_t i;
+
+	for (i = 0; i < CRYPTO_KERNEL_CLASS_COUNT; i++)
+	{
+		const CryptoKernelCandidate *candidate = CryptoKernelClasses[i].Candidates;
+
+		while (candidate->IsAvailable && !candidate->IsAvailable ())
+			candidate++;
+
+		CryptoKernels[i].Primitive = CryptoKernelClasses[i].Primitive;
+		CryptoKernels[i].Kernel = candidate->Name;
+	}
+
+	CryptoKernelsSelected = 1;
+}
+
+const CryptoKernelInfo *GetCryptoKernelInfo (size_t index)
+{
+	if (!CryptoKernelsSelected)
+		SelectCryptoKernels ();
+
+	if (index >= CRYPTO_KERNEL_CLASS_COUNT)
+		return NULL;
+
+	return &CryptoKernels[index];
+}
@@ -0,0 +1,37 @@
+/*
+ VeraCrypt source code
+ Copyright (c) 2026 AM Crypto
+
+ This file is part of VeraCrypt and is governed by the Apache License 2.0
+ the full text of which is contained in the file License.txt included in
+ VeraCrypt binary and source code distribution packages.
+*/
+
+#ifndef TC_HEADER_Crypto_Kernels
+#define TC_HEADER_Crypto_Kernels
+
+#include "Common/Tcdefs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{
+	const char *Primitive;
+	const char *Kernel;
+} CryptoKernelInfo;
+
+/* Resolves the implementation used for each block cipher, XTS and hash algorithm from the detected
+   CPU features. Must be called after the CPU features are detected and again whenever they or the
+   hardware acceleration setting change. */
+void SelectCryptoKernels ();
+
+/* Returns the kernel selected for the primitive at the given index, or NULL past the last one */
+const CryptoKernelInfo *GetCryptoKernelInfo (size_t index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TC_HEADER_Crypto_Kernels
@@ -36,6 +36,15 @@
 #if CRYPTOPP_BOOL_SSE2_INTRINSICS_AVAILABLE
 extern void serpent_simd_encrypt_blocks_4(const unsigned __int8 in[], unsigned __int8 out[], unsigned __int32* round_key);
 extern void serpent_simd_decrypt_blocks_4(const unsigned __int8 in[], unsigned __int8 out[], unsigned __int32* round_key);
+#if !defined (TC_WINDOWS_DRIVER) && !defined (_UEFI)
+#define SERPENT_WIDE_SIMD_AVAILABLE
+extern int serpent_simd_has_avx2();
+extern void serpent_simd_encrypt_blocks_8(const unsigned __int8 in[], unsigned __int8 out[], unsigned __int32* round_key);
+extern void serpent_simd_decrypt_blocks_8(const unsigned __int8 in[], unsigned __int8 out[], unsigned __int32* round_key);
+extern int serpent_simd_has_avx512();
+extern void serpent_simd_encrypt_blocks_16(const unsigned __int8 in[], unsigned __int8 out[], unsigned __int32* round_key);
+extern void serpent_simd_decrypt_blocks_16(const unsigned __int8 in[], unsigned __int8 out[], unsigned __int32* round_key);
+#endif
 #endif
 
 /*
@@ -80,6 +89,29 @@ void serpent_encrypt_blocks(const unsigned __int8* in, unsigned __int8* out, siz
    unsigned __int32 B0, B1, B2, B3;
    unsigned __int32* round_key = ((unsigned __int32*) ks) + 8;
    size_t i;
+#if CRYPTOPP_BOOL_SSE2_INTRINSICS_AVAILABLE && defined (SERPENT_WIDE_SIMD_AVAILABLE)
+   if(HasAVX512F() && (blocks >= 16) && serpent_simd_has_avx512())
+   {
+      while(blocks >= 16)
+      {
+         serpent_simd_encrypt_blocks_16(in, out, round_key);
+         in += 16 * 16;
+         out += 16 * 16;
+         blocks -= 16;
+      }
+   }
+
+   if(HasSAVX2() && (blocks >= 8) && serpent_simd_has_avx2())
+   {
+      while(blocks >= 8)
+      {
+         serpent_simd_encrypt_blocks_8(in, out, round_key);
+         in += 8 * 16;
+         out += 8 * 16;
+         blocks -= 8;
+      }
+   }
+#endif
 #if CRYPTOPP_BOOL_SSE2_INTRINSICS_AVAILABLE && (!defined (DEBUG) || !defined (TC_WINDOWS_DRIVER))
    if(HasSSE2() && (blocks >= 4))
    {
@@ -159,6 +191,29 @@ void serpent_decrypt_blocks(const unsigned __int8* in, unsigned __int8* out, siz
    unsigned __int32 B0, B1, B2, B3;
    unsigned __int32* round_key = ((unsigned __int32*) ks) + 8;
    size_t i;
+#if CRYPTOPP_BOOL_SSE2_INTRINSICS_AVAILABLE && defined (SERPENT_WIDE_SIMD_AVAILABLE)
+   if(HasAVX512F() && (blocks >= 16) && serpent_simd_has_avx512())
+   {
+      while(blocks >= 16)
+      {
+         serpent_simd_decrypt_blocks_16(in, out, round_key);
+         in += 16 * 16;
+         out += 16 * 16;
+         blocks -= 16;
+      }
+   }
+
+   if(HasSAVX2() && (blocks >= 8) && serpent_simd_has_avx2())
+   {
+      while(blocks >= 8)
+      {
+         serpent_simd_decrypt_blocks_8(in, out, round_key);
+         in += 8 * 16;
+         out += 8 * 16;
+         blocks -= 8;
+      }
+   }
+#endif
 #if CRYPTOPP_BOOL_SSE2_INTRINSICS_AVAILABLE && (!defined (DEBUG) || !defined (TC_WINDOWS_DRIVER))
    if(HasSSE2() && (blocks >= 4))
    {
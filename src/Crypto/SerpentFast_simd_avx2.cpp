@@ -0,0 +1,178 @@
+/*
+* Serpent (AVX2)
+* (C) 2009,2013 Jack Lloyd
+*
+* Botan is released under the Simplified BSD License (see license.txt)
+*/
+
+#include "SerpentFast.h"
+#include "SerpentFast_simd_rounds.h"
+#if !defined(_UEFI)
+#include <memory.h>
+#include <stdlib.h>
+#endif
+#include "cpu.h"
+#include "misc.h"
+
+#if defined(__AVX2__)
+
+#include <immintrin.h>
+
+/**
+* 8 lanes of 32 bits, with the same restricted set of operations as SIMD_4x32.
+*/
+class SIMD_8x32
+{
+public:
+
+    SIMD_8x32() // zero initialized
+        {
+        m_reg = _mm256_setzero_si256();
+        }
+
+    explicit SIMD_8x32(unsigned __int32 B)
+        {
+        m_reg = _mm256_set1_epi32(B);
+        }
+
+    static SIMD_8x32 load_le(const void* in)
+        {
+        return SIMD_8x32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in)));
+        }
+
+    void store_le(unsigned __int8 out[]) const
+        {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), m_reg);
+        }
+
+    template<size_t ROT> void rotate_left()
+        {
+        m_reg = _mm256_or_si256(_mm256_slli_epi32(m_reg, static_cast<int>(ROT)),
+                                _mm256_srli_epi32(m_reg, static_cast<int>(32-ROT)));
+        }
+
+    template<size_t ROT> void rotate_right()
+        {
+        rotate_left<32 - ROT>();
+        }
+
+    void operator^=(const SIMD_8x32& other)
+        {
+        m_reg = _mm256_xor_si256(m_reg, other.m_reg);
+        }
+
+    SIMD_8x32 operator^(const SIMD_8x32& other) const
+        {
+        return SIMD_8x32(_mm256_xor_si256(m_reg, other.m_reg));
+        }
+
+    void operator|=(const SIMD_8x32& other)
+        {
+        m_reg = _mm256_or_si256(m_reg, other.m_reg);
+        }
+
+    void operator&=(const SIMD_8x32& other)
+        {
+        m_reg = _mm256_and_si256(m_reg, other.m_reg);
+        }
+
+    template<size_t SHIFT> SIMD_8x32 shl() const
+        {
+        return SIMD_8x32(_mm256_slli_epi32(m_reg, static_cast<int>(SHIFT)));
+        }
+
+    SIMD_8x32 operator~() const
+        {
+        return SIMD_8x32(_mm256_xor_si256(m_reg, _mm256_set1_epi32(0xFFFFFFFF)));
+        }
+
+    /*
+    * Transposes the 32-bit words of the four blocks held in the same 128-bit lane
+    * of B0..B3. Applying it twice restores the original layout.
+    */
+    static void transpose(SIMD_8x32& B0, SIMD_8x32& B1,
+                        SIMD_8x32& B2, SIMD_8x32& B3)
+        {
+        __m256i T0 = _mm256_unpacklo_epi32(B0.m_reg, B1.m_reg);
+        __m256i T1 = _mm256_unpacklo_epi32(B2.m_reg, B3.m_reg);
+        __m256i T2 = _mm256_unpackhi_epi32(B0.m_reg, B1.m_reg);
+        __m256i T3 = _mm256_unpackhi_epi32(B2.m_reg, B3.m_reg);
+        B0.m_reg = _mm256_unpacklo_epi64(T0, T1);
+        B1.m_reg = _mm256_unpackhi_epi64(T0, T1);
+        B2.m_reg = _mm256_unpacklo_epi64(T2, T3);
+        B3.m_reg = _mm256_unpackhi_epi64(T2, T3);
+        }
+
+private:
+
+    explicit SIMD_8x32(__m256i in) { m_reg = in; }
+
+    __m256i m_reg;
+
+};
+
+extern "C" int serpent_simd_has_avx2()
+{
+   return 1;
+}
+
+/*
+* AVX2 Serpent Encryption of 8 blocks in parallel
+*/
+extern "C" void serpent_simd_encrypt_blocks_8(const unsigned __int8 in[], unsigned __int8 out[], unsigned __int32* round_key)
+{
+   SIMD_8x32 B0 = SIMD_8x32::load_le(in);
+   SIMD_8x32 B1 = SIMD_8x32::load_le(in + 32);
+   SIMD_8x32 B2 = SIMD_8x32::load_le(in + 64);
+   SIMD_8x32 B3 = SIMD_8x32::load_le(in + 96);
+
+   SIMD_8x32::transpose(B0, B1, B2, B3);
+
+   serpent_simd_encrypt_rounds(B0, B1, B2, B3, round_key);
+
+   SIMD_8x32::transpose(B0, B1, B2, B3);
+
+   B0.store_le(out);
+   B1.store_le(out + 32);
+   B2.store_le(out + 64);
+   B3.store_le(out + 96);
+}
+
+/*
+* AVX2 Serpent Decryption of 8 blocks in parallel
+*/
+extern "C" void serpent_simd_decrypt_blocks_8(const unsigned __int8 in[], unsigned __int8 out[], unsigned __int32* round_key)
+{
+   SIMD_8x32 B0 = SIMD_8x32::load_le(in);
+   SIMD_8x32 B1 = SIMD_8x32::load_le(in + 32);
+   SIMD_8x32 B2 = SIMD_8x32::load_le(in + 64);
+   SIMD_8x32 B3 = SIMD_8x32::load_le(in + 96);
+
+   SIMD_8x32::transpose(B0, B1, B2, B3);
+
+   serpent_simd_decrypt_rounds(B0, B1, B2, B3, round_key);
+
+   SIMD_8x32::transpose(B0, B1, B2, B3);
+
+   B0.store_le(out);
+   B1.store_le(out + 32);
+   B2.store_le(out + 64);
+   B3.store_le(out + 96);
+}
+
+#else
+
+extern "C" int serpent_simd_has_avx2()
+{
+   return 0;
+}
+
+extern "C" void serpent_simd_encrypt_blocks_8(const unsigned __int8 in[], unsigned __int8 out[], unsigned __int32* round_key)
+{
+}
+
+extern "C" void serpent_simd_decrypt_blocks_8(const unsigned __int8 in[], unsigned __int8 out[], unsigned __int32* round_key)
+{
+}
+
+#endif
@@ -0,0 +1,181 @@
+/*
+* Serpent (AVX-512)
+* (C) 2009,2013 Jack Lloyd
+*
+* Botan is released under the Simplified BSD License (see license.txt)
+*/
+
+#include "SerpentFast.h"
+#include "SerpentFast_simd_rounds.h"
+#if !defined(_UEFI)
+#include <memory.h>
+#include <stdlib.h>
+#endif
+#include "cpu.h"
+#include "misc.h"
+
+#if defined(__AVX512F__)
+
+#include <immintrin.h>
+
+/**
+* 16 lanes of 32 bits, with the same restricted set of operations as SIMD_4x32.
+*/
+class SIMD_16x32
+{
+public:
+
+    SIMD_16x32() // zero initialized
+        {
+        m_reg = _mm512_setzero_si512();
+        }
+
+    explicit SIMD_16x32(unsigned __int32 B)
+        {
+        m_reg = _mm512_set1_epi32(B);
+        }
+
+    static SIMD_16x32 load_le(const void* in)
+        {
+        return SIMD_16x32(_mm512_loadu_si512(in));
+        }
+
+    void store_le(unsigned __int8 out[]) const
+        {
+        _mm512_storeu_si512(out, m_reg);
+        }
+
+    /*
+    * The zero-masking forms with every lane selected encode the same instructions as the
+    * unmasked intrinsics, whose undefined pass-through operand GCC reports as uninitialized.
+    */
+    template<size_t ROT> void rotate_left()
+        {
+        m_reg = _mm512_maskz_rol_epi32(0xFFFF, m_reg, static_cast<int>(ROT));
+        }
+
+    template<size_t ROT> void rotate_right()
+        {
+        m_reg = _mm512_maskz_ror_epi32(0xFFFF, m_reg, static_cast<int>(ROT));
+        }
+
+    void operator^=(const SIMD_16x32& other)
+        {
+        m_reg = _mm512_xor_si512(m_reg, other.m_reg);
+        }
+
+    SIMD_16x32 operator^(const SIMD_16x32& other) const
+        {
+        return SIMD_16x32(_mm512_xor_si512(m_reg, other.m_reg));
+        }
+
+    void operator|=(const SIMD_16x32& other)
+        {
+        m_reg = _mm512_or_si512(m_reg, other.m_reg);
+        }
+
+    void operator&=(const SIMD_16x32& other)
+        {
+        m_reg = _mm512_and_si512(m_reg, other.m_reg);
+        }
+
+    template<size_t SHIFT> SIMD_16x32 shl() const
+        {
+        return SIMD_16x32(_mm512_maskz_slli_epi32(0xFFFF, m_reg, static_cast<unsigned int>(SHIFT)));
+        }
+
+    SIMD_16x32 operator~() const
+        {
+        return SIMD_16x32(_mm512_ternarylogic_epi32(m_reg, m_reg, m_reg, 0x55));
+        }
+
+    /*
+    * Transposes the 32-bit words of the four blocks held in the same 128-bit lane
+    * of B0..B3. Applying it twice restores the original layout.
+    */
+    static void transpose(SIMD_16x32& B0, SIMD_16x32& B1,
+                        SIMD_16x32& B2, SIMD_16x32& B3)
+        {
+        __m512i T0 = _mm512_maskz_unpacklo_epi32(0xFFFF, B0.m_reg, B1.m_reg);
+        __m512i T1 = _mm512_maskz_unpacklo_epi32(0xFFFF, B2.m_reg, B3.m_reg);
+        __m512i T2 = _mm512_maskz_unpackhi_epi32(0xFFFF, B0.m_reg, B1.m_reg);
+        __m512i T3 = _mm512_maskz_unpackhi_epi32(0xFFFF, B2.m_reg, B3.m_reg);
+        B0.m_reg = _mm512_maskz_unpacklo_epi64(0xFF, T0, T1);
+        B1.m_reg = _mm512_maskz_unpackhi_epi64(0xFF, T0, T1);
+        B2.m_reg = _mm512_maskz_unpacklo_epi64(0xFF, T2, T3);
+        B3.m_reg = _mm512_maskz_unpackhi_epi64(0xFF, T2, T3);
+        }
+
+private:
+
+    explicit SIMD_16x32(__m512i in) { m_reg = in; }
+
+    __m512i m_reg;
+
+};
+
+extern "C" int serpent_simd_has_avx512()
+{
+   return 1;
+}
+
+/*
+* AVX-512 Serpent Encryption of 16 blocks in parallel
+*/
+extern "C" void serpent_simd_encrypt_blocks_16(const unsigned __int8 in[], unsigned __int8 out[], unsigned __int32* round_key)
+{
+   SIMD_16x32 B0 = SIMD_16x32::load_le(in);
+   SIMD_16x32 B1 = SIMD_16x32::load_le(in + 64);
+   SIMD_16x32 B2 = SIMD_16x32::load_le(in + 128);
+   SIMD_16x32 B3 = SIMD_16x32::load_le(in + 192);
+
+   SIMD_16x32::transpose(B0, B1, B2, B3);
+
+   serpent_simd_encrypt_rounds(B0, B1, B2, B3, round_key);
+
+   SIMD_16x32::transpose(B0, B1, B2, B3);
+
+   B0.store_le(out);
+   B1.store_le(out + 64);
+   B2.store_le(out + 128);
+   B3.store_le(out + 192);
+}
+
+/*
+* AVX-512 Serpent Decryption of 16 blocks in parallel
+*/
+extern "C" void serpent_simd_decrypt_blocks_16(const unsigned __int8 in[], unsigned __int8 out[], unsigned __int32* round_key)
+{
+   SIMD_16x32 B0 = SIMD_16x32::load_le(in);
+   SIMD_16x32 B1 = SIMD_16x32::load_le(in + 64);
+   SIMD_16x32 B2 = SIMD_16x32::load_le(in + 128);
+   SIMD_16x32 B3 = SIMD_16x32::load_le(in + 192);
+
+   SIMD_16x32::transpose(B0, B1, B2, B3);
+
+   serpent_simd_decrypt_rounds(B0, B1, B2, B3, round_key);
+
+   SIMD_16x32::transpose(B0, B1, B2, B3);
+
+   B0.store_le(out);
+   B1.store_le(out + 64);
+   B2.store_le(out + 128);
+   B3.store_le(out + 192);
+}
+
+#else
+
+extern "C" int serpent_simd_has_avx512()
+{
+   return 0;
+}
+
+extern "C" void serpent_simd_encrypt_blocks_16(const unsigned __int8 in[], unsigned __int8 out[], unsigned __int32* round_key)
+{
+}
+
+extern "C" void serpent_simd_decrypt_blocks_16(const unsigned __int8 in[], unsigned __int8 out[], unsigned __int32* round_key)
+{
+}
+
+#endif
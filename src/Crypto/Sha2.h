@@ -63,6 +63,18 @@ void sha256_hash(const unsigned char * source, uint_32t sourceLen, sha256_ctx *c
 void sha256_end(unsigned char * result, sha256_ctx* ctx);
 void sha256(unsigned char * result, const unsigned char* source, uint_32t sourceLen);
 
+#ifndef WOLFCRYPT_BACKEND
+#define SHA256_MB_LANES	8
+#define SHA512_MB_LANES	4
+
+/* PBKDF2-HMAC iterations 2 to c on independent chains sharing the same HMAC key, inner and outer being the
+   hash states after the padded key blocks. u holds the output of the first iteration of each chain as host
+   order words and is replaced by the xor of the outputs of all iterations. Return 0 if aborted. */
+int sha2_mb_has_avx2 ();
+int sha256_pbkdf2_avx2 (const uint_32t inner[8], const uint_32t outer[8], uint_32t u[SHA256_MB_LANES][8], uint_32t c, long volatile *pAbortKeyDerivation);
+int sha512_pbkdf2_avx2 (const uint_64t inner[8], const uint_64t outer[8], uint_64t u[SHA512_MB_LANES][8], uint_32t c, long volatile *pAbortKeyDerivation);
+#endif
+
 #if defined(__cplusplus)
 }
 #endif
@@ -0,0 +1,278 @@
+/*
+ VeraCrypt source code
+ Copyright (c) 2026 AM Crypto
+
+ This file is part of VeraCrypt and is governed by the Apache License 2.0
+ the full text of which is contained in the file License.txt included in
+ VeraCrypt binary and source code distribution packages.
+*/
+
+/* PBKDF2-HMAC-SHA-256 and PBKDF2-HMAC-SHA-512 iterations on several chains in parallel using AVX2.
+ *
+ * The chains share the HMAC key (the same password derives all the output blocks of a key), so
+ * the inner and outer hash states after the padded key blocks are common to all the lanes and
+ * only the 32 or 64 byte digest being iterated differs. Each iteration hashes a single padded
+ * block on the inner state and one on the outer state, whose padding and length words are
+ * constants. Register N of the state holds word N of 8 (SHA-256) or 4 (SHA-512) chains.
+ */
+
+#include "Sha2.h"
+#include "Crypto/cpu.h"
+#include "Crypto/misc.h"
+
+#if CRYPTOPP_BOOL_X64 && !defined(CRYPTOPP_DISABLE_ASM) && defined(__AVX2__)
+
+#include <immintrin.h>
+
+static const uint_32t SHA256_MB_K[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static const uint_64t SHA512_MB_K[80] = {
+	LL(0x428a2f98d728ae22), LL(0x7137449123ef65cd), LL(0xb5c0fbcfec4d3b2f), LL(0xe9b5dba58189dbbc),
+	LL(0x3956c25bf348b538), LL(0x59f111f1b605d019), LL(0x923f82a4af194f9b), LL(0xab1c5ed5da6d8118),
+	LL(0xd807aa98a3030242), LL(0x12835b0145706fbe), LL(0x243185be4ee4b28c), LL(0x550c7dc3d5ffb4e2),
+	LL(0x72be5d74f27b896f), LL(0x80deb1fe3b1696b1), LL(0x9bdc06a725c71235), LL(0xc19bf174cf692694),
+	LL(0xe49b69c19ef14ad2), LL(0xefbe4786384f25e3), LL(0x0fc19dc68b8cd5b5), LL(0x240ca1cc77ac9c65),
+	LL(0x2de92c6f592b0275), LL(0x4a7484aa6ea6e483), LL(0x5cb0a9dcbd41fbd4), LL(0x76f988da831153b5),
+	LL(0x983e5152ee66dfab), LL(0xa831c66d2db43210), LL(0xb00327c898fb213f), LL(0xbf597fc7beef0ee4),
+	LL(0xc6e00bf33da88fc2), LL(0xd5a79147930aa725), LL(0x06ca6351e003826f), LL(0x142929670a0e6e70),
+	LL(0x27b70a8546d22ffc), LL(0x2e1b21385c26c926), LL(0x4d2c6dfc5ac42aed), LL(0x53380d139d95b3df),
+	LL(0x650a73548baf63de), LL(0x766a0abb3c77b2a8), LL(0x81c2c92e47edaee6), LL(0x92722c851482353b),
+	LL(0xa2bfe8a14cf10364), LL(0xa81a664bbc423001), LL(0xc24b8b70d0f89791), LL(0xc76c51a30654be30),
+	LL(0xd192e819d6ef5218), LL(0xd69906245565a910), LL(0xf40e35855771202a), LL(0x106aa07032bbd1b8),
+	LL(0x19a4c116b8d2d0c8), LL(0x1e376c085141ab53), LL(0x2748774cdf8eeb99), LL(0x34b0bcb5e19b48a8),
+	LL(0x391c0cb3c5c95a63), LL(0x4ed8aa4ae3418acb), LL(0x5b9cca4f7763e373), LL(0x682e6ff3d6b2b8a3),
+	LL(0x748f82ee5defb2fc), LL(0x78a5636f43172f60), LL(0x84c87814a1f0ab72), LL(0x8cc702081a6439ec),
+	LL(0x90befffa23631e28), LL(0xa4506cebde82bde9), LL(0xbef9a3f7b2c67915), LL(0xc67178f2e372532b),
+	LL(0xca273eceea26619c), LL(0xd186b8c721c0c207), LL(0xeada7dd6cde0eb1e), LL(0xf57d4f7fee6ed178),
+	LL(0x06f067aa72176fba), LL(0x0a637dc5a2c898a6), LL(0x113f9804bef90dae), LL(0x1b710b35131c471b),
+	LL(0x28db77f523047d84), LL(0x32caab7b40c72493), LL(0x3c9ebe0a15c9bebc), LL(0x431d67c49c100d4c),
+	LL(0x4cc5d4becb3e42b6), LL(0x597f299cfc657e2a), LL(0x5fcb6fab3ad6faec), LL(0x6c44198c4a475817)
+};
+
+#define MB_XOR3(x, y, z)	_mm256_xor_si256 (_mm256_xor_si256 ((x), (y)), (z))
+#define MB_CH(e, f, g)		_mm256_xor_si256 (_mm256_and_si256 (_mm256_xor_si256 ((f), (g)), (e)), (g))
+#define MB_MAJ(a, b, c)		_mm256_or_si256 (_mm256_and_si256 ((a), (b)), _mm256_and_si256 ((c), _mm256_or_si256 ((a), (b))))
+
+#define MB32_ROTR(x, n)		_mm256_or_si256 (_mm256_srli_epi32 ((x), (n)), _mm256_slli_epi32 ((x), 32 - (n)))
+#define MB32_SUM0(x)		MB_XOR3 (MB32_ROTR ((x), 2), MB32_ROTR ((x), 13), MB32_ROTR ((x), 22))
+#define MB32_SUM1(x)		MB_XOR3 (MB32_ROTR ((x), 6), MB32_ROTR ((x), 11), MB32_ROTR ((x), 25))
+#define MB32_SIGMA0(x)		MB_XOR3 (MB32_ROTR ((x), 7), MB32_ROTR ((x), 18), _mm256_srli_epi32 ((x), 3))
+#define MB32_SIGMA1(x)		MB_XOR3 (MB32_ROTR ((x), 17), MB32_ROTR ((x), 19), _mm256_srli_epi32 ((x), 10))
+
+#define MB64_ROTR(x, n)		_mm256_or_si256 (_mm256_srli_epi64 ((x), (n)), _mm256_slli_epi64 ((x), 64 - (n)))
+#define MB64_SUM0(x)		MB_XOR3 (MB64_ROTR ((x), 28), MB64_ROTR ((x), 34), MB64_ROTR ((x), 39))
+#define MB64_SUM1(x)		MB_XOR3 (MB64_ROTR ((x), 14), MB64_ROTR ((x), 18), MB64_ROTR ((x), 41))
+#define MB64_SIGMA0(x)		MB_XOR3 (MB64_ROTR ((x), 1), MB64_ROTR ((x), 8), _mm256_srli_epi64 ((x), 7))
+#define MB64_SIGMA1(x)		MB_XOR3 (MB64_ROTR ((x), 19), MB64_ROTR ((x), 61), _mm256_srli_epi64 ((x), 6))
+
+/* Round i of the compression, the state variables being passed in their rotated order */
+#define MB32_ROUND(a, b, c, d, e, f, g, h, i) \
+	if ((i) >= 16) \
+		w[(i) & 15] = _mm256_add_epi32 (_mm256_add_epi32 (w[(i) & 15], MB32_SIGMA1 (w[((i) + 14) & 15])), _mm256_add_epi32 (w[((i) + 9) & 15], MB32_SIGMA0 (w[((i) + 1) & 15]))); \
+	t = _mm256_add_epi32 (_mm256_add_epi32 (h, MB32_SUM1 (e)), _mm256_add_epi32 (MB_CH (e, f, g), _mm256_add_epi32 (_mm256_set1_epi32 ((int) SHA256_MB_K[i]), w[(i) & 15]))); \
+	d = _mm256_add_epi32 (d, t); \
+	h = _mm256_add_epi32 (t, _mm256_add_epi32 (MB32_SUM0 (a), MB_MAJ (a, b, c)));
+
+#define MB64_ROUND(a, b, c, d, e, f, g, h, i) \
+	if ((i) >= 16) \
+		w[(i) & 15] = _mm256_add_epi64 (_mm256_add_epi64 (w[(i) & 15], MB64_SIGMA1 (w[((i) + 14) & 15])), _mm256_add_epi64 (w[((i) + 9) & 15], MB64_SIGMA0 (w[((i) + 1) & 15]))); \
+	t = _mm256_add_epi64 (_mm256_add_epi64 (h, MB64_SUM1 (e)), _mm256_add_epi64 (MB_CH (e, f, g), _mm256_add_epi64 (_mm256_set1_epi64x ((long long) SHA512_MB_K[i]), w[(i) & 15]))); \
+	d = _mm256_add_epi64 (d, t); \
+	h = _mm256_add_epi64 (t, _mm256_add_epi64 (MB64_SUM0 (a), MB_MAJ (a, b, c)));
+
+/* Hashes the block holding the 8 words of digest, its padding and the length of the HMAC message
+   (a key block and a digest) on the given initial state, and returns the resulting state in digest */
+static void sha256_mb_hash_digest (const __m256i state[8], __m256i digest[8])
+{
+	__m256i a = state[0], b = state[1], c = state[2], d = state[3], e = state[4], f = state[5], g = state[6], h = state[7];
+	__m256i w[16], t;
+	int i;
+
+	for (i = 0; i < 8; i++)
+		w[i] = digest[i];
+
+	w[8] = _mm256_set1_epi32 ((int) 0x80000000);
+	for (i = 9; i < 15; i++)
+		w[i] = _mm256_setzero_si256 ();
+	w[15] = _mm256_set1_epi32 ((SHA256_BLOCK_SIZE + SHA256_DIGEST_SIZE) * 8);
+
+	for (i = 0; i < 64; i += 8)
+	{
+		MB32_ROUND (a, b, c, d, e, f, g, h, i + 0);
+		MB32_ROUND (h, a, b, c, d, e, f, g, i + 1);
+		MB32_ROUND (g, h, a, b, c, d, e, f, i + 2);
+		MB32_ROUND (f, g, h, a, b, c, d, e, i + 3);
+		MB32_ROUND (e, f, g, h, a, b, c, d, i + 4);
+		MB32_ROUND (d, e, f, g, h, a, b, c, i + 5);
+		MB32_ROUND (c, d, e, f, g, h, a, b, i + 6);
+		MB32_ROUND (b, c, d, e, f, g, h, a, i + 7);
+	}
+
+	digest[0] = _mm256_add_epi32 (state[0], a);
+	digest[1] = _mm256_add_epi32 (state[1], b);
+	digest[2] = _mm256_add_epi32 (state[2], c);
+	digest[3] = _mm256_add_epi32 (state[3], d);
+	digest[4] = _mm256_add_epi32 (state[4], e);
+	digest[5] = _mm256_add_epi32 (state[5], f);
+	digest[6] = _mm256_add_epi32 (state[6], g);
+	digest[7] = _mm256_add_epi32 (state[7], h);
+}
+
+static void sha512_mb_hash_digest (const __m256i state[8], __m256i digest[8])
+{
+	__m256i a = state[0], b = state[1], c = state[2], d = state[3], e = state[4], f = state[5], g = state[6], h = state[7];
+	__m256i w[16], t;
+	int i;
+
+	for (i = 0; i < 8; i++)
+		w[i] = digest[i];
+
+	w[8] = _mm256_set1_epi64x ((long long) LL(0x8000000000000000));
+	for (i = 9; i < 15; i++)
+		w[i] = _mm256_setzero_si256 ();
+	w[15] = _mm256_set1_epi64x ((SHA512_BLOCK_SIZE + SHA512_DIGEST_SIZE) * 8);
+
+	for (i = 0; i < 80; i += 8)
+	{
+		MB64_ROUND (a, b, c, d, e, f, g, h, i + 0);
+		MB64_ROUND (h, a, b, c, d, e, f, g, i + 1);
+		MB64_ROUND (g, h, a, b, c, d, e, f, i + 2);
+		MB64_ROUND (f, g, h, a, b, c, d, e, i + 3);
+		MB64_ROUND (e, f, g, h, a, b, c, d, i + 4);
+		MB64_ROUND (d, e, f, g, h, a, b, c, i + 5);
+		MB64_ROUND (c, d, e, f, g, h, a, b, i + 6);
+		MB64_ROUND (b, c, d, e, f, g, h, a, i + 7);
+	}
+
+	digest[0] = _mm256_add_epi64 (state[0], a);
+	digest[1] = _mm256_add_epi64 (state[1], b);
+	digest[2] = _mm256_add_epi64 (state[2], c);
+	digest[3] = _mm256_add_epi64 (state[3], d);
+	digest[4] = _mm256_add_epi64 (state[4], e);
+	digest[5] = _mm256_add_epi64 (state[5], f);
+	digest[6] = _mm256_add_epi64 (state[6], g);
+	digest[7] = _mm256_add_epi64 (state[7], h);
+}
+
+int sha2_mb_has_avx2 ()
+{
+	return 1;
+}
+
+int sha256_pbkdf2_avx2 (const uint_32t inner[8], const uint_32t outer[8], uint_32t u[SHA256_MB_LANES][8], uint_32t c, long volatile *pAbortKeyDerivation)
+{
+	__m256i innerState[8], outerState[8], digest[8], t[8];
+	int i, result = 1;
+
+	for (i = 0; i < 8; i++)
+	{
+		innerState[i] = _mm256_set1_epi32 ((int) inner[i]);
+		outerState[i] = _mm256_set1_epi32 ((int) outer[i]);
+		digest[i] = _mm256_setr_epi32 ((int) u[0][i], (int) u[1][i], (int) u[2][i], (int) u[3][i], (int) u[4][i], (int) u[5][i], (int) u[6][i], (int) u[7][i]);
+		t[i] = digest[i];
+	}
+
+	for (; c > 1; c--)
+	{
+		if (pAbortKeyDerivation && (c & 1023) == 0 && *pAbortKeyDerivation == 1)
+		{
+			result = 0;
+			break;
+		}
+
+		sha256_mb_hash_digest (innerState, digest);
+		sha256_mb_hash_digest (outerState, digest);
+
+		for (i = 0; i < 8; i++)
+			t[i] = _mm256_xor_si256 (t[i], digest[i]);
+	}
+
+	for (i = 0; i < 8; i++)
+	{
+		CRYPTOPP_ALIGN_DATA(32) uint_32t lanes[SHA256_MB_LANES];
+		int lane;
+
+		_mm256_store_si256 ((__m256i *) lanes, t[i]);
+		for (lane = 0; lane < SHA256_MB_LANES; lane++)
+			u[lane][i] = lanes[lane];
+	}
+
+	burn (digest, sizeof (digest));
+	burn (t, sizeof (t));
+	burn (innerState, sizeof (innerState));
+	burn (outerState, sizeof (outerState));
+	return result;
+}
+
+int sha512_pbkdf2_avx2 (const uint_64t inner[8], const uint_64t outer[8], uint_64t u[SHA512_MB_LANES][8], uint_32t c, long volatile *pAbortKeyDerivation)
+{
+	__m256i innerState[8], outerState[8], digest[8], t[8];
+	int i, result = 1;
+
+	for (i = 0; i < 8; i++)
+	{
+		innerState[i] = _mm256_set1_epi64x ((long long) inner[i]);
+		outerState[i] = _mm256_set1_epi64x ((long long) outer[i]);
+		digest[i] = _mm256_setr_epi64x ((long long) u[0][i], (long long) u[1][i], (long long) u[2][i], (long long) u[3][i]);
+		t[i] = digest[i];
+	}
+
+	for (; c > 1; c--)
+	{
+		if (pAbortKeyDerivation && (c & 1023) == 0 && *pAbortKeyDerivation == 1)
+		{
+			result = 0;
+			break;
+		}
+
+		sha512_mb_hash_digest (innerState, digest);
+		sha512_mb_hash_digest (outerState, digest);
+
+		for (i = 0; i < 8; i++)
+			t[i] = _mm256_xor_si256 (t[i], digest[i]);
+	}
+
+	for (i = 0; i < 8; i++)
+	{
+		CRYPTOPP_ALIGN_DATA(32) uint_64t lanes[SHA512_MB_LANES];
+		int lane;
+
+		_mm256_store_si256 ((__m256i *) lanes, t[i]);
+		for (lane = 0; lane < SHA512_MB_LANES; lane++)
+			u[lane][i] = lanes[lane];
+	}
+
+	burn (digest, sizeof (digest));
+	burn (t, sizeof (t));
+	burn (innerState, sizeof (innerState));
+	burn (outerState, sizeof (outerState));
+	return result;
+}
+
+#else
+
+int sha2_mb_has_avx2 ()
+{
+	return 0;
+}
+
+int sha256_pbkdf2_avx2 (const uint_32t inner[8], const uint_32t outer[8], uint_32t u[SHA256_MB_LANES][8], uint_32t c, long volatile *pAbortKeyDerivation)
+{
+	return 0;
+}
+
+int sha512_pbkdf2_avx2 (const uint_64t inner[8], const uint_64t outer[8], uint_64t u[SHA512_MB_LANES][8], uint_32t c, long volatile *pAbortKeyDerivation)
+{
+	return 0;
+}
+
+#endif
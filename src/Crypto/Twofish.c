@@ -43,6 +43,7 @@
 #ifndef TC_MINIMIZE_CODE_SIZE
 
 #include "misc.h"
+#include "cpu.h"
 
 /* C implementation based on code written by kerukuro for cppcrypto library 
    (http://cppcrypto.sourceforge.net/) and released into public domain.
@@ -71,12 +72,32 @@ void twofish_dec_blk2(TwofishInstance *ks, uint8 *dst, const uint8 *src);
 void twofish_enc_blk3(TwofishInstance *ks, uint8 *dst, const uint8 *src);
 void twofish_dec_blk3(TwofishInstance *ks, uint8 *dst, const uint8 *src);
 
+#if !defined (TC_WINDOWS_DRIVER) && !defined (_UEFI)
+#define TWOFISH_AVX2_AVAILABLE
+int twofish_has_avx2 ();
+void twofish_avx2_encrypt_blocks_16 (TwofishInstance *ks, const uint8 *in_blk, uint8 *out_blk);
+void twofish_avx2_decrypt_blocks_16 (TwofishInstance *ks, const uint8 *in_blk, uint8 *out_blk);
+#endif
+
 #if defined(__cplusplus)
 }
 #endif
 
 void twofish_encrypt_blocks(TwofishInstance *instance, const uint8* in_blk, uint8* out_blk, uint32 blockCount)
 {
+#ifdef TWOFISH_AVX2_AVAILABLE
+	if (HasSAVX2() && (blockCount >= 16) && twofish_has_avx2())
+	{
+		while (blockCount >= 16)
+		{
+			twofish_avx2_encrypt_blocks_16 (instance, in_blk, out_blk);
+			out_blk += 16 * 16;
+			in_blk += 16 * 16;
+			blockCount -= 16;
+		}
+	}
+#endif
+
 	while (blockCount >= 3)
 	{
 		twofish_enc_blk3 (instance, out_blk, in_blk);
@@ -98,6 +119,19 @@ void twofish_encrypt_blocks(TwofishInstance *instance, const uint8* in_blk, uint
 
 void twofish_decrypt_blocks(TwofishInstance *instance, const uint8* in_blk, uint8* out_blk, uint32 blockCount)
 {
+#ifdef TWOFISH_AVX2_AVAILABLE
+	if (HasSAVX2() && (blockCount >= 16) && twofish_has_avx2())
+	{
+		while (blockCount >= 16)
+		{
+			twofish_avx2_decrypt_blocks_16 (instance, in_blk, out_blk);
+			out_blk += 16 * 16;
+			in_blk += 16 * 16;
+			blockCount -= 16;
+		}
+	}
+#endif
+
 	while (blockCount >= 3)
 	{
 		twofish_dec_blk3 (instance, out_blk, in_blk);
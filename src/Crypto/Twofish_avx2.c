@@ -0,0 +1,163 @@
+/*
+ VeraCrypt source code
+ Copyright (c) 2026 AM Crypto
+
+ This file is part of VeraCrypt and is governed by the Apache License 2.0
+ the full text of which is contained in the file License.txt included in
+ VeraCrypt binary and source code distribution packages.
+*/
+
+/* Twofish processing 16 blocks in parallel using AVX2.
+ *
+ * The key-dependent S-boxes combined with the MDS matrix (mk_tab) are looked up
+ * with vpgatherdd. Two independent groups of 8 blocks are interleaved so that
+ * the latency of the gathers of one group is hidden behind the other.
+ * Each group is kept in word-sliced form: register xN holds word N of 8 blocks.
+ */
+
+#include "Twofish.h"
+#include "Crypto/cpu.h"
+#include "Crypto/misc.h"
+
+#if CRYPTOPP_BOOL_X64 && !defined(CRYPTOPP_DISABLE_ASM) && defined(__AVX2__)
+
+#include <immintrin.h>
+
+#define TF_ROTL(x, n)	_mm256_or_si256 (_mm256_slli_epi32 ((x), (n)), _mm256_srli_epi32 ((x), 32 - (n)))
+#define TF_ROTR(x, n)	TF_ROTL ((x), 32 - (n))
+
+#define TF_BYTE(x, n)	_mm256_and_si256 (_mm256_srli_epi32 ((x), 8 * (n)), byteMask)
+
+#define TF_G(t, x) \
+	_mm256_xor_si256 ( \
+		_mm256_xor_si256 (_mm256_i32gather_epi32 ((const int *) (t)[0], TF_BYTE ((x), 0), 4), _mm256_i32gather_epi32 ((const int *) (t)[1], TF_BYTE ((x), 1), 4)), \
+		_mm256_xor_si256 (_mm256_i32gather_epi32 ((const int *) (t)[2], TF_BYTE ((x), 2), 4), _mm256_i32gather_epi32 ((const int *) (t)[3], _mm256_srli_epi32 ((x), 24), 4)))
+
+/* F function of round r applied to (a, b), returning the two round outputs in f0 and f1 */
+#define TF_F(a, b, r, f0, f1) \
+	f0 = TF_G (ks->mk_tab, a); \
+	f1 = TF_G (ks->mk_tab, TF_ROTL (b, 8)); \
+	f0 = _mm256_add_epi32 (f0, f1); \
+	f1 = _mm256_add_epi32 (_mm256_add_epi32 (f1, f0), _mm256_set1_epi32 ((int) ks->k[2 * (r) + 1])); \
+	f0 = _mm256_add_epi32 (f0, _mm256_set1_epi32 ((int) ks->k[2 * (r)]));
+
+#define TF_ENC_ROUND(a, b, c, d, r) \
+	TF_F (a##0, b##0, r, f0, f1); \
+	TF_F (a##1, b##1, r, g0, g1); \
+	c##0 = TF_ROTR (_mm256_xor_si256 (c##0, f0), 1); \
+	d##0 = _mm256_xor_si256 (TF_ROTL (d##0, 1), f1); \
+	c##1 = TF_ROTR (_mm256_xor_si256 (c##1, g0), 1); \
+	d##1 = _mm256_xor_si256 (TF_ROTL (d##1, 1), g1);
+
+#define TF_DEC_ROUND(a, b, c, d, r) \
+	TF_F (a##0, b##0, r, f0, f1); \
+	TF_F (a##1, b##1, r, g0, g1); \
+	c##0 = _mm256_xor_si256 (TF_ROTL (c##0, 1), f0); \
+	d##0 = TF_ROTR (_mm256_xor_si256 (d##0, f1), 1); \
+	c##1 = _mm256_xor_si256 (TF_ROTL (c##1, 1), g0); \
+	d##1 = TF_ROTR (_mm256_xor_si256 (d##1, g1), 1);
+
+/* Converts 8 consecutive blocks to word-sliced form and back (the transform is its own inverse) */
+VC_INLINE void twofish_avx2_transpose (__m256i *b0, __m256i *b1, __m256i *b2, __m256i *b3)
+{
+	__m256i t0 = _mm256_unpacklo_epi32 (*b0, *b1);
+	__m256i t1 = _mm256_unpacklo_epi32 (*b2, *b3);
+	__m256i t2 = _mm256_unpackhi_epi32 (*b0, *b1);
+	__m256i t3 = _mm256_unpackhi_epi32 (*b2, *b3);
+	*b0 = _mm256_unpacklo_epi64 (t0, t1);
+	*b1 = _mm256_unpackhi_epi64 (t0, t1);
+	*b2 = _mm256_unpacklo_epi64 (t2, t3);
+	*b3 = _mm256_unpackhi_epi64 (t2, t3);
+}
+
+VC_INLINE void twofish_avx2_load (const uint8 *in, const uint32 *w, __m256i *b0, __m256i *b1, __m256i *b2, __m256i *b3)
+{
+	*b0 = _mm256_loadu_si256 ((const __m256i *) in);
+	*b1 = _mm256_loadu_si256 ((const __m256i *) (in + 32));
+	*b2 = _mm256_loadu_si256 ((const __m256i *) (in + 64));
+	*b3 = _mm256_loadu_si256 ((const __m256i *) (in + 96));
+	twofish_avx2_transpose (b0, b1, b2, b3);
+	*b0 = _mm256_xor_si256 (*b0, _mm256_set1_epi32 ((int) w[0]));
+	*b1 = _mm256_xor_si256 (*b1, _mm256_set1_epi32 ((int) w[1]));
+	*b2 = _mm256_xor_si256 (*b2, _mm256_set1_epi32 ((int) w[2]));
+	*b3 = _mm256_xor_si256 (*b3, _mm256_set1_epi32 ((int) w[3]));
+}
+
+VC_INLINE void twofish_avx2_store (uint8 *out, const uint32 *w, __m256i b0, __m256i b1, __m256i b2, __m256i b3)
+{
+	b0 = _mm256_xor_si256 (b0, _mm256_set1_epi32 ((int) w[0]));
+	b1 = _mm256_xor_si256 (b1, _mm256_set1_epi32 ((int) w[1]));
+	b2 = _mm256_xor_si256 (b2, _mm256_set1_epi32 ((int) w[2]));
+	b3 = _mm256_xor_si256 (b3, _mm256_set1_epi32 ((int) w[3]));
+	twofish_avx2_transpose (&b0, &b1, &b2, &b3);
+	_mm256_storeu_si256 ((__m256i *) out, b0);
+	_mm256_storeu_si256 ((__m256i *) (out + 32), b1);
+	_mm256_storeu_si256 ((__m256i *) (out + 64), b2);
+	_mm256_storeu_si256 ((__m256i *) (out + 96), b3);
+}
+
+int twofish_has_avx2 ()
+{
+	return 1;
+}
+
+void twofish_avx2_encrypt_blocks_16 (TwofishInstance *ks, const uint8 *in_blk, uint8 *out_blk)
+{
+	const __m256i byteMask = _mm256_set1_epi32 (0xFF);
+	__m256i x00, x10, x20, x30, x01, x11, x21, x31;
+	__m256i f0, f1, g0, g1;
+
+	twofish_avx2_load (in_blk, ks->w, &x00, &x10, &x20, &x30);
+	twofish_avx2_load (in_blk + 128, ks->w, &x01, &x11, &x21, &x31);
+
+	TF_ENC_ROUND (x0, x1, x2, x3, 0);  TF_ENC_ROUND (x2, x3, x0, x1, 1);
+	TF_ENC_ROUND (x0, x1, x2, x3, 2);  TF_ENC_ROUND (x2, x3, x0, x1, 3);
+	TF_ENC_ROUND (x0, x1, x2, x3, 4);  TF_ENC_ROUND (x2, x3, x0, x1, 5);
+	TF_ENC_ROUND (x0, x1, x2, x3, 6);  TF_ENC_ROUND (x2, x3, x0, x1, 7);
+	TF_ENC_ROUND (x0, x1, x2, x3, 8);  TF_ENC_ROUND (x2, x3, x0, x1, 9);
+	TF_ENC_ROUND (x0, x1, x2, x3, 10); TF_ENC_ROUND (x2, x3, x0, x1, 11);
+	TF_ENC_ROUND (x0, x1, x2, x3, 12); TF_ENC_ROUND (x2, x3, x0, x1, 13);
+	TF_ENC_ROUND (x0, x1, x2, x3, 14); TF_ENC_ROUND (x2, x3, x0, x1, 15);
+
+	twofish_avx2_store (out_blk, ks->w + 4, x20, x30, x00, x10);
+	twofish_avx2_store (out_blk + 128, ks->w + 4, x21, x31, x01, x11);
+}
+
+void twofish_avx2_decrypt_blocks_16 (TwofishInstance *ks, const uint8 *in_blk, uint8 *out_blk)
+{
+	const __m256i byteMask = _mm256_set1_epi32 (0xFF);
+	__m256i x00, x10, x20, x30, x01, x11, x21, x31;
+	__m256i f0, f1, g0, g1;
+
+	twofish_avx2_load (in_blk, ks->w + 4, &x00, &x10, &x20, &x30);
+	twofish_avx2_load (in_blk + 128, ks->w + 4, &x01, &x11, &x21, &x31);
+
+	TF_DEC_ROUND (x0, x1, x2, x3, 15); TF_DEC_ROUND (x2, x3, x0, x1, 14);
+	TF_DEC_ROUND (x0, x1, x2, x3, 13); TF_DEC_ROUND (x2, x3, x0, x1, 12);
+	TF_DEC_ROUND (x0, x1, x2, x3, 11); TF_DEC_ROUND (x2, x3, x0, x1, 10);
+	TF_DEC_ROUND (x0, x1, x2, x3, 9);  TF_DEC_ROUND (x2, x3, x0, x1, 8);
+	TF_DEC_ROUND (x0, x1, x2, x3, 7);  TF_DEC_ROUND (x2, x3, x0, x1, 6);
+	TF_DEC_ROUND (x0, x1, x2, x3, 5);  TF_DEC_ROUND (x2, x3, x0, x1, 4);
+	TF_DEC_ROUND (x0, x1, x2, x3, 3);  TF_DEC_ROUND (x2, x3, x0, x1, 2);
+	TF_DEC_ROUND (x0, x1, x2, x3, 1);  TF_DEC_ROUND (x2, x3, x0, x1, 0);
+
+	twofish_avx2_store (out_blk, ks->w, x20, x30, x00, x10);
+	twofish_avx2_store (out_blk + 128, ks->w, x21, x31, x01, x11);
+}
+
+#else
+
+int twofish_has_avx2 ()
+{
+	return 0;
+}
+
+void twofish_avx2_encrypt_blocks_16 (TwofishInstance *ks, const uint8 *in_blk, uint8 *out_blk)
+{
+}
+
+void twofish_avx2_decrypt_blocks_16 (TwofishInstance *ks, const uint8 *in_blk, uint8 *out_blk)
+{
+}
+
+#endif
@@ -94,6 +94,12 @@
  */
 #define R 10
 
+#if BYTE_ORDER == LITTLE_ENDIAN && CRYPTOPP_BOOL_X64 && !defined (CRYPTOPP_DISABLE_ASM) && !defined (TC_WINDOWS_DRIVER) && !defined (_UEFI)
+#define WHIRLPOOL_AVX2_AVAILABLE
+int whirlpool_has_avx2 ();
+void whirlpool_compress_avx2 (uint64 *digest, const uint64 *block);
+#endif
+
 /*
  * Though Whirlpool is endianness-neutral, the encryption tables are listed
  * in BIG-ENDIAN format, which is adopted throughout this implementation
@@ -652,6 +658,14 @@ void WhirlpoolTransform(uint64 *digest, const uint64 *block)
 	}
 #endif
 #endif
+
+#ifdef WHIRLPOOL_AVX2_AVAILABLE
+	if (HasSAVX2() && whirlpool_has_avx2())
+	{
+		whirlpool_compress_avx2 (digest, block);
+		return;
+	}
+#endif
 	
 #if CRYPTOPP_BOOL_SSE2_ASM_AVAILABLE
 	if (HasISSE())
@@ -0,0 +1,210 @@
+/*
+ VeraCrypt source code
+ Copyright (c) 2026 AM Crypto
+
+ This file is part of VeraCrypt and is governed by the Apache License 2.0
+ the full text of which is contained in the file License.txt included in
+ VeraCrypt binary and source code distribution packages.
+*/
+
+/* Whirlpool compression function computed with AVX2 byte shuffles instead of table lookups.
+ *
+ * The 8x8 byte state is held column-major in two registers (columns 0-3 and 4-7, byte i of a
+ * column being row i), so that the cyclical permutation of the columns is a single shuffle per
+ * register and the linear diffusion layer combines whole columns. The S-box is evaluated from
+ * its three 4-bit mini-boxes E, E^-1 and R with in-register lookups.
+ */
+
+#include "Common/Tcdefs.h"
+#include "Crypto/config.h"
+#include "Crypto/cpu.h"
+#include "Crypto/misc.h"
+
+#if CRYPTOPP_BOOL_X64 && !defined(CRYPTOPP_DISABLE_ASM) && defined(__AVX2__)
+
+#include <immintrin.h>
+
+/* First 80 S-box values, row 0 of the round constants */
+CRYPTOPP_ALIGN_DATA(16) static const uint8 WHIRLPOOL_AVX2_RC[10][8] =
+{
+	{ 0x18, 0x23, 0xc6, 0xe8, 0x87, 0xb8, 0x01, 0x4f },
+	{ 0x36, 0xa6, 0xd2, 0xf5, 0x79, 0x6f, 0x91, 0x52 },
+	{ 0x60, 0xbc, 0x9b, 0x8e, 0xa3, 0x0c, 0x7b, 0x35 },
+	{ 0x1d, 0xe0, 0xd7, 0xc2, 0x2e, 0x4b, 0xfe, 0x57 },
+	{ 0x15, 0x77, 0x37, 0xe5, 0x9f, 0xf0, 0x4a, 0xda },
+	{ 0x58, 0xc9, 0x29, 0x0a, 0xb1, 0xa0, 0x6b, 0x85 },
+	{ 0xbd, 0x5d, 0x10, 0xf4, 0xcb, 0x3e, 0x05, 0x67 },
+	{ 0xe4, 0x27, 0x41, 0x8b, 0xa7, 0x7d, 0x95, 0xd8 },
+	{ 0xfb, 0xee, 0x7c, 0x66, 0xdd, 0x17, 0x47, 0x9e },
+	{ 0xca, 0x2d, 0xbf, 0x07, 0xad, 0x5a, 0x83, 0x33 }
+};
+
+typedef struct
+{
+	__m256i E, EHigh, EInv, R, LowNibble, Poly, PermuteA, PermuteB;
+} WhirlpoolAvx2Constants;
+
+/* Transposes the 8x8 byte matrix held as 8 quadwords (a holding quadwords 0-3, b 4-7), reversing
+   the byte order of the quadwords first if the interleaving shuffle does it */
+static void whirlpool_avx2_transpose (__m256i *a, __m256i *b, __m256i interleave)
+{
+	const __m256i pairs = _mm256_setr_epi8 (0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15, 0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15);
+	__m256i x = _mm256_shuffle_epi8 (*a, interleave);
+	__m256i y = _mm256_shuffle_epi8 (*b, interleave);
+
+	x = _mm256_shuffle_epi8 (_mm256_permute4x64_epi64 (x, 0xD8), pairs);
+	y = _mm256_shuffle_epi8 (_mm256_permute4x64_epi64 (y, 0xD8), pairs);
+
+	*a = _mm256_unpacklo_epi32 (x, y);
+	*b = _mm256_unpackhi_epi32 (x, y);
+
+	x = _mm256_permute2x128_si256 (*a, *b, 0x20);
+	y = _mm256_permute2x128_si256 (*a, *b, 0x31);
+	*a = x;
+	*b = y;
+}
+
+VC_INLINE __m256i whirlpool_avx2_sbox (const WhirlpoolAvx2Constants *k, __m256i x)
+{
+	__m256i a = _mm256_shuffle_epi8 (k->E, _mm256_and_si256 (_mm256_srli_epi16 (x, 4), k->LowNibble));
+	__m256i b = _mm256_shuffle_epi8 (k->EInv, _mm256_and_si256 (x, k->LowNibble));
+	__m256i r = _mm256_shuffle_epi8 (k->R, _mm256_xor_si256 (a, b));
+
+	return _mm256_or_si256 (_mm256_shuffle_epi8 (k->EHigh, _mm256_xor_si256 (a, r)), _mm256_shuffle_epi8 (k->EInv, _mm256_xor_si256 (b, r)));
+}
+
+/* Multiplication by 2 in GF(2^8) modulo x^8 + x^4 + x^3 + x^2 + 1 */
+VC_INLINE __m256i whirlpool_avx2_mul2 (const WhirlpoolAvx2Constants *k, __m256i x)
+{
+	return _mm256_xor_si256 (_mm256_add_epi8 (x, x), _mm256_and_si256 (_mm256_cmpgt_epi8 (_mm256_setzero_si256 (), x), k->Poly));
+}
+
+/* Column j of the result is column j - n of (a, b) */
+#define WHIRLPOOL_AVX2_ROTATE_COLUMNS(a, b, ra, rb, permutation, blend) { \
+	__m256i pa = _mm256_permute4x64_epi64 ((a), (permutation)); \
+	__m256i pb = _mm256_permute4x64_epi64 ((b), (permutation)); \
+	ra = _mm256_blend_epi32 (pa, pb, (blend)); \
+	rb = _mm256_blend_epi32 (pb, pa, (blend)); \
+}
+
+/* Applies the S-box, the cyclical permutation and the linear diffusion layer to the state (a, b) */
+VC_INLINE void whirlpool_avx2_round (const WhirlpoolAvx2Constants *k, __m256i *a, __m256i *b)
+{
+	__m256i a1, b1, a2, b2, a4, b4, a8, b8, xa, xb, ra, rb, outA, outB;
+
+	a1 = _mm256_shuffle_epi8 (whirlpool_avx2_sbox (k, *a), k->PermuteA);
+	b1 = _mm256_shuffle_epi8 (whirlpool_avx2_sbox (k, *b), k->PermuteB);
+
+	a2 = whirlpool_avx2_mul2 (k, a1);
+	b2 = whirlpool_avx2_mul2 (k, b1);
+	a4 = whirlpool_avx2_mul2 (k, a2);
+	b4 = whirlpool_avx2_mul2 (k, b2);
+	a8 = whirlpool_avx2_mul2 (k, a4);
+	b8 = whirlpool_avx2_mul2 (k, b4);
+
+	/* Row i of the result is the sum over d of c[d] times column j - d of the input, with the circulant
+	   coefficients c = (1, 1, 4, 1, 8, 5, 2, 9). A rotation by 4 columns swaps the registers, so the terms
+	   for d and d + 4 are added before they are rotated together. */
+	outA = _mm256_xor_si256 (a1, b8);
+	outB = _mm256_xor_si256 (b1, a8);
+
+	xa = _mm256_xor_si256 (a1, _mm256_xor_si256 (b1, b4));
+	xb = _mm256_xor_si256 (b1, _mm256_xor_si256 (a1, a4));
+	WHIRLPOOL_AVX2_ROTATE_COLUMNS (xa, xb, ra, rb, 0x93, 0x03);
+	outA = _mm256_xor_si256 (outA, ra);
+	outB = _mm256_xor_si256 (outB, rb);
+
+	xa = _mm256_xor_si256 (a4, b2);
+	xb = _mm256_xor_si256 (b4, a2);
+	WHIRLPOOL_AVX2_ROTATE_COLUMNS (xa, xb, ra, rb, 0x4E, 0x0F);
+	outA = _mm256_xor_si256 (outA, ra);
+	outB = _mm256_xor_si256 (outB, rb);
+
+	xa = _mm256_xor_si256 (a1, _mm256_xor_si256 (b1, b8));
+	xb = _mm256_xor_si256 (b1, _mm256_xor_si256 (a1, a8));
+	WHIRLPOOL_AVX2_ROTATE_COLUMNS (xa, xb, ra, rb, 0x39, 0x3F);
+	*a = _mm256_xor_si256 (outA, ra);
+	*b = _mm256_xor_si256 (outB, rb);
+}
+
+int whirlpool_has_avx2 ()
+{
+	return 1;
+}
+
+/* Same interface as WhirlpoolTransform: the quadwords hold the rows of the state and of the block,
+   column 0 being the most significant byte */
+void whirlpool_compress_avx2 (uint64 *digest, const uint64 *block)
+{
+	const __m256i reverse = _mm256_setr_epi8 (7, 15, 6, 14, 5, 13, 4, 12, 3, 11, 2, 10, 1, 9, 0, 8, 7, 15, 6, 14, 5, 13, 4, 12, 3, 11, 2, 10, 1, 9, 0, 8);
+	const __m256i interleave = _mm256_setr_epi8 (0, 8, 1, 9, 2, 10, 3, 11, 4, 12, 5, 13, 6, 14, 7, 15, 0, 8, 1, 9, 2, 10, 3, 11, 4, 12, 5, 13, 6, 14, 7, 15);
+	WhirlpoolAvx2Constants k;
+	__m256i hA, hB, mA, mB, kA, kB, sA, sB;
+	int r;
+
+	k.E = _mm256_setr_epi8 (0x1, 0xB, 0x9, 0xC, 0xD, 0x6, 0xF, 0x3, 0xE, 0x8, 0x7, 0x4, 0xA, 0x2, 0x5, 0x0, 0x1, 0xB, 0x9, 0xC, 0xD, 0x6, 0xF, 0x3, 0xE, 0x8, 0x7, 0x4, 0xA, 0x2, 0x5, 0x0);
+	k.EHigh = _mm256_slli_epi16 (k.E, 4);
+	k.EInv = _mm256_setr_epi8 (0xF, 0x0, 0xD, 0x7, 0xB, 0xE, 0x5, 0xA, 0x9, 0x2, 0xC, 0x1, 0x3, 0x4, 0x8, 0x6, 0xF, 0x0, 0xD, 0x7, 0xB, 0xE, 0x5, 0xA, 0x9, 0x2, 0xC, 0x1, 0x3, 0x4, 0x8, 0x6);
+	k.R = _mm256_setr_epi8 (0x7, 0xC, 0xB, 0xD, 0xE, 0x4, 0x9, 0xF, 0x6, 0x3, 0x8, 0xA, 0x2, 0x5, 0x1, 0x0, 0x7, 0xC, 0xB, 0xD, 0xE, 0x4, 0x9, 0xF, 0x6, 0x3, 0x8, 0xA, 0x2, 0x5, 0x1, 0x0);
+	k.LowNibble = _mm256_set1_epi8 (0x0F);
+	k.Poly = _mm256_set1_epi8 (0x1D);
+
+	/* Byte i of column j moves to row i + j */
+	k.PermuteA = _mm256_setr_epi8 (0, 1, 2, 3, 4, 5, 6, 7, 15, 8, 9, 10, 11, 12, 13, 14, 6, 7, 0, 1, 2, 3, 4, 5, 13, 14, 15, 8, 9, 10, 11, 12);
+	k.PermuteB = _mm256_setr_epi8 (4, 5, 6, 7, 0, 1, 2, 3, 11, 12, 13, 14, 15, 8, 9, 10, 2, 3, 4, 5, 6, 7, 0, 1, 9, 10, 11, 12, 13, 14, 15, 8);
+
+	hA = _mm256_loadu_si256 ((const __m256i *) digest);
+	hB = _mm256_loadu_si256 ((const __m256i *) (digest + 4));
+	mA = _mm256_loadu_si256 ((const __m256i *) block);
+	mB = _mm256_loadu_si256 ((const __m256i *) (block + 4));
+
+	whirlpool_avx2_transpose (&hA, &hB, reverse);
+	whirlpool_avx2_transpose (&mA, &mB, reverse);
+
+	kA = hA;
+	kB = hB;
+	sA = _mm256_xor_si256 (mA, kA);
+	sB = _mm256_xor_si256 (mB, kB);
+
+	for (r = 0; r < 10; r++)
+	{
+		whirlpool_avx2_round (&k, &kA, &kB);
+		kA = _mm256_xor_si256 (kA, _mm256_cvtepu8_epi64 (_mm_cvtsi32_si128 (*(const int *) &WHIRLPOOL_AVX2_RC[r][0])));
+		kB = _mm256_xor_si256 (kB, _mm256_cvtepu8_epi64 (_mm_cvtsi32_si128 (*(const int *) &WHIRLPOOL_AVX2_RC[r][4])));
+
+		whirlpool_avx2_round (&k, &sA, &sB);
+		sA = _mm256_xor_si256 (sA, kA);
+		sB = _mm256_xor_si256 (sB, kB);
+	}
+
+	hA = _mm256_xor_si256 (hA, _mm256_xor_si256 (sA, mA));
+	hB = _mm256_xor_si256 (hB, _mm256_xor_si256 (sB, mB));
+
+	/* Back to rows, the columns being taken in reverse order to restore the byte order of the quadwords */
+	sA = _mm256_permute4x64_epi64 (hB, 0x1B);
+	sB = _mm256_permute4x64_epi64 (hA, 0x1B);
+	whirlpool_avx2_transpose (&sA, &sB, interleave);
+
+	_mm256_storeu_si256 ((__m256i *) digest, sA);
+	_mm256_storeu_si256 ((__m256i *) (digest + 4), sB);
+
+	burn (&kA, sizeof (kA));
+	burn (&kB, sizeof (kB));
+	burn (&sA, sizeof (sA));
+	burn (&sB, sizeof (sB));
+	burn (&mA, sizeof (mA));
+	burn (&mB, sizeof (mB));
+}
+
+#else
+
+int whirlpool_has_avx2 ()
+{
+	return 0;
+}
+
+void whirlpool_compress_avx2 (uint64 *digest, const uint64 *block)
+{
+}
+
+#endif
@@ -95,6 +95,16 @@ extern "C" {
   /* Simple API */
   int blake2s( void *out, const void *in, size_t inlen );
 
+#ifndef TC_WINDOWS_BOOT
+#define BLAKE2S_MB_LANES	8
+
+  /* PBKDF2-HMAC iterations 2 to c on independent chains sharing the same HMAC key, inner and outer being the
+     states holding the padded key blocks not compressed yet. u holds the output of the first iteration of each
+     chain as host order words and is replaced by the xor of the outputs of all iterations. Return 0 if aborted. */
+  int blake2s_mb_has_avx2();
+  int blake2s_pbkdf2_avx2( const blake2s_state *inner, const blake2s_state *outer, uint32 u[BLAKE2S_MB_LANES][8], uint32 c, long volatile *pAbortKeyDerivation );
+#endif
+
 #if defined(__cplusplus)
 }
 #endif
@@ -0,0 +1,203 @@
+/*
+ VeraCrypt source code
+ Copyright (c) 2026 AM Crypto
+
+ This file is part of VeraCrypt and is governed by the Apache License 2.0
+ the full text of which is contained in the file License.txt included in
+ VeraCrypt binary and source code distribution packages.
+*/
+
+/* PBKDF2-HMAC-BLAKE2s iterations on 8 chains in parallel using AVX2.
+ *
+ * As for SHA-2, the chains share the HMAC key, so the states after the padded key blocks are
+ * common to all the lanes. Each iteration compresses a single block holding the 32 byte digest
+ * on the inner state and one on the outer state, both being the last block of a 96 byte message.
+ * Register N of the state holds word N of the 8 chains.
+ */
+
+#include "blake2s.h"
+#include "Crypto/config.h"
+#include "Crypto/cpu.h"
+#include "Crypto/misc.h"
+
+#if CRYPTOPP_BOOL_X64 && !defined(CRYPTOPP_DISABLE_ASM) && defined(__AVX2__)
+
+#include <immintrin.h>
+
+static const uint32 BLAKE2S_MB_IV[8] =
+{
+	0x6A09E667UL, 0xBB67AE85UL, 0x3C6EF372UL, 0xA54FF53AUL,
+	0x510E527FUL, 0x9B05688CUL, 0x1F83D9ABUL, 0x5BE0CD19UL
+};
+
+static const uint8 BLAKE2S_MB_SIGMA[10][16] =
+{
+	{  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+	{ 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 },
+	{ 11,  8, 12,  0,  5,  2, 15, 13, 10, 14,  3,  6,  7,  1,  9,  4 },
+	{  7,  9,  3,  1, 13, 12, 11, 14,  2,  6,  5, 10,  4,  0, 15,  8 },
+	{  9,  0,  5,  7,  2,  4, 10, 15, 14,  1, 11, 12,  6,  8,  3, 13 },
+	{  2, 12,  6, 10,  0, 11,  8,  3,  4, 13,  7,  5, 15, 14,  1,  9 },
+	{ 12,  5,  1, 15, 14, 13,  4, 10,  0,  7,  6,  3,  9,  2,  8, 11 },
+	{ 13, 11,  7, 14, 12,  1,  3,  9,  5,  0, 15,  4,  8,  6,  2, 10 },
+	{  6, 15, 14,  9, 11,  3,  0,  8, 12,  2, 13,  7,  1,  4, 10,  5 },
+	{ 10,  2,  8,  4,  7,  6,  1,  5, 15, 11,  9, 14,  3, 12, 13,  0 }
+};
+
+#define MB_ADD(x, y)		_mm256_add_epi32 ((x), (y))
+#define MB_ROTR16(x)		_mm256_shuffle_epi8 ((x), rotr16)
+#define MB_ROTR8(x)			_mm256_shuffle_epi8 ((x), rotr8)
+#define MB_ROTR(x, n)		_mm256_or_si256 (_mm256_srli_epi32 ((x), (n)), _mm256_slli_epi32 ((x), 32 - (n)))
+
+#define MB_G(r, i, a, b, c, d) \
+	a = MB_ADD (MB_ADD (a, b), m[BLAKE2S_MB_SIGMA[r][2 * (i) + 0]]); \
+	d = MB_ROTR16 (_mm256_xor_si256 (d, a)); \
+	c = MB_ADD (c, d); \
+	b = MB_ROTR (_mm256_xor_si256 (b, c), 12); \
+	a = MB_ADD (MB_ADD (a, b), m[BLAKE2S_MB_SIGMA[r][2 * (i) + 1]]); \
+	d = MB_ROTR8 (_mm256_xor_si256 (d, a)); \
+	c = MB_ADD (c, d); \
+	b = MB_ROTR (_mm256_xor_si256 (b, c), 7);
+
+#define MB_ROUND(r) \
+	MB_G (r, 0, v[0], v[4], v[ 8], v[12]); \
+	MB_G (r, 1, v[1], v[5], v[ 9], v[13]); \
+	MB_G (r, 2, v[2], v[6], v[10], v[14]); \
+	MB_G (r, 3, v[3], v[7], v[11], v[15]); \
+	MB_G (r, 4, v[0], v[5], v[10], v[15]); \
+	MB_G (r, 5, v[1], v[6], v[11], v[12]); \
+	MB_G (r, 6, v[2], v[7], v[ 8], v[13]); \
+	MB_G (r, 7, v[3], v[4], v[ 9], v[14]);
+
+/* Compresses the message block m on the state h, t0 being the message length counted so far
+   (always below 2^32 here) and f0 the last block flag */
+static void blake2s_mb_compress (__m256i h[8], const __m256i m[16], uint32 t0, uint32 f0)
+{
+	const __m256i rotr16 = _mm256_setr_epi8 (2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13, 2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+	const __m256i rotr8 = _mm256_setr_epi8 (1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12, 1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12);
+	__m256i v[16];
+	int i;
+
+	for (i = 0; i < 8; i++)
+	{
+		v[i] = h[i];
+		v[i + 8] = _mm256_set1_epi32 ((int) BLAKE2S_MB_IV[i]);
+	}
+
+	v[12] = _mm256_set1_epi32 ((int) (BLAKE2S_MB_IV[4] ^ t0));
+	v[14] = _mm256_set1_epi32 ((int) (BLAKE2S_MB_IV[6] ^ f0));
+
+	MB_ROUND (0);
+	MB_ROUND (1);
+	MB_ROUND (2);
+	MB_ROUND (3);
+	MB_ROUND (4);
+	MB_ROUND (5);
+	MB_ROUND (6);
+	MB_ROUND (7);
+	MB_ROUND (8);
+	MB_ROUND (9);
+
+	for (i = 0; i < 8; i++)
+		h[i] = _mm256_xor_si256 (h[i], _mm256_xor_si256 (v[i], v[i + 8]));
+}
+
+/* Returns the state after the key block buffered in S, broadcast to all the lanes */
+static void blake2s_mb_key_state (const blake2s_state *S, __m256i h[8])
+{
+	__m256i m[16];
+	int i;
+
+	for (i = 0; i < 8; i++)
+		h[i] = _mm256_set1_epi32 ((int) S->h[i]);
+
+	for (i = 0; i < 16; i++)
+		m[i] = _mm256_set1_epi32 ((int) ((uint32) S->buf[4 * i] | ((uint32) S->buf[4 * i + 1] << 8) | ((uint32) S->buf[4 * i + 2] << 16) | ((uint32) S->buf[4 * i + 3] << 24)));
+
+	blake2s_mb_compress (h, m, BLAKE2S_BLOCKBYTES, 0);
+	burn (m, sizeof (m));
+}
+
+/* Hashes the digest as the last block of the HMAC message on the given state, and returns the result in digest */
+static void blake2s_mb_hash_digest (const __m256i state[8], __m256i digest[8])
+{
+	__m256i h[8], m[16];
+	int i;
+
+	for (i = 0; i < 8; i++)
+	{
+		h[i] = state[i];
+		m[i] = digest[i];
+		m[i + 8] = _mm256_setzero_si256 ();
+	}
+
+	blake2s_mb_compress (h, m, BLAKE2S_BLOCKBYTES + BLAKE2S_OUTBYTES, 0xFFFFFFFFUL);
+
+	for (i = 0; i < 8; i++)
+		digest[i] = h[i];
+}
+
+int blake2s_mb_has_avx2 ()
+{
+	return 1;
+}
+
+int blake2s_pbkdf2_avx2 (const blake2s_state *inner, const blake2s_state *outer, uint32 u[BLAKE2S_MB_LANES][8], uint32 c, long volatile *pAbortKeyDerivation)
+{
+	__m256i innerState[8], outerState[8], digest[8], t[8];
+	int i, result = 1;
+
+	blake2s_mb_key_state (inner, innerState);
+	blake2s_mb_key_state (outer, outerState);
+
+	for (i = 0; i < 8; i++)
+	{
+		digest[i] = _mm256_setr_epi32 ((int) u[0][i], (int) u[1][i], (int) u[2][i], (int) u[3][i], (int) u[4][i], (int) u[5][i], (int) u[6][i], (int) u[7][i]);
+		t[i] = digest[i];
+	}
+
+	for (; c > 1; c--)
+	{
+		if (pAbortKeyDerivation && (c & 1023) == 0 && *pAbortKeyDerivation)
+		{
+			result = 0;
+			break;
+		}
+
+		blake2s_mb_hash_digest (innerState, digest);
+		blake2s_mb_hash_digest (outerState, digest);
+
+		for (i = 0; i < 8; i++)
+			t[i] = _mm256_xor_si256 (t[i], digest[i]);
+	}
+
+	for (i = 0; i < 8; i++)
+	{
+		CRYPTOPP_ALIGN_DATA(32) uint32 lanes[BLAKE2S_MB_LANES];
+		int lane;
+
+		_mm256_store_si256 ((__m256i *) lanes, t[i]);
+		for (lane = 0; lane < BLAKE2S_MB_LANES; lane++)
+			u[lane][i] = lanes[lane];
+	}
+
+	burn (digest, sizeof (digest));
+	burn (t, sizeof (t));
+	burn (innerState, sizeof (innerState));
+	burn (outerState, sizeof (outerState));
+	return result;
+}
+
+#else
+
+int blake2s_mb_has_avx2 ()
+{
+	return 0;
+}
+
+int blake2s_pbkdf2_avx2 (const blake2s_state *inner, const blake2s_state *outer, uint32 u[BLAKE2S_MB_LANES][8], uint32 c, long volatile *pAbortKeyDerivation)
+{
+	return 0;
+}
+
+#endif
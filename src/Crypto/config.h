@@ -208,6 +208,17 @@
 	#define CRYPTOPP_SHANI_AVAILABLE 0
 #endif
 
+// AVX-512F, VAES and VPCLMULQDQ intrinsics (512-bit AES and carry-less multiplication).
+// Requires GCC 8, Clang 6 or Visual Studio 2019
+#if !defined(CRYPTOPP_DISABLE_AVX512) && !defined(CRYPTOPP_DISABLE_AESNI) && !defined(CRYPTOPP_DISABLE_ASM) && \
+	CRYPTOPP_BOOL_X64 && !defined(TC_WINDOWS_DRIVER) && !defined(_UEFI) && \
+	((CRYPTOPP_GCC_VERSION >= 80000) || (_MSC_VER >= 1920) || \
+	(CRYPTOPP_LLVM_CLANG_VERSION >= 60000) || (CRYPTOPP_APPLE_CLANG_VERSION >= 100000))
+	#define CRYPTOPP_VAES_AVAILABLE 1
+#else
+	#define CRYPTOPP_VAES_AVAILABLE 0
+#endif
+
 #if defined(__arm64__) || defined(__aarch64__) || defined(_M_ARM64)
 	#define CRYPTOPP_BOOL_ARMV8 1
 	#define CRYPTOPP_BOOL_ARM64 1
@@ -201,6 +201,7 @@ volatile int g_hasISSE = 0, g_hasSSE2 = 0, g_hasSSSE3 = 0, g_hasMMX = 0, g_hasAE
 volatile int g_hasAVX = 0, g_hasAVX2 = 0, g_hasBMI2 = 0, g_hasSSE42 = 0, g_hasSSE41 = 0, g_isIntel = 0, g_isAMD = 0;
 volatile int g_hasRDRAND = 0, g_hasRDSEED = 0;
 volatile int g_hasSHA256 = 0;
+volatile int g_hasAVX512F = 0, g_hasVAES = 0, g_hasVPCLMULQDQ = 0, g_hasAVX512BW = 0, g_hasAVX512VBMI = 0, g_hasGFNI = 0;
 volatile uint32 g_cacheLineSize = CRYPTOPP_L1_CACHE_LINE_SIZE;
 
 VC_INLINE int IsIntel(const uint32 output[4])
@@ -327,8 +328,15 @@ void DetectX86Features()
 {
 	uint32 cpuid[4] = {0}, cpuid1[4] = {0}, cpuid2[4] = {0};
 	uint32 max_basic_leaf;
+	uint64 xcrFeatureMask = 0;
 	int leaf7_avx2 = 0;
 	int leaf7_bmi2 = 0;
+	int leaf7_avx512f = 0;
+	int leaf7_vaes = 0;
+	int leaf7_vpclmulqdq = 0;
+	int leaf7_avx512bw = 0;
+	int leaf7_gfni = 0;
+	int leaf7_avx512vbmi = 0;
 	if (!CpuId(0, cpuid))
 		return;
 	max_basic_leaf = cpuid[0];
@@ -343,7 +351,7 @@ void DetectX86Features()
 		g_hasSSE2 = (cpuid1[2] & (1 << 27)) || TrySSE2();
 	if (g_hasSSE2 && (cpuid1[2] & (1 << 28)) && (cpuid1[2] & (1 << 27)) && (cpuid1[2] & (1 << 26))) /* CPU has AVX and OS supports XSAVE/XRSTORE */
 	{
-      uint64 xcrFeatureMask = xgetbv();
+      xcrFeatureMask = xgetbv();
       g_hasAVX = (xcrFeatureMask & 0x6) == 0x6;
 	}
 	g_hasAVX2 = 0;
@@ -399,6 +407,12 @@ void DetectX86Features()
 				g_hasRDSEED = (cpuid2[1] & (1 << 18)) != 0;
 				leaf7_avx2 = (cpuid2[1] & (1 <<  5)) != 0;
 				leaf7_bmi2 = (cpuid2[1] & (1 <<  8)) != 0;
+				leaf7_avx512f = (cpuid2[1] & (1 << 16)) != 0;
+				leaf7_vaes = (cpuid2[2] & (1 <<  9)) != 0;
+				leaf7_vpclmulqdq = (cpuid2[2] & (1 << 10)) != 0;
+				leaf7_avx512bw = (cpuid2[1] & (1 << 30)) != 0;
+				leaf7_gfni = (cpuid2[2] & (1 <<  8)) != 0;
+				leaf7_avx512vbmi = (cpuid2[2] & (1 <<  1)) != 0;
 			}
 		}
 	}
@@ -416,11 +430,25 @@ void DetectX86Features()
 				g_hasRDSEED = (cpuid2[1] & (1 << 18)) != 0;
 				leaf7_avx2 = (cpuid2[1] & (1 <<  5)) != 0;
 				leaf7_bmi2 = (cpuid2[1] & (1 <<  8)) != 0;
+				leaf7_avx512f = (cpuid2[1] & (1 << 16)) != 0;
+				leaf7_vaes = (cpuid2[2] & (1 <<  9)) != 0;
+				leaf7_vpclmulqdq = (cpuid2[2] & (1 << 10)) != 0;
+				leaf7_avx512bw = (cpuid2[1] & (1 << 30)) != 0;
+				leaf7_gfni = (cpuid2[2] & (1 <<  8)) != 0;
+				leaf7_avx512vbmi = (cpuid2[2] & (1 <<  1)) != 0;
 			}
 		}
 	}
 	g_hasAVX2 = g_hasAVX && leaf7_avx2;
 	g_hasBMI2 = leaf7_bmi2;
+	// AVX-512 also requires the OS to save the opmask and upper ZMM registers (XCR0 bits 5, 6 and 7)
+	g_hasAVX512F = g_hasAVX2 && leaf7_avx512f && ((xcrFeatureMask & 0xE0) == 0xE0);
+	g_hasVAES = g_hasAVX512F && g_hasAESNI && leaf7_vaes;
+	g_hasVPCLMULQDQ = g_hasAVX512F && g_hasCLMUL && leaf7_vpclmulqdq;
+	g_hasAVX512BW = g_hasAVX512F && leaf7_avx512bw;
+	g_hasAVX512VBMI = g_hasAVX512BW && leaf7_avx512vbmi;
+	// GFNI is only used through its VEX/EVEX encoded forms
+	g_hasGFNI = g_hasAVX && leaf7_gfni;
 #if defined(_MSC_VER) && !defined(_UEFI)
 	/* Add check fur buggy RDRAND (AMD Ryzen case) even if we always use RDSEED instead of RDRAND when RDSEED available */
 	if (g_hasRDRAND)
@@ -471,6 +499,98 @@ void DisableCPUExtendedFeatures ()
 	g_hasAESNI = 0;
 	g_hasCLMUL = 0;
 	g_hasSHA256 = 0;
+	g_hasAVX512F = 0;
+	g_hasVAES = 0;
+	g_hasVPCLMULQDQ = 0;
+	g_hasAVX512BW = 0;
+	g_hasAVX512VBMI = 0;
+	g_hasGFNI = 0;
+}
+
+static const struct
+{
+	const char *Name;
+	volatile int *Flag;
+} CpuFeatureFlags[] =
+{
+	{ "sse41", &g_hasSSE41 },
+	{ "sse42", &g_hasSSE42 },
+	{ "ssse3", &g_hasSSSE3 },
+	{ "avx", &g_hasAVX },
+	{ "avx2", &g_hasAVX2 },
+	{ "bmi2", &g_hasBMI2 },
+	{ "aesni", &g_hasAESNI },
+	{ "clmul", &g_hasCLMUL },
+	{ "sha", &g_hasSHA256 },
+	{ "avx512f", &g_hasAVX512F },
+	{ "avx512bw", &g_hasAVX512BW },
+	{ "avx512vbmi", &g_hasAVX512VBMI },
+	{ "vaes", &g_hasVAES },
+	{ "vpclmulqdq", &g_hasVPCLMULQDQ },
+	{ "gfni", &g_hasGFNI }
+};
+
+static volatile int *GetCPUFeatureFlag (const char *name, size_t length)
+{
+	size_t i, j;
+
+	for (i = 0; i < sizeof (CpuFeatureFlags) / sizeof (CpuFeatureFlags[0]); i++)
+	{
+		const char *flagName = CpuFeatureFlags[i].Name;
+
+		for (j = 0; j < length && flagName[j] && (name[j] | 0x20) == flagName[j]; j++);
+
+		if (j == length && !flagName[j])
+			return CpuFeatureFlags[i].Flag;
+	}
+
+	return NULL;
+}
+
+int DisableCPUFeatures (const char *names)
+{
+	int pass;
+
+	// The list is validated before any feature is disabled
+	for (pass = 0; pass < 2; pass++)
+	{
+		const char *name = names;
+
+		for (;;)
+		{
+			size_t length = 0;
+			volatile int *flag;
+
+			while (*name == ',' || *name == ' ')
+				name++;
+
+			while (name[length] && name[length] != ',' && name[length] != ' ')
+				length++;
+
+			if (!length)
+				break;
+
+			flag = GetCPUFeatureFlag (name, length);
+			if (!flag)
+				return 0;
+
+			if (pass)
+				*flag = 0;
+
+			name += length;
+		}
+	}
+
+	// Features depending on a disabled one are not usable either (same rules as DetectX86Features)
+	g_hasAVX2 = g_hasAVX2 && g_hasAVX;
+	g_hasAVX512F = g_hasAVX512F && g_hasAVX2;
+	g_hasVAES = g_hasVAES && g_hasAVX512F && g_hasAESNI;
+	g_hasVPCLMULQDQ = g_hasVPCLMULQDQ && g_hasAVX512F && g_hasCLMUL;
+	g_hasAVX512BW = g_hasAVX512BW && g_hasAVX512F;
+	g_hasAVX512VBMI = g_hasAVX512VBMI && g_hasAVX512BW;
+	g_hasGFNI = g_hasGFNI && g_hasAVX;
+
+	return 1;
 }
 
 #endif
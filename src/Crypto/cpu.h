@@ -257,6 +257,12 @@ extern volatile int g_isP4;
 extern volatile int g_hasRDRAND;
 extern volatile int g_hasRDSEED;
 extern volatile int g_hasSHA256;
+extern volatile int g_hasAVX512F;
+extern volatile int g_hasVAES;
+extern volatile int g_hasVPCLMULQDQ;
+extern volatile int g_hasAVX512BW;
+extern volatile int g_hasAVX512VBMI;
+extern volatile int g_hasGFNI;
 extern volatile int g_isIntel;
 extern volatile int g_isAMD;
 extern volatile uint32 g_cacheLineSize;
@@ -265,6 +271,9 @@ int CpuId(uint32 input, uint32 output[4]);
 // disable all CPU extended features (e.g. SSE, AVX, AES) that may have
 // been enabled by DetectX86Features.
 void DisableCPUExtendedFeatures (); 
+// disable the CPU features named in a comma separated list (e.g. "avx512f,gfni") so that
+// the implementations relying on them are not used. Returns 0 if a name is unknown.
+int DisableCPUFeatures (const char *names);
 
 #if CRYPTOPP_BOOL_X64
 #define HasSSE2()	1
@@ -286,6 +295,12 @@ void DisableCPUExtendedFeatures ();
 #define HasRDRAND() g_hasRDRAND
 #define HasRDSEED() g_hasRDSEED
 #define HasSHA256() g_hasSHA256
+#define HasAVX512F() g_hasAVX512F
+#define HasVAES() g_hasVAES
+#define HasVPCLMULQDQ() g_hasVPCLMULQDQ
+#define HasAVX512BW() g_hasAVX512BW
+#define HasAVX512VBMI() g_hasAVX512VBMI
+#define HasGFNI() g_hasGFNI
 #define IsCpuIntel() g_isIntel
 #define IsCpuAMD() g_isAMD
 #define GetCacheLineSize() g_cacheLineSize
@@ -328,6 +343,12 @@ void DetectArmFeatures();
 #define HasSSSE3() 0
 #define HasAESNI() 0
 #define HasCLMUL() 0
+#define HasAVX512F() 0
+#define HasVAES() 0
+#define HasVPCLMULQDQ() 0
+#define HasAVX512BW() 0
+#define HasAVX512VBMI() 0
+#define HasGFNI() 0
 #define IsP4() 0
 #define HasRDRAND() 0
 #define HasRDSEED() 0
@@ -19,6 +19,13 @@ void kuznyechik_decrypt_block_simd(uint8* out, const uint8* in, kuznyechik_kds*
 void kuznyechik_decrypt_blocks_simd(uint8* out, const uint8* in, size_t blocks, kuznyechik_kds* kds);
 #endif
 
+#if !defined (TC_WINDOWS_DRIVER) && !defined (_UEFI)
+#define KUZNYECHIK_GFNI_AVAILABLE
+int kuznyechik_has_gfni ();
+void kuznyechik_gfni_encrypt_blocks_64 (uint8 *out, const uint8 *in, kuznyechik_kds *kds);
+void kuznyechik_gfni_decrypt_blocks_64 (uint8 *out, const uint8 *in, kuznyechik_kds *kds);
+#endif
+
 //#define CPPCRYPTO_DEBUG
 
 	static const uint8 S[256] = {
@@ -2307,6 +2314,18 @@ void kuznyechik_decrypt_blocks_simd(uint8* out, const uint8* in, size_t blocks,
 
 	void kuznyechik_encrypt_blocks(uint8* out, const uint8* in, size_t blocks, kuznyechik_kds* kds)
 	{
+#ifdef KUZNYECHIK_GFNI_AVAILABLE
+		if (HasAVX512VBMI() && HasGFNI() && (blocks >= 64) && kuznyechik_has_gfni())
+		{
+			while (blocks >= 64)
+			{
+				kuznyechik_gfni_encrypt_blocks_64 (out, in, kds);
+				in += 64 * 16;
+				out += 64 * 16;
+				blocks -= 64;
+			}
+		}
+#endif
 #if CRYPTOPP_BOOL_SSE2_INTRINSICS_AVAILABLE && !defined(_UEFI) && (!defined (DEBUG) || !defined (TC_WINDOWS_DRIVER))
 		if(HasSSE2())
 		{
@@ -2377,6 +2396,18 @@ void kuznyechik_decrypt_blocks_simd(uint8* out, const uint8* in, size_t blocks,
 
 	void kuznyechik_decrypt_blocks(uint8* out, const uint8* in, size_t blocks, kuznyechik_kds* kds)
 	{
+#ifdef KUZNYECHIK_GFNI_AVAILABLE
+		if (HasAVX512VBMI() && HasGFNI() && (blocks >= 64) && kuznyechik_has_gfni())
+		{
+			while (blocks >= 64)
+			{
+				kuznyechik_gfni_decrypt_blocks_64 (out, in, kds);
+				in += 64 * 16;
+				out += 64 * 16;
+				blocks -= 64;
+			}
+		}
+#endif
 #if CRYPTOPP_BOOL_SSE2_INTRINSICS_AVAILABLE && !defined(_UEFI) && (!defined (DEBUG) || !defined (TC_WINDOWS_DRIVER))
 		if(HasSSE2())
 		{
@@ -0,0 +1,407 @@
+/*
+ VeraCrypt source code
+ Copyright (c) 2026 AM Crypto
+
+ This file is part of VeraCrypt and is governed by the Apache License 2.0
+ the full text of which is contained in the file License.txt included in
+ VeraCrypt binary and source code distribution packages.
+*/
+
+/* Kuznyechik processing 64 blocks in parallel using AVX-512 and GFNI.
+ *
+ * The blocks are transposed to byte-sliced form: register x[j] holds byte j of 64 blocks.
+ * In this form every byte of a register is multiplied by the same coefficient of the linear
+ * transformation L, so L (the 16x16 matrix over GF(2^8) equivalent to 16 applications of R)
+ * is computed with one GF2P8AFFINEQB per matrix coefficient, the multiplication by a constant
+ * modulo x^8 + x^7 + x^6 + x + 1 being expressed as an 8x8 bit matrix.
+ *
+ * The S-box is not affine equivalent to a field inversion, so it is looked up in a 256-byte
+ * table held in four registers with two VPERMI2B (AVX-512 VBMI) and a blend on the top bit.
+ *
+ * The plain encryption round keys (rke) are used for both directions.
+ */
+
+#include "kuznyechik.h"
+#include "cpu.h"
+#include "misc.h"
+
+#if CRYPTOPP_BOOL_X64 && !defined(CRYPTOPP_DISABLE_ASM) && ((defined(__AVX512VBMI__) && defined(__GFNI__)) || (defined(_MSC_VER) && defined(__AVX512BW__)))
+
+#include <immintrin.h>
+
+CRYPTOPP_ALIGN_DATA(64) static const uint8 kuznyechik_gfni_s[256] = {
+	0xfc, 0xee, 0xdd, 0x11, 0xcf, 0x6e, 0x31, 0x16, 0xfb, 0xc4, 0xfa, 0xda, 0x23, 0xc5, 0x04, 0x4d,
+	0xe9, 0x77, 0xf0, 0xdb, 0x93, 0x2e, 0x99, 0xba, 0x17, 0x36, 0xf1, 0xbb, 0x14, 0xcd, 0x5f, 0xc1,
+	0xf9, 0x18, 0x65, 0x5a, 0xe2, 0x5c, 0xef, 0x21, 0x81, 0x1c, 0x3c, 0x42, 0x8b, 0x01, 0x8e, 0x4f,
+	0x05, 0x84, 0x02, 0xae, 0xe3, 0x6a, 0x8f, 0xa0, 0x06, 0x0b, 0xed, 0x98, 0x7f, 0xd4, 0xd3, 0x1f,
+	0xeb, 0x34, 0x2c, 0x51, 0xea, 0xc8, 0x48, 0xab, 0xf2, 0x2a, 0x68, 0xa2, 0xfd, 0x3a, 0xce, 0xcc,
+	0xb5, 0x70, 0x0e, 0x56, 0x08, 0x0c, 0x76, 0x12, 0xbf, 0x72, 0x13, 0x47, 0x9c, 0xb7, 0x5d, 0x87,
+	0x15, 0xa1, 0x96, 0x29, 0x10, 0x7b, 0x9a, 0xc7, 0xf3, 0x91, 0x78, 0x6f, 0x9d, 0x9e, 0xb2, 0xb1,
+	0x32, 0x75, 0x19, 0x3d, 0xff, 0x35, 0x8a, 0x7e, 0x6d, 0x54, 0xc6, 0x80, 0xc3, 0xbd, 0x0d, 0x57,
+	0xdf, 0xf5, 0x24, 0xa9, 0x3e, 0xa8, 0x43, 0xc9, 0xd7, 0x79, 0xd6, 0xf6, 0x7c, 0x22, 0xb9, 0x03,
+	0xe0, 0x0f, 0xec, 0xde, 0x7a, 0x94, 0xb0, 0xbc, 0xdc, 0xe8, 0x28, 0x50, 0x4e, 0x33, 0x0a, 0x4a,
+	0xa7, 0x97, 0x60, 0x73, 0x1e, 0x00, 0x62, 0x44, 0x1a, 0xb8, 0x38, 0x82, 0x64, 0x9f, 0x26, 0x41,
+	0xad, 0x45, 0x46, 0x92, 0x27, 0x5e, 0x55, 0x2f, 0x8c, 0xa3, 0xa5, 0x7d, 0x69, 0xd5, 0x95, 0x3b,
+	0x07, 0x58, 0xb3, 0x40, 0x86, 0xac, 0x1d, 0xf7, 0x30, 0x37, 0x6b, 0xe4, 0x88, 0xd9, 0xe7, 0x89,
+	0xe1, 0x1b, 0x83, 0x49, 0x4c, 0x3f, 0xf8, 0xfe, 0x8d, 0x53, 0xaa, 0x90, 0xca, 0xd8, 0x85, 0x61,
+	0x20, 0x71, 0x67, 0xa4, 0x2d, 0x2b, 0x09, 0x5b, 0xcb, 0x9b, 0x25, 0xd0, 0xbe, 0xe5, 0x6c, 0x52,
+	0x59, 0xa6, 0x74, 0xd2, 0xe6, 0xf4, 0xb4, 0xc0, 0xd1, 0x66, 0xaf, 0xc2, 0x39, 0x4b, 0x63, 0xb6
+};
+
+CRYPTOPP_ALIGN_DATA(64) static const uint8 kuznyechik_gfni_is[256] = {
+	0xa5, 0x2d, 0x32, 0x8f, 0x0e, 0x30, 0x38, 0xc0, 0x54, 0xe6, 0x9e, 0x39, 0x55, 0x7e, 0x52, 0x91,
+	0x64, 0x03, 0x57, 0x5a, 0x1c, 0x60, 0x07, 0x18, 0x21, 0x72, 0xa8, 0xd1, 0x29, 0xc6, 0xa4, 0x3f,
+	0xe0, 0x27, 0x8d, 0x0c, 0x82, 0xea, 0xae, 0xb4, 0x9a, 0x63, 0x49, 0xe5, 0x42, 0xe4, 0x15, 0xb7,
+	0xc8, 0x06, 0x70, 0x9d, 0x41, 0x75, 0x19, 0xc9, 0xaa, 0xfc, 0x4d, 0xbf, 0x2a, 0x73, 0x84, 0xd5,
+	0xc3, 0xaf, 0x2b, 0x86, 0xa7, 0xb1, 0xb2, 0x5b, 0x46, 0xd3, 0x9f, 0xfd, 0xd4, 0x0f, 0x9c, 0x2f,
+	0x9b, 0x43, 0xef, 0xd9, 0x79, 0xb6, 0x53, 0x7f, 0xc1, 0xf0, 0x23, 0xe7, 0x25, 0x5e, 0xb5, 0x1e,
+	0xa2, 0xdf, 0xa6, 0xfe, 0xac, 0x22, 0xf9, 0xe2, 0x4a, 0xbc, 0x35, 0xca, 0xee, 0x78, 0x05, 0x6b,
+	0x51, 0xe1, 0x59, 0xa3, 0xf2, 0x71, 0x56, 0x11, 0x6a, 0x89, 0x94, 0x65, 0x8c, 0xbb, 0x77, 0x3c,
+	0x7b, 0x28, 0xab, 0xd2, 0x31, 0xde, 0xc4, 0x5f, 0xcc, 0xcf, 0x76, 0x2c, 0xb8, 0xd8, 0x2e, 0x36,
+	0xdb, 0x69, 0xb3, 0x14, 0x95, 0xbe, 0x62, 0xa1, 0x3b, 0x16, 0x66, 0xe9, 0x5c, 0x6c, 0x6d, 0xad,
+	0x37, 0x61, 0x4b, 0xb9, 0xe3, 0xba, 0xf1, 0xa0, 0x85, 0x83, 0xda, 0x47, 0xc5, 0xb0, 0x33, 0xfa,
+	0x96, 0x6f, 0x6e, 0xc2, 0xf6, 0x50, 0xff, 0x5d, 0xa9, 0x8e, 0x17, 0x1b, 0x97, 0x7d, 0xec, 0x58,
+	0xf7, 0x1f, 0xfb, 0x7c, 0x09, 0x0d, 0x7a, 0x67, 0x45, 0x87, 0xdc, 0xe8, 0x4f, 0x1d, 0x4e, 0x04,
+	0xeb, 0xf8, 0xf3, 0x3e, 0x3d, 0xbd, 0x8a, 0x88, 0xdd, 0xcd, 0x0b, 0x13, 0x98, 0x02, 0x93, 0x80,
+	0x90, 0xd0, 0x24, 0x34, 0xcb, 0xed, 0xf4, 0xce, 0x99, 0x10, 0x44, 0x40, 0x92, 0x3a, 0x01, 0x26,
+	0x12, 0x1a, 0x48, 0x68, 0xf5, 0x81, 0x8b, 0xc7, 0xd6, 0x20, 0x0a, 0x08, 0x00, 0x4c, 0xd7, 0x74
+};
+
+/* GF2P8AFFINEQB matrices of the coefficients of L and L^-1: y[i] = sum of m[i][j] * x[j] */
+static const uint64 kuznyechik_gfni_l[16][16] = {
+	{
+		0xfb0d1b376edc437dULL, 0x66aa54a953a62a33ULL, 0xc44c993265cb5362ULL, 0xff0103070f1fc07fULL,
+		0x878912244992a2c3ULL, 0x96bb77efdebcee4bULL, 0x3257ae5cb973d599ULL, 0x3355aa54a9539519ULL,
+		0xe02142850a14c870ULL, 0xff0103070f1fc07fULL, 0xf2172f5ebd7b05f9ULL, 0x0f10204182050407ULL,
+		0xe2274e9d3a7509f1ULL, 0x96bb77efdebcee4bULL, 0xcd56ad5bb66c15e6ULL, 0x94bd7bf7eedd2fcaULL
+	},
+	{
+		0x94bd7bf7eedd2fcaULL, 0xd868d0a04081da6cULL, 0x9aaf5fbe7cf86b4dULL, 0x8a9f3e7dfbf66745ULL,
+		0x060a142851a24283ULL, 0x0c142851a2448506ULL, 0xd778f0e1c284de6bULL, 0xa6ead5ab57aefa53ULL,
+		0xdb6cd8b060c05b6dULL, 0x749c3972e4c9e7baULL, 0xbec284091327f05fULL, 0x798a152b56ad223cULL,
+		0xf61b376edcb886fbULL, 0xacf4e9d2a4483dd6ULL, 0x6abe7cf8f1e2af35ULL, 0xee3366cc98318cf7ULL
+	},
+	{
+		0xee3366cc98318cf7ULL, 0xbace9c3972e4735dULL, 0xf7193366cc98c67bULL, 0x040c183061c38302ULL,
+		0xd47cf8f1e2c55f6aULL, 0xed376edcb8700df6ULL, 0x103061c3870e0c08ULL, 0x394b962d5ab5529cULL,
+		0x6fb060c080016cb7ULL, 0x355fbe7cf8f1d79aULL, 0x68b870e0c1836eb4ULL, 0x55fffefdfaf5bf2aULL,
+		0x2769d3a74f9e1a13ULL, 0x68b870e0c1836eb4ULL, 0x83850a14285121c1ULL, 0x44cd9b366ddbf3a2ULL
+	},
+	{
+		0x44cd9b366ddbf3a2ULL, 0xe93b76ecd9b38ef4ULL, 0xb0d0a0408102b4d8ULL, 0xa0e0c183060cb8d0ULL,
+		0x103061c3870e0c08ULL, 0xb1d2a4489122f458ULL, 0x2a7ffffefdfadf95ULL, 0x54fdfaf5ead5ffaaULL,
+		0x2e73e7ce9c395c97ULL, 0x2b7dfbf6edda9f15ULL, 0xf2172f5ebd7b05f9ULL, 0x0d162c59b264c586ULL,
+		0x41c3870e1c383020ULL, 0x70902142850a64b8ULL, 0x62a64c993265a931ULL, 0x848d1a3469d323c2ULL
+	},
+	{
+		0x848d1a3469d323c2ULL, 0x3257ae5cb973d599ULL, 0x55fffefdfaf5bf2aULL, 0x3a4f9e3d7af4d39dULL,
+		0xd868d0a04081da6cULL, 0xe3254a952a554971ULL, 0x808102040810a0c0ULL, 0xaef2e5ca9429fc57ULL,
+		0x173871e3c68c0e0bULL, 0xaafefdfaf5ea7f55ULL, 0x1a2e5dba74e8cb8dULL, 0x0102040810204080ULL,
+		0x759e3d7af4e9a73aULL, 0xcb5cb973e7ce5765ULL, 0xcc54a953a64c5566ULL, 0x143c79f3e6cd8f0aULL
+	},
+	{
+		0x143c79f3e6cd8f0aULL, 0x44cd9b366ddbf3a2ULL, 0xa2e6cd9b366d7951ULL, 0xa0e0c183060cb8d0ULL,
+		0x1b2c59b264c88b0dULL, 0x7e82050b172f203fULL, 0x4fd1a3478e1d74a7ULL, 0x94bd7bf7eedd2fcaULL,
+		0xef3162c48811cc77ULL, 0x0304081020418101ULL, 0x060a142851a24283ULL, 0xbcc48811234631deULL,
+		0x2061c3870e1c1810ULL, 0x808102040810a0c0ULL, 0x5beddab468d0fbadULL, 0x0c142851a2448506ULL
+	},
+	{
+		0x0c142851a2448506ULL, 0xabfcf9f2e5ca3fd5ULL, 0x345dba74e8d1971aULL, 0xf113274e9d3a84f8ULL,
+		0x40c183060c1870a0ULL, 0x798a152b56ad223cULL, 0x1a2e5dba74e8cb8dULL, 0x43c58b162c59f1a1ULL,
+		0xabfcf9f2e5ca3fd5ULL, 0xe3254a952a554971ULL, 0x67a850a143866ab3ULL, 0x64ac58b163c7ebb2ULL,
+		0x5ce5ca942952f9aeULL, 0x73942952a54be5b9ULL, 0xf01123468d1ac478ULL, 0xe42d5ab56bd74b72ULL
+	},
+	{
+		0xe42d5ab56bd74b72ULL, 0x42c78f1e3c79b121ULL, 0x4cd5ab57ae5cf5a6ULL, 0x50f1e2c58b167ca8ULL,
+		0x3f4182050b17101fULL, 0xf80913274e9dc27cULL, 0xb3d4a850a14335d9ULL, 0xfe03070f1f3f80ffULL,
+		0xaafefdfaf5ea7f55ULL, 0x4fd1a3478e1d74a7ULL, 0x297bf7eeddbb5e94ULL, 0xdf60c0800103d86fULL,
+		0xaafefdfaf5ea7f55ULL, 0x384992254a95121cULL, 0x94bd7bf7eedd2fcaULL, 0xbec284091327f05fULL
+	},
+	{
+		0xbec284091327f05fULL, 0x0d162c59b264c586ULL, 0xf7193366cc98c67bULL, 0x70902142850a64b8ULL,
+		0x3b4d9a356ad4931dULL, 0x173871e3c68c0e0bULL, 0x8f9122458a15a4c7ULL, 0x0d162c59b264c586ULL,
+		0x61a2448912242830ULL, 0x143c79f3e6cd8f0aULL, 0x384992254a95121cULL, 0x0102040810204080ULL,
+		0xb4dcb870e0c137daULL, 0x96bb77efdebcee4bULL, 0x8d972e5dba746546ULL, 0x7d860d1b376ea13eULL
+	},
+	{
+		0x7d860d1b376ea13eULL, 0xaafefdfaf5ea7f55ULL, 0xbec284091327f05fULL, 0xf90b172f5ebd82fcULL,
+		0x173871e3c68c0e0bULL, 0x3051a24489121418ULL, 0x2267cf9f3e7dd991ULL, 0xf2172f5ebd7b05f9ULL,
+		0x60a04081020468b0ULL, 0x1c244992254a890eULL, 0x2163c78f1e3c5890ULL, 0x3355aa54a9539519ULL,
+		0x66aa54a953a62a33ULL, 0xbace9c3972e4735dULL, 0x256fdfbf7fffdb92ULL, 0x99ab57ae5cb9ea4cULL
+	},
+	{
+		0x99ab57ae5cb9ea4cULL, 0x2769d3a74f9e1a13ULL, 0xfe03070f1f3f80ffULL, 0xd47cf8f1e2c55f6aULL,
+		0x50f1e2c58b167ca8ULL, 0xa4ecd9b367cf3bd2ULL, 0xcf50a143860dd467ULL, 0xbbcc983162c433ddULL,
+		0x769a356ad4a8263bULL, 0xf90b172f5ebd82fcULL, 0xe3254a952a554971ULL, 0x92b76fdfbf7f6d49ULL,
+		0x9aaf5fbe7cf86b4dULL, 0x0c142851a2448506ULL, 0xee3366cc98318cf7ULL, 0x7f800103070f60bfULL
+	},
+	{
+		0x7f800103070f60bfULL, 0xc7489122458ad263ULL, 0xfc050b172f5e417eULL, 0x68b870e0c1836eb4ULL,
+		0x63a448912245e9b1ULL, 0xb4dcb870e0c137daULL, 0xff0103070f1fc07fULL, 0xb0d0a0408102b4d8ULL,
+		0x2365cb972e5d9911ULL, 0x091a3469d3a74684ULL, 0xa2e6cd9b366d7951ULL, 0x0708102041820203ULL,
+		0x256fdfbf7fffdb92ULL, 0x0c142851a2448506ULL, 0xd778f0e1c284de6bULL, 0xb0d0a0408102b4d8ULL
+	},
+	{
+		0xb0d0a0408102b4d8ULL, 0x63a448912245e9b1ULL, 0x6abe7cf8f1e2af35ULL, 0x0b1c3871e3c68705ULL,
+		0x3355aa54a9539519ULL, 0xc64a952a55aa92e3ULL, 0xc95ab56bd7af96e4ULL, 0x4fd1a3478e1d74a7ULL,
+		0xe52f5ebd7bf70bf2ULL, 0x93b56bd7af5f2dc9ULL, 0x749c3972e4c9e7baULL, 0x0708102041820203ULL,
+		0x5ce5ca942952f9aeULL, 0xd276ecd9b3671de9ULL, 0xa1e2c58b162cf850ULL, 0xcb5cb973e7ce5765ULL
+	},
+	{
+		0xcb5cb973e7ce5765ULL, 0x67a850a143866ab3ULL, 0xc54e9d3a75eb13e2ULL, 0x3a4f9e3d7af4d39dULL,
+		0x47c993264d9a72a3ULL, 0xacf4e9d2a4483dd6ULL, 0x3c458a152b56911eULL, 0x02060c183061c181ULL,
+		0x68b870e0c1836eb4ULL, 0x2e73e7ce9c395c97ULL, 0x69ba74e8d1a32e34ULL, 0xeb3d7af4e9d24f75ULL,
+		0x4bddbb77efdef7a5ULL, 0x0c142851a2448506ULL, 0x749c3972e4c9e7baULL, 0x769a356ad4a8263bULL
+	},
+	{
+		0x769a356ad4a8263bULL, 0x798a152b56ad223cULL, 0xc44c993265cb5362ULL, 0x46cb972e5dba3223ULL,
+		0x7d860d1b376ea13eULL, 0x45cf9f3e7dfbb322ULL, 0x95bf7ffffefd6f4aULL, 0x4adfbf7ffffeb725ULL,
+		0x1c244992254a890eULL, 0x1e22458a152b488fULL, 0x173871e3c68c0e0bULL, 0x6bbc78f0e1c2efb5ULL,
+		0xacf4e9d2a4483dd6ULL, 0xc858b163c78fd664ULL, 0xaff0e1c28409bcd7ULL, 0xc64a952a55aa92e3ULL
+	},
+	{
+		0xc64a952a55aa92e3ULL, 0xd868d0a04081da6cULL, 0x77983162c48866bbULL, 0xb0d0a0408102b4d8ULL,
+		0x5aefdebc78f0bb2dULL, 0xda6edcb870e01bedULL, 0x0102040810204080ULL, 0x53f5ead5ab57fda9ULL,
+		0x0102040810204080ULL, 0xda6edcb870e01bedULL, 0x5aefdebc78f0bb2dULL, 0xb0d0a0408102b4d8ULL,
+		0x77983162c48866bbULL, 0xd868d0a04081da6cULL, 0xc64a952a55aa92e3ULL, 0x0102040810204080ULL
+	}
+};
+
+static const uint64 kuznyechik_gfni_il[16][16] = {
+	{
+		0x0102040810204080ULL, 0xc64a952a55aa92e3ULL, 0xd868d0a04081da6cULL, 0x77983162c48866bbULL,
+		0xb0d0a0408102b4d8ULL, 0x5aefdebc78f0bb2dULL, 0xda6edcb870e01bedULL, 0x0102040810204080ULL,
+		0x53f5ead5ab57fda9ULL, 0x0102040810204080ULL, 0xda6edcb870e01bedULL, 0x5aefdebc78f0bb2dULL,
+		0xb0d0a0408102b4d8ULL, 0x77983162c48866bbULL, 0xd868d0a04081da6cULL, 0xc64a952a55aa92e3ULL
+	},
+	{
+		0xc64a952a55aa92e3ULL, 0xaff0e1c28409bcd7ULL, 0xc858b163c78fd664ULL, 0xacf4e9d2a4483dd6ULL,
+		0x6bbc78f0e1c2efb5ULL, 0x173871e3c68c0e0bULL, 0x1e22458a152b488fULL, 0x1c244992254a890eULL,
+		0x4adfbf7ffffeb725ULL, 0x95bf7ffffefd6f4aULL, 0x45cf9f3e7dfbb322ULL, 0x7d860d1b376ea13eULL,
+		0x46cb972e5dba3223ULL, 0xc44c993265cb5362ULL, 0x798a152b56ad223cULL, 0x769a356ad4a8263bULL
+	},
+	{
+		0x769a356ad4a8263bULL, 0x749c3972e4c9e7baULL, 0x0c142851a2448506ULL, 0x4bddbb77efdef7a5ULL,
+		0xeb3d7af4e9d24f75ULL, 0x69ba74e8d1a32e34ULL, 0x2e73e7ce9c395c97ULL, 0x68b870e0c1836eb4ULL,
+		0x02060c183061c181ULL, 0x3c458a152b56911eULL, 0xacf4e9d2a4483dd6ULL, 0x47c993264d9a72a3ULL,
+		0x3a4f9e3d7af4d39dULL, 0xc54e9d3a75eb13e2ULL, 0x67a850a143866ab3ULL, 0xcb5cb973e7ce5765ULL
+	},
+	{
+		0xcb5cb973e7ce5765ULL, 0xa1e2c58b162cf850ULL, 0xd276ecd9b3671de9ULL, 0x5ce5ca942952f9aeULL,
+		0x0708102041820203ULL, 0x749c3972e4c9e7baULL, 0x93b56bd7af5f2dc9ULL, 0xe52f5ebd7bf70bf2ULL,
+		0x4fd1a3478e1d74a7ULL, 0xc95ab56bd7af96e4ULL, 0xc64a952a55aa92e3ULL, 0x3355aa54a9539519ULL,
+		0x0b1c3871e3c68705ULL, 0x6abe7cf8f1e2af35ULL, 0x63a448912245e9b1ULL, 0xb0d0a0408102b4d8ULL
+	},
+	{
+		0xb0d0a0408102b4d8ULL, 0xd778f0e1c284de6bULL, 0x0c142851a2448506ULL, 0x256fdfbf7fffdb92ULL,
+		0x0708102041820203ULL, 0xa2e6cd9b366d7951ULL, 0x091a3469d3a74684ULL, 0x2365cb972e5d9911ULL,
+		0xb0d0a0408102b4d8ULL, 0xff0103070f1fc07fULL, 0xb4dcb870e0c137daULL, 0x63a448912245e9b1ULL,
+		0x68b870e0c1836eb4ULL, 0xfc050b172f5e417eULL, 0xc7489122458ad263ULL, 0x7f800103070f60bfULL
+	},
+	{
+		0x7f800103070f60bfULL, 0xee3366cc98318cf7ULL, 0x0c142851a2448506ULL, 0x9aaf5fbe7cf86b4dULL,
+		0x92b76fdfbf7f6d49ULL, 0xe3254a952a554971ULL, 0xf90b172f5ebd82fcULL, 0x769a356ad4a8263bULL,
+		0xbbcc983162c433ddULL, 0xcf50a143860dd467ULL, 0xa4ecd9b367cf3bd2ULL, 0x50f1e2c58b167ca8ULL,
+		0xd47cf8f1e2c55f6aULL, 0xfe03070f1f3f80ffULL, 0x2769d3a74f9e1a13ULL, 0x99ab57ae5cb9ea4cULL
+	},
+	{
+		0x99ab57ae5cb9ea4cULL, 0x256fdfbf7fffdb92ULL, 0xbace9c3972e4735dULL, 0x66aa54a953a62a33ULL,
+		0x3355aa54a9539519ULL, 0x2163c78f1e3c5890ULL, 0x1c244992254a890eULL, 0x60a04081020468b0ULL,
+		0xf2172f5ebd7b05f9ULL, 0x2267cf9f3e7dd991ULL, 0x3051a24489121418ULL, 0x173871e3c68c0e0bULL,
+		0xf90b172f5ebd82fcULL, 0xbec284091327f05fULL, 0xaafefdfaf5ea7f55ULL, 0x7d860d1b376ea13eULL
+	},
+	{
+		0x7d860d1b376ea13eULL, 0x8d972e5dba746546ULL, 0x96bb77efdebcee4bULL, 0xb4dcb870e0c137daULL,
+		0x0102040810204080ULL, 0x384992254a95121cULL, 0x143c79f3e6cd8f0aULL, 0x61a2448912242830ULL,
+		0x0d162c59b264c586ULL, 0x8f9122458a15a4c7ULL, 0x173871e3c68c0e0bULL, 0x3b4d9a356ad4931dULL,
+		0x70902142850a64b8ULL, 0xf7193366cc98c67bULL, 0x0d162c59b264c586ULL, 0xbec284091327f05fULL
+	},
+	{
+		0xbec284091327f05fULL, 0x94bd7bf7eedd2fcaULL, 0x384992254a95121cULL, 0xaafefdfaf5ea7f55ULL,
+		0xdf60c0800103d86fULL, 0x297bf7eeddbb5e94ULL, 0x4fd1a3478e1d74a7ULL, 0xaafefdfaf5ea7f55ULL,
+		0xfe03070f1f3f80ffULL, 0xb3d4a850a14335d9ULL, 0xf80913274e9dc27cULL, 0x3f4182050b17101fULL,
+		0x50f1e2c58b167ca8ULL, 0x4cd5ab57ae5cf5a6ULL, 0x42c78f1e3c79b121ULL, 0xe42d5ab56bd74b72ULL
+	},
+	{
+		0xe42d5ab56bd74b72ULL, 0xf01123468d1ac478ULL, 0x73942952a54be5b9ULL, 0x5ce5ca942952f9aeULL,
+		0x64ac58b163c7ebb2ULL, 0x67a850a143866ab3ULL, 0xe3254a952a554971ULL, 0xabfcf9f2e5ca3fd5ULL,
+		0x43c58b162c59f1a1ULL, 0x1a2e5dba74e8cb8dULL, 0x798a152b56ad223cULL, 0x40c183060c1870a0ULL,
+		0xf113274e9d3a84f8ULL, 0x345dba74e8d1971aULL, 0xabfcf9f2e5ca3fd5ULL, 0x0c142851a2448506ULL
+	},
+	{
+		0x0c142851a2448506ULL, 0x5beddab468d0fbadULL, 0x808102040810a0c0ULL, 0x2061c3870e1c1810ULL,
+		0xbcc48811234631deULL, 0x060a142851a24283ULL, 0x0304081020418101ULL, 0xef3162c48811cc77ULL,
+		0x94bd7bf7eedd2fcaULL, 0x4fd1a3478e1d74a7ULL, 0x7e82050b172f203fULL, 0x1b2c59b264c88b0dULL,
+		0xa0e0c183060cb8d0ULL, 0xa2e6cd9b366d7951ULL, 0x44cd9b366ddbf3a2ULL, 0x143c79f3e6cd8f0aULL
+	},
+	{
+		0x143c79f3e6cd8f0aULL, 0xcc54a953a64c5566ULL, 0xcb5cb973e7ce5765ULL, 0x759e3d7af4e9a73aULL,
+		0x0102040810204080ULL, 0x1a2e5dba74e8cb8dULL, 0xaafefdfaf5ea7f55ULL, 0x173871e3c68c0e0bULL,
+		0xaef2e5ca9429fc57ULL, 0x808102040810a0c0ULL, 0xe3254a952a554971ULL, 0xd868d0a04081da6cULL,
+		0x3a4f9e3d7af4d39dULL, 0x55fffefdfaf5bf2aULL, 0x3257ae5cb973d599ULL, 0x848d1a3469d323c2ULL
+	},
+	{
+		0x848d1a3469d323c2ULL, 0x62a64c993265a931ULL, 0x70902142850a64b8ULL, 0x41c3870e1c383020ULL,
+		0x0d162c59b264c586ULL, 0xf2172f5ebd7b05f9ULL, 0x2b7dfbf6edda9f15ULL, 0x2e73e7ce9c395c97ULL,
+		0x54fdfaf5ead5ffaaULL, 0x2a7ffffefdfadf95ULL, 0xb1d2a4489122f458ULL, 0x103061c3870e0c08ULL,
+		0xa0e0c183060cb8d0ULL, 0xb0d0a0408102b4d8ULL, 0xe93b76ecd9b38ef4ULL, 0x44cd9b366ddbf3a2ULL
+	},
+	{
+		0x44cd9b366ddbf3a2ULL, 0x83850a14285121c1ULL, 0x68b870e0c1836eb4ULL, 0x2769d3a74f9e1a13ULL,
+		0x55fffefdfaf5bf2aULL, 0x68b870e0c1836eb4ULL, 0x355fbe7cf8f1d79aULL, 0x6fb060c080016cb7ULL,
+		0x394b962d5ab5529cULL, 0x103061c3870e0c08ULL, 0xed376edcb8700df6ULL, 0xd47cf8f1e2c55f6aULL,
+		0x040c183061c38302ULL, 0xf7193366cc98c67bULL, 0xbace9c3972e4735dULL, 0xee3366cc98318cf7ULL
+	},
+	{
+		0xee3366cc98318cf7ULL, 0x6abe7cf8f1e2af35ULL, 0xacf4e9d2a4483dd6ULL, 0xf61b376edcb886fbULL,
+		0x798a152b56ad223cULL, 0xbec284091327f05fULL, 0x749c3972e4c9e7baULL, 0xdb6cd8b060c05b6dULL,
+		0xa6ead5ab57aefa53ULL, 0xd778f0e1c284de6bULL, 0x0c142851a2448506ULL, 0x060a142851a24283ULL,
+		0x8a9f3e7dfbf66745ULL, 0x9aaf5fbe7cf86b4dULL, 0xd868d0a04081da6cULL, 0x94bd7bf7eedd2fcaULL
+	},
+	{
+		0x94bd7bf7eedd2fcaULL, 0xcd56ad5bb66c15e6ULL, 0x96bb77efdebcee4bULL, 0xe2274e9d3a7509f1ULL,
+		0x0f10204182050407ULL, 0xf2172f5ebd7b05f9ULL, 0xff0103070f1fc07fULL, 0xe02142850a14c870ULL,
+		0x3355aa54a9539519ULL, 0x3257ae5cb973d599ULL, 0x96bb77efdebcee4bULL, 0x878912244992a2c3ULL,
+		0xff0103070f1fc07fULL, 0xc44c993265cb5362ULL, 0x66aa54a953a62a33ULL, 0xfb0d1b376edc437dULL
+	}
+};
+
+VC_INLINE __m512i kuznyechik_gfni_sbox (__m512i x, const __m512i t[4])
+{
+	__m512i lo = _mm512_permutex2var_epi8 (t[0], x, t[1]);
+	__m512i hi = _mm512_permutex2var_epi8 (t[2], x, t[3]);
+	return _mm512_mask_blend_epi8 (_mm512_movepi8_mask (x), lo, hi);
+}
+
+VC_INLINE void kuznyechik_gfni_linear (__m512i x[16], const uint64 m[16][16])
+{
+	__m512i y[16];
+	int i, j;
+
+	for (i = 0; i < 16; i++)
+	{
+		__m512i acc = _mm512_gf2p8affine_epi64_epi8 (x[0], _mm512_set1_epi64 ((long long) m[i][0]), 0);
+
+		for (j = 1; j < 15; j += 2)
+		{
+			acc = _mm512_ternarylogic_epi64 (acc,
+				_mm512_gf2p8affine_epi64_epi8 (x[j], _mm512_set1_epi64 ((long long) m[i][j]), 0),
+				_mm512_gf2p8affine_epi64_epi8 (x[j + 1], _mm512_set1_epi64 ((long long) m[i][j + 1]), 0), 0x96);
+		}
+
+		y[i] = _mm512_xor_si512 (acc, _mm512_gf2p8affine_epi64_epi8 (x[15], _mm512_set1_epi64 ((long long) m[i][15]), 0));
+	}
+
+	for (i = 0; i < 16; i++)
+		x[i] = y[i];
+}
+
+VC_INLINE void kuznyechik_gfni_add_key (__m512i x[16], const uint64 *key)
+{
+	const uint8 *k = (const uint8 *) key;
+	int j;
+
+	for (j = 0; j < 16; j++)
+		x[j] = _mm512_xor_si512 (x[j], _mm512_set1_epi8 ((char) k[j]));
+}
+
+/* Transposes the 16x16 byte matrix held in each 128-bit lane of x[0..15]. Every pass rotates the
+   8-bit (register, byte) index by one bit, so four passes exchange the register and byte indices.
+   The transform is its own inverse. */
+VC_INLINE void kuznyechik_gfni_transpose (__m512i x[16])
+{
+	__m512i t[16];
+	int pass, i;
+
+	for (pass = 0; pass < 4; pass++)
+	{
+		for (i = 0; i < 8; i++)
+		{
+			t[2 * i] = _mm512_unpacklo_epi8 (x[i], x[i + 8]);
+			t[2 * i + 1] = _mm512_unpackhi_epi8 (x[i], x[i + 8]);
+		}
+
+		for (i = 0; i < 16; i++)
+			x[i] = t[i];
+	}
+}
+
+VC_INLINE void kuznyechik_gfni_load_sbox (__m512i t[4], const uint8 *s)
+{
+	int i;
+	for (i = 0; i < 4; i++)
+		t[i] = _mm512_load_si512 ((const void *) (s + 64 * i));
+}
+
+int kuznyechik_has_gfni ()
+{
+	return 1;
+}
+
+void kuznyechik_gfni_encrypt_blocks_64 (uint8 *out, const uint8 *in, kuznyechik_kds *kds)
+{
+	__m512i x[16], s[4];
+	int i, round;
+
+	kuznyechik_gfni_load_sbox (s, kuznyechik_gfni_s);
+
+	// Register i holds blocks 4i..4i+3; after the transpose, lane l of x[j] holds byte j of blocks l, l+4, .., l+60
+	for (i = 0; i < 16; i++)
+		x[i] = _mm512_loadu_si512 ((const void *) (in + 64 * i));
+	kuznyechik_gfni_transpose (x);
+
+	for (round = 0; round < 9; round++)
+	{
+		kuznyechik_gfni_add_key (x, kds->rke + 2 * round);
+		for (i = 0; i < 16; i++)
+			x[i] = kuznyechik_gfni_sbox (x[i], s);
+		kuznyechik_gfni_linear (x, kuznyechik_gfni_l);
+	}
+	kuznyechik_gfni_add_key (x, kds->rke + 18);
+
+	kuznyechik_gfni_transpose (x);
+	for (i = 0; i < 16; i++)
+		_mm512_storeu_si512 ((void *) (out + 64 * i), x[i]);
+}
+
+void kuznyechik_gfni_decrypt_blocks_64 (uint8 *out, const uint8 *in, kuznyechik_kds *kds)
+{
+	__m512i x[16], s[4];
+	int i, round;
+
+	kuznyechik_gfni_load_sbox (s, kuznyechik_gfni_is);
+
+	for (i = 0; i < 16; i++)
+		x[i] = _mm512_loadu_si512 ((const void *) (in + 64 * i));
+	kuznyechik_gfni_transpose (x);
+
+	kuznyechik_gfni_add_key (x, kds->rke + 18);
+	for (round = 8; round >= 0; round--)
+	{
+		kuznyechik_gfni_linear (x, kuznyechik_gfni_il);
+		for (i = 0; i < 16; i++)
+			x[i] = kuznyechik_gfni_sbox (x[i], s);
+		kuznyechik_gfni_add_key (x, kds->rke + 2 * round);
+	}
+
+	kuznyechik_gfni_transpose (x);
+	for (i = 0; i < 16; i++)
+		_mm512_storeu_si512 ((void *) (out + 64 * i), x[i]);
+}
+
+#else
+
+int kuznyechik_has_gfni ()
+{
+	return 0;
+}
+
+void kuznyechik_gfni_encrypt_blocks_64 (uint8 *out, const uint8 *in, kuznyechik_kds *kds)
+{
+}
+
+void kuznyechik_gfni_decrypt_blocks_64 (uint8 *out, const uint8 *in, kuznyechik_kds *kds)
+{
+}
+
+#endif
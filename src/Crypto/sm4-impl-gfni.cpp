@@ -0,0 +1,164 @@
+/*
+ VeraCrypt source code
+ Copyright (c) 2026 AM Crypto
+
+ This file is part of VeraCrypt and is governed by the Apache License 2.0
+ the full text of which is contained in the file License.txt included in
+ VeraCrypt binary and source code distribution packages.
+*/
+
+/* SM4 processing 16 blocks in parallel using AVX2 and GFNI.
+ *
+ * The SM4 S-box is affine equivalent to the inversion in GF(2^8), so it is evaluated on all
+ * 32 bytes of a register with an affine pre-filter (GF2P8AFFINEQB) followed by an inversion
+ * with an affine post-filter (GF2P8AFFINEINVQB), instead of going through AESENCLAST and two
+ * table based affine transforms on 128-bit registers as done in sm4-impl-aesni.cpp.
+ *
+ * Two groups of 8 blocks are kept in word-sliced form: register xN holds word N of 8 blocks.
+ * The round keys are the ones produced by sm4_set_key_aesni.
+ */
+
+#include "sm4.h"
+#include "Common/Endian.h"
+#include "misc.h"
+#include "cpu.h"
+
+#if CRYPTOPP_BOOL_X64 && !defined(CRYPTOPP_DISABLE_ASM) && defined(__AVX2__) && (defined(__GFNI__) || defined(_MSC_VER))
+
+#include <immintrin.h>
+
+extern "C" void sm4_encrypt_blocks_aesni(uint8* out, const uint8* in, size_t blocks, sm4_kds* kds);
+extern "C" void sm4_decrypt_blocks_aesni(uint8* out, const uint8* in, size_t blocks, sm4_kds* kds);
+
+/* S(x) = POST * inv(PRE * x + 0x65) + 0xd3 */
+#define SM4_GFNI_PRE	0x34ac259e022dbc52ULL
+#define SM4_GFNI_POST	0xd72d8e511e6c8b19ULL
+
+#define SM4_GFNI_ROTL(x, n)	_mm256_or_si256 (_mm256_slli_epi32 ((x), (n)), _mm256_srli_epi32 ((x), 32 - (n)))
+
+/* T(x) = L(S(x)) with L(b) = b ^ rol(b, 2) ^ rol(b, 10) ^ rol(b, 18) ^ rol(b, 24) */
+static inline __m256i sm4_gfni_t(__m256i x, __m256i rol8, __m256i rol16, __m256i rol24)
+{
+	__m256i b = _mm256_gf2p8affine_epi64_epi8(x, _mm256_set1_epi64x((long long) SM4_GFNI_PRE), 0x65);
+	b = _mm256_gf2p8affineinv_epi64_epi8(b, _mm256_set1_epi64x((long long) SM4_GFNI_POST), 0xd3);
+
+	__m256i r2 = SM4_GFNI_ROTL(b, 2);
+	__m256i t = _mm256_xor_si256(r2, _mm256_shuffle_epi8(r2, rol8));
+	t = _mm256_xor_si256(t, _mm256_shuffle_epi8(r2, rol16));
+	return _mm256_xor_si256(_mm256_xor_si256(b, t), _mm256_shuffle_epi8(b, rol24));
+}
+
+/* x0 ^= T(x1 ^ x2 ^ x3 ^ rk) for both groups */
+#define SM4_GFNI_ROUND(x0, x1, x2, x3, rk) \
+	k = _mm256_set1_epi32((int) (rk)); \
+	x0##0 = _mm256_xor_si256(x0##0, sm4_gfni_t(_mm256_xor_si256(_mm256_xor_si256(x1##0, x2##0), _mm256_xor_si256(x3##0, k)), rol8, rol16, rol24)); \
+	x0##1 = _mm256_xor_si256(x0##1, sm4_gfni_t(_mm256_xor_si256(_mm256_xor_si256(x1##1, x2##1), _mm256_xor_si256(x3##1, k)), rol8, rol16, rol24));
+
+/* Converts 8 consecutive blocks to word-sliced form and back (the transform is its own inverse) */
+static inline void sm4_gfni_transpose(__m256i& b0, __m256i& b1, __m256i& b2, __m256i& b3)
+{
+	__m256i t0 = _mm256_unpacklo_epi32(b0, b1);
+	__m256i t1 = _mm256_unpacklo_epi32(b2, b3);
+	__m256i t2 = _mm256_unpackhi_epi32(b0, b1);
+	__m256i t3 = _mm256_unpackhi_epi32(b2, b3);
+	b0 = _mm256_unpacklo_epi64(t0, t1);
+	b1 = _mm256_unpackhi_epi64(t0, t1);
+	b2 = _mm256_unpacklo_epi64(t2, t3);
+	b3 = _mm256_unpackhi_epi64(t2, t3);
+}
+
+static inline void sm4_gfni_load(const uint8* in, __m256i bswap, __m256i& b0, __m256i& b1, __m256i& b2, __m256i& b3)
+{
+	b0 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*) in), bswap);
+	b1 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*) (in + 32)), bswap);
+	b2 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*) (in + 64)), bswap);
+	b3 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*) (in + 96)), bswap);
+	sm4_gfni_transpose(b0, b1, b2, b3);
+}
+
+static inline void sm4_gfni_store(uint8* out, __m256i bswap, __m256i b0, __m256i b1, __m256i b2, __m256i b3)
+{
+	sm4_gfni_transpose(b0, b1, b2, b3);
+	_mm256_storeu_si256((__m256i*) out, _mm256_shuffle_epi8(b0, bswap));
+	_mm256_storeu_si256((__m256i*) (out + 32), _mm256_shuffle_epi8(b1, bswap));
+	_mm256_storeu_si256((__m256i*) (out + 64), _mm256_shuffle_epi8(b2, bswap));
+	_mm256_storeu_si256((__m256i*) (out + 96), _mm256_shuffle_epi8(b3, bswap));
+}
+
+static void sm4_gfni_process_16(uint8* out, const uint8* in, const uint32* rk)
+{
+	const __m256i bswap = _mm256_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+		12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+	const __m256i rol8 = _mm256_set_epi8(14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3,
+		14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3);
+	const __m256i rol16 = _mm256_set_epi8(13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2,
+		13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2);
+	const __m256i rol24 = _mm256_set_epi8(12, 15, 14, 13, 8, 11, 10, 9, 4, 7, 6, 5, 0, 3, 2, 1,
+		12, 15, 14, 13, 8, 11, 10, 9, 4, 7, 6, 5, 0, 3, 2, 1);
+	__m256i x00, x10, x20, x30, x01, x11, x21, x31, k;
+
+	sm4_gfni_load(in, bswap, x00, x10, x20, x30);
+	sm4_gfni_load(in + 128, bswap, x01, x11, x21, x31);
+
+	for (int i = 0; i < 32; i += 4)
+	{
+		SM4_GFNI_ROUND(x0, x1, x2, x3, rk[i]);
+		SM4_GFNI_ROUND(x1, x2, x3, x0, rk[i + 1]);
+		SM4_GFNI_ROUND(x2, x3, x0, x1, rk[i + 2]);
+		SM4_GFNI_ROUND(x3, x0, x1, x2, rk[i + 3]);
+	}
+
+	// the output is (X35, X34, X33, X32)
+	sm4_gfni_store(out, bswap, x30, x20, x10, x00);
+	sm4_gfni_store(out + 128, bswap, x31, x21, x11, x01);
+}
+
+extern "C" int sm4_has_gfni()
+{
+	return 1;
+}
+
+extern "C" void sm4_encrypt_blocks_gfni(uint8* out, const uint8* in, size_t blocks, sm4_kds* kds)
+{
+	while (blocks >= 16)
+	{
+		sm4_gfni_process_16(out, in, kds->m_rEnckeys);
+		in += 256;
+		out += 256;
+		blocks -= 16;
+	}
+
+	if (blocks)
+		sm4_encrypt_blocks_aesni(out, in, blocks, kds);
+}
+
+extern "C" void sm4_decrypt_blocks_gfni(uint8* out, const uint8* in, size_t blocks, sm4_kds* kds)
+{
+	while (blocks >= 16)
+	{
+		sm4_gfni_process_16(out, in, kds->m_rDeckeys);
+		in += 256;
+		out += 256;
+		blocks -= 16;
+	}
+
+	if (blocks)
+		sm4_decrypt_blocks_aesni(out, in, blocks, kds);
+}
+
+#else
+
+extern "C" int sm4_has_gfni()
+{
+	return 0;
+}
+
+extern "C" void sm4_encrypt_blocks_gfni(uint8* out, const uint8* in, size_t blocks, sm4_kds* kds)
+{
+}
+
+extern "C" void sm4_decrypt_blocks_gfni(uint8* out, const uint8* in, size_t blocks, sm4_kds* kds)
+{
+}
+
+#endif
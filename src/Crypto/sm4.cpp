@@ -32,6 +32,20 @@ extern "C" void sm4_encrypt_blocks_aesni(uint8* out, const uint8* in, size_t blo
 extern "C" void sm4_decrypt_block_aesni(uint8* out, const uint8* in, sm4_kds* kds);
 extern "C" void sm4_decrypt_blocks_aesni(uint8* out, const uint8* in, size_t blocks, sm4_kds* kds);
 extern "C" void sm4_set_key_aesni(const uint8* key, sm4_kds* kds);
+extern "C" int sm4_has_gfni();
+extern "C" void sm4_encrypt_blocks_gfni(uint8* out, const uint8* in, size_t blocks, sm4_kds* kds);
+extern "C" void sm4_decrypt_blocks_gfni(uint8* out, const uint8* in, size_t blocks, sm4_kds* kds);
+
+// Conditions under which sm4_set_key selects each implementation, also reported by the kernel registry
+extern "C" int sm4_aesni_available()
+{
+	return HasSSE41() && HasAESNI();
+}
+
+extern "C" int sm4_gfni_available()
+{
+	return sm4_aesni_available() && HasSAVX2() && HasGFNI() && sm4_has_gfni();
+}
 
 #endif
 
@@ -239,13 +253,20 @@ extern "C" void sm4_set_key(const uint8* key, sm4_kds* kds)
 	if (!sm4_set_key_std_ptr)
 	{
 #if CRYPTOPP_BOOL_X64 || CRYPTOPP_BOOL_X86 || CRYPTOPP_BOOL_X32
-        if (HasSSE41() && HasAESNI())
+        if (sm4_aesni_available())
 		{
 			sm4_set_key_std_ptr = sm4_set_key_aesni;
 			sm4_encrypt_block_std_ptr = sm4_encrypt_block_aesni;
 			sm4_encrypt_blocks_std_ptr = sm4_encrypt_blocks_aesni;
 			sm4_decrypt_block_std_ptr = sm4_decrypt_block_aesni;
 			sm4_decrypt_blocks_std_ptr = sm4_decrypt_blocks_aesni;
+
+			// 16 blocks per iteration using GFNI for the S-box, smaller requests are handled by the AES-NI code
+			if (sm4_gfni_available())
+			{
+				sm4_encrypt_blocks_std_ptr = sm4_encrypt_blocks_gfni;
+				sm4_decrypt_blocks_std_ptr = sm4_decrypt_blocks_gfni;
+			}
 		}
 		else
 #endif
@@ -24,6 +24,21 @@ namespace VeraCrypt
 {
 	static shared_ptr <Pkcs5Kdf> FindKdfAlgorithm (const wxString &name)
 	{
+#ifndef VC_DCS_DISABLE_ARGON2
+		// Argon2 with several lanes is selected as argon2:LANES or argon2id:LANES
+		wxString lanes;
+		if (name.Lower().StartsWith (L"argon2:", &lanes) || name.Lower().StartsWith (L"argon2id:", &lanes))
+		{
+			try
+			{
+				return Pkcs5Kdf::GetAlgorithm (L"Argon2:" + wstring (lanes));
+			}
+			catch (ParameterIncorrect &)
+			{
+				return shared_ptr <Pkcs5Kdf> ();
+			}
+		}
+#endif
 		foreach (shared_ptr <Pkcs5Kdf> kdf, Pkcs5Kdf::GetAvailableAlgorithms())
 		{
 			wxString kdfName (kdf->GetName());
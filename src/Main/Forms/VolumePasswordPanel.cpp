@@ -100,7 +100,8 @@ namespace VeraCrypt
 				Pkcs5PrfChoice->Delete (0);
 				Pkcs5PrfChoice->Append (LangString["AUTODETECTION"]);
 			}
-			foreach_ref (const Pkcs5Kdf &kdf, Pkcs5Kdf::GetAvailableAlgorithms())
+			// Multi-lane Argon2 can only be selected for mounting, as it is not detected automatically
+			foreach_ref (const Pkcs5Kdf &kdf, isMountPassword ? Pkcs5Kdf::GetSelectableAlgorithms() : Pkcs5Kdf::GetAvailableAlgorithms())
 			{
 				if (!kdf.IsDeprecated() || isMountPassword)
 				{
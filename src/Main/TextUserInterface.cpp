@@ -60,6 +60,21 @@ namespace VeraCrypt
 		return true;
 	}
 
+	// A header key derived with a KDF that is not detected automatically (Argon2 on several lanes) can only be decrypted
+	// with the same KDF selected, which VeraCrypt for Windows does not offer
+	static void ConfirmKdfNotAutoDetected (const TextUserInterface *ui, const shared_ptr <Pkcs5Kdf> &kdf, bool interactive)
+	{
+		if (!kdf || kdf->IsAutoDetected())
+			return;
+
+		wxString message = StringFormatter (_("The {0} key derivation function is not detected automatically. The volume will only be mountable with --hash={0} (or with {0} selected as PKCS-5 PRF in the GUI), and VeraCrypt for Windows will not be able to mount it."), kdf->GetName());
+
+		if (!interactive)
+			ui->ShowWarning (message);
+		else if (!ui->AskYesNo (message + L"\n\n" + _("Continue?"), false, true))
+			throw UserAbort (SRC_POS);
+	}
+
 	class AdminPasswordTextRequestHandler : public GetStringFunctor
 	{
 		public:
@@ -576,6 +591,8 @@ namespace VeraCrypt
 		if (!newPassword.get() && !Preferences.NonInteractive)
 			newPassword = AskPassword (_("Enter new password"), true);
 
+		ConfirmKdfNotAutoDetected (this, newKdf, !Preferences.NonInteractive);
+
 		// New PIM
 		shared_ptr <Pkcs5Kdf> effectiveNewKdf = newKdf ? newKdf : volume->GetPkcs5Kdf();
 		bool newPimInteractive = false;
@@ -928,6 +945,8 @@ namespace VeraCrypt
 
 		}
 
+		ConfirmKdfNotAutoDetected (this, options->VolumeHeaderKdf, !Preferences.NonInteractive);
+
 		// Filesystem
 		options->FilesystemClusterSize = 0;
 		uint64 filesystemSize = layout->GetMaxDataSize (options->Size);
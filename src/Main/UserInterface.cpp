@@ -19,6 +19,9 @@
 #include <wx/apptrait.h>
 #include <wx/cmdline.h>
 #include "Crypto/cpu.h"
+#ifndef WOLFCRYPT_BACKEND
+#include "Crypto/Kernels.h"
+#endif
 #include "Platform/PlatformTest.h"
 #include "Common/PCSCException.h"
 #ifdef TC_UNIX
@@ -158,6 +161,19 @@ namespace VeraCrypt
 #endif
 	}
 
+	wxString UserInterface::CryptoKernelsToString () const
+	{
+		wstringstream s;
+#ifndef WOLFCRYPT_BACKEND
+		s << L"Crypto kernels:\n";
+
+		const CryptoKernelInfo *kernel;
+		for (size_t i = 0; (kernel = GetCryptoKernelInfo (i)) != NULL; ++i)
+			s << L" " << kernel->Primitive << L": " << kernel->Kernel << L"\n";
+#endif
+		return s.str();
+	}
+
 	void UserInterface::DismountAllVolumes (bool ignoreOpenFiles, bool interactive) const
 	{
 		try
@@ -626,6 +642,11 @@ namespace VeraCrypt
 
 #ifdef CRYPTOPP_CPUID_AVAILABLE
 		DetectX86Features ();
+
+		// Allows forcing the fallback implementations, e.g. VERACRYPT_DISABLE_CPU_FEATURES=avx512f,gfni
+		const char *disabledCpuFeatures = getenv ("VERACRYPT_DISABLE_CPU_FEATURES");
+		if (disabledCpuFeatures && !DisableCPUFeatures (disabledCpuFeatures))
+			throw_err (L"Unknown CPU feature in VERACRYPT_DISABLE_CPU_FEATURES: " + StringConverter::ToWide (string (disabledCpuFeatures)));
 #endif
 #if CRYPTOPP_BOOL_ARMV8
 		DetectArmFeatures();
@@ -1293,7 +1314,7 @@ const FileManager fileManagers[] = {
 			return true;
 
 		case CommandId::DisplayVersion:
-			ShowString (Application::GetName() + L" " + StringConverter::ToWide (Version::String()) + L"\n");
+			ShowString (Application::GetName() + L" " + StringConverter::ToWide (Version::String()) + L"\n" + CryptoKernelsToString());
 			return true;
 
 		case CommandId::DisplayVolumeProperties:
@@ -1385,10 +1406,13 @@ const FileManager fileManagers[] = {
 					" Save user preferences.\n"
 					"\n"
 					"--test\n"
-					" Test internal algorithms used in the process of encryption and decryption.\n"
+					" Test internal algorithms used in the process of encryption and decryption and\n"
+					" display the implementation selected for each of them. Implementations relying\n"
+					" on specific CPU features can be disabled by listing these features in the\n"
+					" VERACRYPT_DISABLE_CPU_FEATURES environment variable (e.g. \"avx512f,gfni\").\n"
 					"\n"
 					"--version\n"
-					" Display program version.\n"
+					" Display program version and the implementations selected for the algorithms.\n"
 					"\n"
 					"--volume-properties [MOUNTED_VOLUME]\n"
 					" Display properties of a mounted volume. See below for description of\n"
@@ -1464,6 +1488,10 @@ const FileManager fileManagers[] = {
 					" Use specified header key derivation algorithm when creating a new volume\n"
 					" or changing password and/or keyfiles. This option also specifies the\n"
 					" mixing hash of the random number generator.\n"
+					" Argon2 may be given as argon2:LANES to derive the header key on 2 to 8 lanes\n"
+					" in parallel. Such volumes are not detected automatically: they must be\n"
+					" mounted with the same --hash option (or with Argon2:LANES selected as PKCS-5\n"
+					" PRF in the GUI) and cannot be mounted by VeraCrypt for Windows.\n"
 					"\n"
 					"-k, --keyfiles=KEYFILE1[,KEYFILE2,KEYFILE3,...]\n"
 					" Use specified keyfiles when mounting a volume or when changing password\n"
@@ -1690,6 +1718,9 @@ const FileManager fileManagers[] = {
 		Preferences = preferences;
 
 		Cipher::EnableHwSupport (!preferences.DefaultMountOptions.NoHardwareCrypto);
+#ifndef WOLFCRYPT_BACKEND
+		SelectCryptoKernels ();
+#endif
 
 		PreferencesUpdatedEvent.Raise();
 	}
@@ -1793,6 +1824,7 @@ const FileManager fileManagers[] = {
 		}
 		catch (StringFormatterException&) { }
 
+		ShowString (CryptoKernelsToString());
 		ShowInfo ("TESTS_PASSED");
 	}
 
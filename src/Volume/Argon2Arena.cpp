@@ -0,0 +1,147 @@
+/*
+ VeraCrypt source code
+ Copyright (c) 2026 AM Crypto
+
+ This file is part of VeraCrypt and is governed by the Apache License 2.0
+ the full text of which is contained in the file License.txt included in
+ VeraCrypt binary and source code distribution packages.
+*/
+
+#ifdef TC_UNIX
+#	include <sys/mman.h>
+#endif
+#include "Argon2Arena.h"
+
+namespace VeraCrypt
+{
+	static const size_t Argon2ArenaHugePageSize = 2 * 1024 * 1024;
+
+	Argon2Arena::Scope::Scope ()
+	{
+		ScopeLock lock (ArenaMutex);
+		++ScopeCount;
+	}
+
+	Argon2Arena::Scope::~Scope ()
+	{
+		ScopeLock lock (ArenaMutex);
+
+		if (--ScopeCount == 0 && ArenaMemory && !ArenaUsed)
+		{
+			Unmap (ArenaMemory, ArenaSize);
+			ArenaMemory = nullptr;
+		}
+	}
+
+	int Argon2Arena::Allocate (uint8 **memory, size_t size)
+	{
+		{
+			ScopeLock lock (ArenaMutex);
+
+			if (ScopeCount > 0 && !ArenaUsed)
+			{
+				if (ArenaMemory && ArenaSize < size)
+				{
+					Unmap (ArenaMemory, ArenaSize);
+					ArenaMemory = nullptr;
+				}
+
+				if (!ArenaMemory)
+				{
+					ArenaMemory = Map (size);
+					ArenaSize = size;
+				}
+
+				if (ArenaMemory)
+				{
+					ArenaUsed = true;
+					*memory = (uint8 *) ArenaMemory;
+					return 0;
+				}
+			}
+		}
+
+		*memory = (uint8 *) Map (size);
+		return *memory ? 0 : -1;
+	}
+
+	void Argon2Arena::Free (uint8 *memory, size_t size)
+	{
+		ScopeLock lock (ArenaMutex);
+
+		if (memory == ArenaMemory)
+		{
+			ArenaUsed = false;
+
+			if (ScopeCount == 0)
+			{
+				Unmap (ArenaMemory, ArenaSize);
+				ArenaMemory = nullptr;
+			}
+		}
+		else
+		{
+			Unmap (memory, size);
+		}
+	}
+
+	size_t Argon2Arena::GetMappingSize (size_t size)
+	{
+		// A multiple of the huge page size, so that a mapping is unmapped alike whatever pages back it
+		return (size + Argon2ArenaHugePageSize - 1) & ~(Argon2ArenaHugePageSize - 1);
+	}
+
+	void *Argon2Arena::Map (size_t size)
+	{
+		if (size < 1)
+			return nullptr;
+
+#ifdef TC_UNIX
+		size_t mappingSize = GetMappingSize (size);
+		void *memory = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+		// Huge pages reserved by the administrator
+		memory = mmap (nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON | MAP_HUGETLB, -1, 0);
+#endif
+		if (memory == MAP_FAILED)
+		{
+			memory = mmap (nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+			if (memory == MAP_FAILED)
+				return nullptr;
+#ifdef MADV_HUGEPAGE
+			madvise (memory, mappingSize, MADV_HUGEPAGE);
+#endif
+		}
+
+		// Keeps the memory out of swap and faults it in at once. Failing to lock it (RLIMIT_MEMLOCK) is not an error.
+		mlock (memory, mappingSize);
+		return memory;
+#else
+		try
+		{
+			return Memory::AllocateAligned (GetMappingSize (size), Argon2ArenaHugePageSize);
+		}
+		catch (bad_alloc &)
+		{
+			return nullptr;
+		}
+#endif
+	}
+
+	void Argon2Arena::Unmap (void *memory, size_t size)
+	{
+#ifdef TC_UNIX
+		munmap (memory, GetMappingSize (size));
+#else
+		(void) size;
+		Memory::FreeAligned (memory);
+#endif
+	}
+
+	void *Argon2Arena::ArenaMemory = nullptr;
+	Mutex Argon2Arena::ArenaMutex;
+	size_t Argon2Arena::ArenaSize = 0;
+	bool Argon2Arena::ArenaUsed = false;
+	size_t Argon2Arena::ScopeCount = 0;
+}
@@ -0,0 +1,57 @@
+/*
+ VeraCrypt source code
+ Copyright (c) 2026 AM Crypto
+
+ This file is part of VeraCrypt and is governed by the Apache License 2.0
+ the full text of which is contained in the file License.txt included in
+ VeraCrypt binary and source code distribution packages.
+*/
+
+#ifndef TC_HEADER_Volume_Argon2Arena
+#define TC_HEADER_Volume_Argon2Arena
+
+#include "Platform/Platform.h"
+#include "Platform/Mutex.h"
+
+namespace VeraCrypt
+{
+	// Memory of the Argon2 key derivations (64 MiB to 1 GiB). Opening a volume may derive a header key for
+	// each layout, so the memory is kept while an Argon2Arena::Scope exists and reused by the derivations made
+	// in the meantime, instead of being mapped and faulted in again for each of them. The memory is backed by
+	// huge pages where available and locked in RAM if allowed. Argon2 wipes it before releasing it.
+	class Argon2Arena
+	{
+	public:
+		class Scope
+		{
+		public:
+			Scope ();
+			~Scope ();
+
+		private:
+			Scope (const Scope &);
+			Scope &operator= (const Scope &);
+		};
+
+		// Argon2 allocator callbacks. Memory requested outside of a scope, or while the arena is used by
+		// another derivation, is mapped for this derivation only.
+		static int Allocate (uint8 **memory, size_t size);
+		static void Free (uint8 *memory, size_t size);
+
+	protected:
+		static size_t GetMappingSize (size_t size);
+		static void *Map (size_t size);
+		static void Unmap (void *memory, size_t size);
+
+		static void *ArenaMemory;
+		static Mutex ArenaMutex;
+		static size_t ArenaSize;
+		static bool ArenaUsed;
+		static size_t ScopeCount;
+
+	private:
+		Argon2Arena ();
+	};
+}
+
+#endif // TC_HEADER_Volume_Argon2Arena
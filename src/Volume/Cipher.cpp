@@ -187,6 +187,24 @@ namespace VeraCrypt
 			Cipher::DecryptBlocks (data, blockCount);
 	}
 
+    #ifndef WOLFCRYPT_BACKEND
+	void CipherAES::DecryptBlocksXTS (const uint8 *in, uint8 *out, size_t blockCount, uint64 dataUnitNo, unsigned int startBlock, const Cipher &secondaryCipher) const
+	{
+		if (!Initialized)
+			throw NotInitialized (SRC_POS);
+
+#if defined (TC_AES_HW_CPU) && CRYPTOPP_VAES_AVAILABLE
+		if (IsXtsHwSupportAvailable())
+		{
+			const CipherAES &secondaryAES = static_cast <const CipherAES &> (secondaryCipher);
+			aes_hw_vaes_xts_decrypt (ScheduledKey.Ptr() + sizeof (aes_encrypt_ctx), secondaryAES.ScheduledKey.Ptr(), in, out, dataUnitNo, startBlock, blockCount);
+		}
+		else
+#endif
+			Cipher::DecryptBlocksXTS (in, out, blockCount, dataUnitNo, startBlock, secondaryCipher);
+	}
+    #endif
+
 	void CipherAES::Encrypt (uint8 *data) const
 	{
 #ifdef TC_AES_HW_CPU
@@ -218,6 +236,25 @@ namespace VeraCrypt
 #endif
 			Cipher::EncryptBlocks (data, blockCount);
 	}
+
+    #ifndef WOLFCRYPT_BACKEND
+	void CipherAES::EncryptBlocksXTS (const uint8 *in, uint8 *out, size_t blockCount, uint64 dataUnitNo, unsigned int startBlock, const Cipher &secondaryCipher) const
+	{
+		if (!Initialized)
+			throw NotInitialized (SRC_POS);
+
+#if defined (TC_AES_HW_CPU) && CRYPTOPP_VAES_AVAILABLE
+		if (IsXtsHwSupportAvailable())
+		{
+			const CipherAES &secondaryAES = static_cast <const CipherAES &> (secondaryCipher);
+			aes_hw_vaes_xts_encrypt (ScheduledKey.Ptr(), secondaryAES.ScheduledKey.Ptr(), in, out, dataUnitNo, startBlock, blockCount);
+		}
+		else
+#endif
+			Cipher::EncryptBlocksXTS (in, out, blockCount, dataUnitNo, startBlock, secondaryCipher);
+	}
+    #endif
+
     #ifdef WOLFCRYPT_BACKEND
         void CipherAES::EncryptXTS (uint8 *data, uint64 length, uint64 startDataUnitNo) const
 	{
@@ -261,6 +298,25 @@ namespace VeraCrypt
 #endif
 	}
 
+    #ifndef WOLFCRYPT_BACKEND
+	bool CipherAES::IsXtsHwSupportAvailable () const
+	{
+#if defined (TC_AES_HW_CPU) && CRYPTOPP_VAES_AVAILABLE
+		static bool state = false;
+		static bool stateValid = false;
+
+		if (!stateValid)
+		{
+			state = (HasAESNI() && HasAVX512F() && HasVAES() && HasVPCLMULQDQ()) ? true : false;
+			stateValid = true;
+		}
+		return state && HwSupportEnabled;
+#else
+		return false;
+#endif
+	}
+    #endif
+
 	void CipherAES::SetCipherKey (const uint8 *key)
 	{
 		if (aes_encrypt_key256 (key, (aes_encrypt_ctx *) ScheduledKey.Ptr()) != EXIT_SUCCESS)
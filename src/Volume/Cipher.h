@@ -29,6 +29,9 @@ namespace VeraCrypt
 		virtual void DecryptBlock (uint8 *data) const;
 		virtual void DecryptBlocks (uint8 *data, size_t blockCount) const;
             #ifndef WOLFCRYPT_BACKEND
+		virtual void DecryptBlocksXTS (const uint8 *in, uint8 *out, size_t blockCount, uint64 dataUnitNo, unsigned int startBlock, const Cipher &secondaryCipher) const { throw NotApplicable (SRC_POS); }
+		virtual void EncryptBlocksXTS (const uint8 *in, uint8 *out, size_t blockCount, uint64 dataUnitNo, unsigned int startBlock, const Cipher &secondaryCipher) const { throw NotApplicable (SRC_POS); }
+		virtual bool IsXtsHwSupportAvailable () const { return false; }
                 static void EnableHwSupport (bool enable) { HwSupportEnabled = enable; }
 	    #else
                 static void EnableHwSupport (bool enable) { HwSupportEnabled = false; }
@@ -138,12 +141,29 @@ namespace VeraCrypt
 
 #endif
 
+#ifdef WOLFCRYPT_BACKEND
 #define TC_CIPHER_ADD_METHODS \
 	virtual void DecryptBlocks (uint8 *data, size_t blockCount) const; \
 	virtual void EncryptBlocks (uint8 *data, size_t blockCount) const; \
 	virtual bool IsHwSupportAvailable () const;
+#else
+#define TC_CIPHER_ADD_METHODS \
+	virtual void DecryptBlocks (uint8 *data, size_t blockCount) const; \
+	virtual void DecryptBlocksXTS (const uint8 *in, uint8 *out, size_t blockCount, uint64 dataUnitNo, unsigned int startBlock, const Cipher &secondaryCipher) const; \
+	virtual void EncryptBlocks (uint8 *data, size_t blockCount) const; \
+	virtual void EncryptBlocksXTS (const uint8 *in, uint8 *out, size_t blockCount, uint64 dataUnitNo, unsigned int startBlock, const Cipher &secondaryCipher) const; \
+	virtual bool IsHwSupportAvailable () const; \
+	virtual bool IsXtsHwSupportAvailable () const;
+#endif
 
 	TC_CIPHER (AES, 16, 32);
+
+#undef TC_CIPHER_ADD_METHODS
+#define TC_CIPHER_ADD_METHODS \
+	virtual void DecryptBlocks (uint8 *data, size_t blockCount) const; \
+	virtual void EncryptBlocks (uint8 *data, size_t blockCount) const; \
+	virtual bool IsHwSupportAvailable () const;
+
 	TC_CIPHER (Serpent, 16, 32);
 	TC_CIPHER (Twofish, 16, 32);
 	TC_CIPHER (Camellia, 16, 32);
@@ -26,6 +26,35 @@ namespace VeraCrypt
 	{
 	}
 
+	EncryptionAlgorithm::Request EncryptionAlgorithm::BeginDecryptSectors (uint8 *data, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize, CompletionCallback callback) const
+	{
+		if_debug (ValidateState());
+		return EncryptionThreadPool::BeginWork (EncryptionThreadPool::WorkType::DecryptDataUnits, Mode.get(), data, data, sectorIndex, sectorCount, sectorSize, callback);
+	}
+
+	EncryptionAlgorithm::Request EncryptionAlgorithm::BeginDecryptSectors (const SectorRunList &runs, size_t sectorSize, CompletionCallback callback) const
+	{
+		if_debug (ValidateState());
+		return EncryptionThreadPool::BeginWork (EncryptionThreadPool::WorkType::DecryptDataUnits, Mode.get(), runs, sectorSize, callback);
+	}
+
+	EncryptionAlgorithm::Request EncryptionAlgorithm::BeginEncryptSectors (uint8 *data, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize, CompletionCallback callback) const
+	{
+		return BeginEncryptSectors (data, data, sectorIndex, sectorCount, sectorSize, callback);
+	}
+
+	EncryptionAlgorithm::Request EncryptionAlgorithm::BeginEncryptSectors (const uint8 *source, uint8 *data, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize, CompletionCallback callback) const
+	{
+		if_debug (ValidateState());
+		return EncryptionThreadPool::BeginWork (EncryptionThreadPool::WorkType::EncryptDataUnits, Mode.get(), source, data, sectorIndex, sectorCount, sectorSize, callback);
+	}
+
+	EncryptionAlgorithm::Request EncryptionAlgorithm::BeginEncryptSectors (const SectorRunList &runs, size_t sectorSize, CompletionCallback callback) const
+	{
+		if_debug (ValidateState());
+		return EncryptionThreadPool::BeginWork (EncryptionThreadPool::WorkType::EncryptDataUnits, Mode.get(), runs, sectorSize, callback);
+	}
+
 	void EncryptionAlgorithm::Decrypt (uint8 *data, uint64 length) const
 	{
 		if_debug (ValidateState ());
@@ -43,6 +72,12 @@ namespace VeraCrypt
 		Mode->DecryptSectors (data, sectorIndex, sectorCount, sectorSize);
 	}
 
+	void EncryptionAlgorithm::DecryptSectors (const SectorRunList &runs, size_t sectorSize) const
+	{
+		if_debug (ValidateState());
+		Mode->DecryptSectors (runs, sectorSize);
+	}
+
 	void EncryptionAlgorithm::Encrypt (uint8 *data, uint64 length) const
 	{
 		if_debug (ValidateState());
@@ -60,6 +95,18 @@ namespace VeraCrypt
 		Mode->EncryptSectors (data, sectorIndex, sectorCount, sectorSize);
 	}
 
+	void EncryptionAlgorithm::EncryptSectors (const uint8 *source, uint8 *data, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize) const
+	{
+		if_debug (ValidateState ());
+		Mode->EncryptSectors (source, data, sectorIndex, sectorCount, sectorSize);
+	}
+
+	void EncryptionAlgorithm::EncryptSectors (const SectorRunList &runs, size_t sectorSize) const
+	{
+		if_debug (ValidateState ());
+		Mode->EncryptSectors (runs, sectorSize);
+	}
+
 	EncryptionAlgorithmList EncryptionAlgorithm::GetAvailableAlgorithms ()
 	{
 		EncryptionAlgorithmList l;
@@ -16,6 +16,7 @@
 #include "Platform/Platform.h"
 #include "Cipher.h"
 #include "EncryptionMode.h"
+#include "EncryptionThreadPool.h"
 
 namespace VeraCrypt
 {
@@ -27,12 +28,26 @@ namespace VeraCrypt
 	public:
 		virtual ~EncryptionAlgorithm ();
 
+		typedef shared_ptr <EncryptionThreadPool::EncryptionRequest> Request;
+		typedef shared_ptr <EncryptionThreadPool::CompletionCallback> CompletionCallback;
+
+		// Asynchronous versions of DecryptSectors () and EncryptSectors (). The buffers must remain valid and the key
+		// unchanged until the returned request is completed.
+		virtual Request BeginDecryptSectors (uint8 *data, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize, CompletionCallback callback = CompletionCallback()) const;
+		virtual Request BeginDecryptSectors (const SectorRunList &runs, size_t sectorSize, CompletionCallback callback = CompletionCallback()) const;
+		virtual Request BeginEncryptSectors (uint8 *data, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize, CompletionCallback callback = CompletionCallback()) const;
+		virtual Request BeginEncryptSectors (const uint8 *source, uint8 *data, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize, CompletionCallback callback = CompletionCallback()) const;
+		virtual Request BeginEncryptSectors (const SectorRunList &runs, size_t sectorSize, CompletionCallback callback = CompletionCallback()) const;
+
 		virtual void Decrypt (uint8 *data, uint64 length) const;
 		virtual void Decrypt (const BufferPtr &data) const;
 		virtual void DecryptSectors (uint8 *data, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize) const;
+		virtual void DecryptSectors (const SectorRunList &runs, size_t sectorSize) const;
 		virtual void Encrypt (uint8 *data, uint64 length) const;
 		virtual void Encrypt (const BufferPtr &data) const;
 		virtual void EncryptSectors (uint8 *data, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize) const;
+		virtual void EncryptSectors (const uint8 *source, uint8 *data, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize) const;
+		virtual void EncryptSectors (const SectorRunList &runs, size_t sectorSize) const;
 		static EncryptionAlgorithmList GetAvailableAlgorithms ();
 		virtual const CipherList &GetCiphers () const { return Ciphers; }
 		virtual shared_ptr <EncryptionAlgorithm> GetNew () const = 0;
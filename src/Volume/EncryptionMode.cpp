@@ -19,7 +19,7 @@
 
 namespace VeraCrypt
 {
-	EncryptionMode::EncryptionMode () : KeySet (false), SectorOffset (0)
+	EncryptionMode::EncryptionMode () : KeySet (false), ProcessingCost (0), SectorOffset (0)
 	{
 	}
 
@@ -32,11 +32,35 @@ namespace VeraCrypt
 		EncryptionThreadPool::DoWork (EncryptionThreadPool::WorkType::DecryptDataUnits, this, data, sectorIndex, sectorCount, sectorSize);
 	}
 
+	void EncryptionMode::DecryptSectors (const SectorRunList &runs, size_t sectorSize) const
+	{
+		EncryptionThreadPool::DoWork (EncryptionThreadPool::WorkType::DecryptDataUnits, this, runs, sectorSize);
+	}
+
 	void EncryptionMode::EncryptSectors (uint8 *data, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize) const
 	{
 		EncryptionThreadPool::DoWork (EncryptionThreadPool::WorkType::EncryptDataUnits, this, data, sectorIndex, sectorCount, sectorSize);
 	}
 
+	void EncryptionMode::EncryptSectors (const uint8 *source, uint8 *data, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize) const
+	{
+		EncryptionThreadPool::DoWork (EncryptionThreadPool::WorkType::EncryptDataUnits, this, source, data, sectorIndex, sectorCount, sectorSize);
+	}
+
+	void EncryptionMode::EncryptSectors (const SectorRunList &runs, size_t sectorSize) const
+	{
+		EncryptionThreadPool::DoWork (EncryptionThreadPool::WorkType::EncryptDataUnits, this, runs, sectorSize);
+	}
+
+	void EncryptionMode::EncryptSectorsCurrentThread (const uint8 *source, uint8 *data, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize) const
+	{
+		// Modes without an out-of-place implementation encrypt a copy of the source in place
+		if (source != data)
+			memcpy (data, source, (size_t) (sectorCount * sectorSize));
+
+		EncryptSectorsCurrentThread (data, sectorIndex, sectorCount, sectorSize);
+	}
+
 	EncryptionModeList EncryptionMode::GetAvailableModes ()
 	{
 		EncryptionModeList l;
@@ -50,6 +74,28 @@ namespace VeraCrypt
 		return l;
 	}
 
+	void EncryptionMode::UpdateProcessingCost (uint64 byteCount, uint64 nanoseconds) const
+	{
+		if (byteCount == 0)
+			return;
+
+		uint64 cost = nanoseconds * 1000 / byteCount;
+		if (cost == 0)
+			cost = 1;
+
+		// Exponential moving average of bounded samples, so that a measurement disturbed by preemption has a limited effect
+		uint64 previousCost = ProcessingCost.load (std::memory_order_relaxed);
+		if (previousCost != 0)
+		{
+			if (cost > previousCost * 4)
+				cost = previousCost * 4;
+
+			cost = (previousCost * 3 + cost) / 4;
+		}
+
+		ProcessingCost.store (cost, std::memory_order_relaxed);
+	}
+
 	void EncryptionMode::ValidateState () const
 	{
 		if (!KeySet || Ciphers.size() < 1)
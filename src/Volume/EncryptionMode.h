@@ -13,6 +13,7 @@
 #ifndef TC_HEADER_Encryption_EncryptionMode
 #define TC_HEADER_Encryption_EncryptionMode
 
+#include <atomic>
 #include "Platform/Platform.h"
 #include "Common/Crypto.h"
 #include "Cipher.h"
@@ -22,6 +23,18 @@ namespace VeraCrypt
 	class EncryptionMode;
 	typedef list < shared_ptr <EncryptionMode> > EncryptionModeList;
 
+	// Consecutive sectors stored in a buffer, processed in place by the scatter/gather variants of the sector functions
+	struct SectorRun
+	{
+		SectorRun (uint8 *data, uint64 sectorIndex, uint64 sectorCount) : Data (data), SectorIndex (sectorIndex), SectorCount (sectorCount) { }
+
+		uint8 *Data;
+		uint64 SectorIndex;
+		uint64 SectorCount;
+	};
+
+	typedef vector <SectorRun> SectorRunList;
+
 	class EncryptionMode
 	{
 	public:
@@ -29,20 +42,26 @@ namespace VeraCrypt
 
 		virtual void Decrypt (uint8 *data, uint64 length) const = 0;
 		virtual void DecryptSectors (uint8 *data, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize) const;
+		virtual void DecryptSectors (const SectorRunList &runs, size_t sectorSize) const;
 		virtual void DecryptSectorsCurrentThread (uint8 *data, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize) const = 0;
 		virtual void Encrypt (uint8 *data, uint64 length) const = 0;
 		virtual void EncryptSectors (uint8 *data, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize) const;
+		virtual void EncryptSectors (const uint8 *source, uint8 *data, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize) const;
+		virtual void EncryptSectors (const SectorRunList &runs, size_t sectorSize) const;
 		virtual void EncryptSectorsCurrentThread (uint8 *data, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize) const = 0;
+		virtual void EncryptSectorsCurrentThread (const uint8 *source, uint8 *data, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize) const;
 		static EncryptionModeList GetAvailableModes ();
 		virtual const SecureBuffer &GetKey () const { throw NotApplicable (SRC_POS); }
 		virtual size_t GetKeySize () const = 0;
 		virtual wstring GetName () const = 0;
 		virtual shared_ptr <EncryptionMode> GetNew () const = 0;
+		uint64 GetProcessingCost () const { return ProcessingCost.load (std::memory_order_relaxed); }	// Picoseconds per byte, 0 until measured
 		virtual uint64 GetSectorOffset () const { return SectorOffset; }
 		virtual bool IsKeySet () const { return KeySet; }
 		virtual void SetKey (const ConstBufferPtr &key) = 0;
-		virtual void SetCiphers (const CipherList &ciphers) { Ciphers = ciphers; }
+		virtual void SetCiphers (const CipherList &ciphers) { Ciphers = ciphers; ProcessingCost = 0; }
 		virtual void SetSectorOffset (int64 offset) { SectorOffset = offset; }
+		void UpdateProcessingCost (uint64 byteCount, uint64 nanoseconds) const;
 
 	protected:
 		EncryptionMode ();
@@ -55,6 +74,7 @@ namespace VeraCrypt
 
 		CipherList Ciphers;
 		bool KeySet;
+		mutable std::atomic <uint64> ProcessingCost;
 		uint64 SectorOffset;
 
 	private:
@@ -43,39 +43,88 @@
 	} \
 	len = end - start;
 
+// Same as XorBlocks but reading the data to be whitened from src instead of result
+#define XorBlocksFrom(result,src,ptr,len,start,end) \
+	while (len >= 2) \
+	{ \
+		__m128i xmm1 = _mm_loadu_si128((const __m128i*) ptr); \
+		__m128i xmm2 = _mm_loadu_si128((const __m128i*)src); \
+		__m128i xmm3 = _mm_loadu_si128((const __m128i*) (ptr + 2)); \
+		__m128i xmm4 = _mm_loadu_si128((const __m128i*)(src + 2)); \
+		\
+		_mm_storeu_si128((__m128i*)result, _mm_xor_si128(xmm1, xmm2)); \
+		_mm_storeu_si128((__m128i*)(result + 2), _mm_xor_si128(xmm3, xmm4)); \
+		ptr+= 4; \
+		src+= 4; \
+		result+= 4; \
+		len -= 2; \
+	} \
+	\
+	if (len) \
+	{ \
+		__m128i xmm1 = _mm_loadu_si128((const __m128i*)ptr); \
+		__m128i xmm2 = _mm_loadu_si128((const __m128i*)src); \
+		\
+		_mm_storeu_si128((__m128i*)result, _mm_xor_si128(xmm1, xmm2)); \
+		ptr+= 2; \
+		src+= 2; \
+		result+= 2; \
+	} \
+	len = end - start;
+
 #endif
 
 namespace VeraCrypt
 {
 	void EncryptionModeXTS::Encrypt (uint8 *data, uint64 length) const
 	{
-		EncryptBuffer (data, length, 0);
+		EncryptBuffer (data, data, length, 0);
 	}
 
-	void EncryptionModeXTS::EncryptBuffer (uint8 *data, uint64 length, uint64 startDataUnitNo) const
+	void EncryptionModeXTS::EncryptBuffer (const uint8 *source, uint8 *data, uint64 length, uint64 startDataUnitNo) const
 	{
 		if_debug (ValidateState());
 
-		CipherList::const_iterator iSecondaryCipher = SecondaryCiphers.begin();
+		// Pass each fragment through all cascade stages before moving on to the next one
+		uint64 fragmentSize = Ciphers.size() > 1 ? CascadeFragmentSize : length;
 
-		for (CipherList::const_iterator iCipher = Ciphers.begin(); iCipher != Ciphers.end(); ++iCipher)
+		while (length > 0)
 		{
-			EncryptBufferXTS (**iCipher, **iSecondaryCipher, data, length, startDataUnitNo, 0);
-			++iSecondaryCipher;
-		}
+			if (fragmentSize > length)
+				fragmentSize = length;
+
+			CipherList::const_iterator iSecondaryCipher = SecondaryCiphers.begin();
 
-		assert (iSecondaryCipher == SecondaryCiphers.end());
+			// The first stage reads the plaintext from the source buffer, the following ones work in place
+			const uint8 *stageSource = source;
+
+			for (CipherList::const_iterator iCipher = Ciphers.begin(); iCipher != Ciphers.end(); ++iCipher)
+			{
+				EncryptBufferXTS (**iCipher, **iSecondaryCipher, stageSource, data, fragmentSize, startDataUnitNo, 0);
+				stageSource = data;
+				++iSecondaryCipher;
+			}
+
+			assert (iSecondaryCipher == SecondaryCiphers.end());
+
+			source += fragmentSize;
+			data += fragmentSize;
+			length -= fragmentSize;
+			startDataUnitNo += fragmentSize / ENCRYPTION_DATA_UNIT_SIZE;
+		}
 	}
 
-	void EncryptionModeXTS::EncryptBufferXTS (const Cipher &cipher, const Cipher &secondaryCipher, uint8 *buffer, uint64 length, uint64 startDataUnitNo, unsigned int startCipherBlockNo) const
+	void EncryptionModeXTS::EncryptBufferXTS (const Cipher &cipher, const Cipher &secondaryCipher, const uint8 *source, uint8 *buffer, uint64 length, uint64 startDataUnitNo, unsigned int startCipherBlockNo) const
 	{
                 uint8 finalCarry;
 		uint8 whiteningValues [ENCRYPTION_DATA_UNIT_SIZE];
 		uint8 whiteningValue [BYTES_PER_XTS_BLOCK];
-		uint8 byteBufUnitNo [BYTES_PER_XTS_BLOCK];
+		uint8 tweakSeeds [TweakSeedBatchSize * BYTES_PER_XTS_BLOCK];
+		size_t tweakSeedCount = 0, tweakSeedIndex = 0, tweakSeedsUsed = 0;
 		uint64 *whiteningValuesPtr64 = (uint64 *) whiteningValues;
 		uint64 *whiteningValuePtr64 = (uint64 *) whiteningValue;
 		uint64 *bufPtr = (uint64 *) buffer;
+		const uint64 *sourcePtr = (const uint64 *) source;
 		uint64 *dataUnitBufPtr;
 		unsigned int startBlock = startCipherBlockNo, endBlock, block, countBlock;
 		uint64 remainingBlocks, dataUnitNo;
@@ -89,15 +138,18 @@ namespace VeraCrypt
 		the shift of the highest byte results in a carry, 135 is XORed into the lowest byte. The value 135 is
 		derived from the modulus of the Galois Field (x^128+x^7+x^2+x+1). */
 
-		// Convert the 64-bit data unit number into a little-endian 16-byte array.
-		// Note that as we are converting a 64-bit number into a 16-byte array we can always zero the last 8 bytes.
 		dataUnitNo = startDataUnitNo;
-		*((uint64 *) byteBufUnitNo) = Endian::Little (dataUnitNo);
-		*((uint64 *) byteBufUnitNo + 1) = 0;
 
 		if (length % BYTES_PER_XTS_BLOCK)
 			TC_THROW_FATAL_EXCEPTION;
 
+		if (cipher.IsXtsHwSupportAvailable())
+		{
+			// Whitening values are generated inside the cipher kernel
+			cipher.EncryptBlocksXTS (source, buffer, length / BYTES_PER_XTS_BLOCK, startDataUnitNo, startCipherBlockNo, secondaryCipher);
+			return;
+		}
+
 		remainingBlocks = length / BYTES_PER_XTS_BLOCK;
 
 		// Process all blocks in the buffer
@@ -112,11 +164,32 @@ namespace VeraCrypt
 			whiteningValuesPtr64 = (uint64 *) whiteningValues;
 			whiteningValuePtr64 = (uint64 *) whiteningValue;
 
-			// Encrypt the data unit number using the secondary key (in order to generate the first
-			// whitening value for this data unit)
-			*whiteningValuePtr64 = *((uint64 *) byteBufUnitNo);
-			*(whiteningValuePtr64 + 1) = 0;
-			secondaryCipher.EncryptBlock (whiteningValue);
+			if (tweakSeedIndex == tweakSeedCount)
+			{
+				// Encrypt the data unit numbers of the following data units using the secondary key in a single
+				// multi-block call (in order to generate the first whitening value for each of these data units).
+				// The 64-bit data unit numbers are converted into little-endian 16-byte arrays.
+				uint64 dataUnitCount = (startBlock + remainingBlocks + BLOCKS_PER_XTS_DATA_UNIT - 1) / BLOCKS_PER_XTS_DATA_UNIT;
+				uint64 *tweakSeedPtr64 = (uint64 *) tweakSeeds;
+
+				tweakSeedCount = (size_t) VC_MIN (dataUnitCount, (uint64) TweakSeedBatchSize);
+				tweakSeedIndex = 0;
+
+				if (tweakSeedCount > tweakSeedsUsed)
+					tweakSeedsUsed = tweakSeedCount;
+
+				for (size_t i = 0; i < tweakSeedCount; i++)
+				{
+					*tweakSeedPtr64++ = Endian::Little (dataUnitNo + i);
+					*tweakSeedPtr64++ = 0;
+				}
+
+				secondaryCipher.EncryptBlocks (tweakSeeds, tweakSeedCount);
+			}
+
+			*whiteningValuePtr64 = *((uint64 *) tweakSeeds + 2 * tweakSeedIndex);
+			*(whiteningValuePtr64 + 1) = *((uint64 *) tweakSeeds + 2 * tweakSeedIndex + 1);
+			tweakSeedIndex++;
 
 			// Generate subsequent whitening values for blocks in this data unit. Note that all generated 128-bit
 			// whitening values are stored in memory as a sequence of 64-bit integers.
@@ -172,13 +245,13 @@ namespace VeraCrypt
 
 			// Encrypt all blocks in this data unit
 #if (CRYPTOPP_BOOL_SSE2_INTRINSICS_AVAILABLE && CRYPTOPP_BOOL_X64)
-			XorBlocks (bufPtr, whiteningValuesPtr64, countBlock, startBlock, endBlock);
+			XorBlocksFrom (bufPtr, sourcePtr, whiteningValuesPtr64, countBlock, startBlock, endBlock);
 #else
 			for (block = 0; block < countBlock; block++)
 			{
 				// Pre-whitening
-				*bufPtr++ ^= *whiteningValuesPtr64++;
-				*bufPtr++ ^= *whiteningValuesPtr64++;
+				*bufPtr++ = *sourcePtr++ ^ *whiteningValuesPtr64++;
+				*bufPtr++ = *sourcePtr++ ^ *whiteningValuesPtr64++;
 			}
 #endif
 			// Actual encryption
@@ -200,16 +273,21 @@ namespace VeraCrypt
 			remainingBlocks -= countBlock;
 			startBlock = 0;
 			dataUnitNo++;
-			*((uint64 *) byteBufUnitNo) = Endian::Little (dataUnitNo);
 		}
 
 		FAST_ERASE64 (whiteningValue, sizeof (whiteningValue));
 		FAST_ERASE64 (whiteningValues, sizeof (whiteningValues));
+		FAST_ERASE64 (tweakSeeds, (tweakSeedsUsed * BYTES_PER_XTS_BLOCK));
 	}
 
 	void EncryptionModeXTS::EncryptSectorsCurrentThread (uint8 *data, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize) const
 	{
-		EncryptBuffer (data, sectorCount * sectorSize, sectorIndex * sectorSize / ENCRYPTION_DATA_UNIT_SIZE);
+		EncryptBuffer (data, data, sectorCount * sectorSize, sectorIndex * sectorSize / ENCRYPTION_DATA_UNIT_SIZE);
+	}
+
+	void EncryptionModeXTS::EncryptSectorsCurrentThread (const uint8 *source, uint8 *data, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize) const
+	{
+		EncryptBuffer (source, data, sectorCount * sectorSize, sectorIndex * sectorSize / ENCRYPTION_DATA_UNIT_SIZE);
 	}
 
 	size_t EncryptionModeXTS::GetKeySize () const
@@ -235,15 +313,28 @@ namespace VeraCrypt
 	{
 		if_debug (ValidateState());
 
-		CipherList::const_iterator iSecondaryCipher = SecondaryCiphers.end();
+		// Pass each fragment through all cascade stages before moving on to the next one
+		uint64 fragmentSize = Ciphers.size() > 1 ? CascadeFragmentSize : length;
 
-		for (CipherList::const_reverse_iterator iCipher = Ciphers.rbegin(); iCipher != Ciphers.rend(); ++iCipher)
+		while (length > 0)
 		{
-			--iSecondaryCipher;
-			DecryptBufferXTS (**iCipher, **iSecondaryCipher, data, length, startDataUnitNo, 0);
-		}
+			if (fragmentSize > length)
+				fragmentSize = length;
+
+			CipherList::const_iterator iSecondaryCipher = SecondaryCiphers.end();
+
+			for (CipherList::const_reverse_iterator iCipher = Ciphers.rbegin(); iCipher != Ciphers.rend(); ++iCipher)
+			{
+				--iSecondaryCipher;
+				DecryptBufferXTS (**iCipher, **iSecondaryCipher, data, fragmentSize, startDataUnitNo, 0);
+			}
+
+			assert (iSecondaryCipher == SecondaryCiphers.begin());
 
-		assert (iSecondaryCipher == SecondaryCiphers.begin());
+			data += fragmentSize;
+			length -= fragmentSize;
+			startDataUnitNo += fragmentSize / ENCRYPTION_DATA_UNIT_SIZE;
+		}
 	}
 
 	void EncryptionModeXTS::DecryptBufferXTS (const Cipher &cipher, const Cipher &secondaryCipher, uint8 *buffer, uint64 length, uint64 startDataUnitNo, unsigned int startCipherBlockNo) const
@@ -251,7 +342,8 @@ namespace VeraCrypt
 		uint8 finalCarry;
 		uint8 whiteningValues [ENCRYPTION_DATA_UNIT_SIZE];
 		uint8 whiteningValue [BYTES_PER_XTS_BLOCK];
-		uint8 byteBufUnitNo [BYTES_PER_XTS_BLOCK];
+		uint8 tweakSeeds [TweakSeedBatchSize * BYTES_PER_XTS_BLOCK];
+		size_t tweakSeedCount = 0, tweakSeedIndex = 0, tweakSeedsUsed = 0;
 		uint64 *whiteningValuesPtr64 = (uint64 *) whiteningValues;
 		uint64 *whiteningValuePtr64 = (uint64 *) whiteningValue;
 		uint64 *bufPtr = (uint64 *) buffer;
@@ -261,15 +353,18 @@ namespace VeraCrypt
 
 		startDataUnitNo += SectorOffset;
 
-		// Convert the 64-bit data unit number into a little-endian 16-byte array.
-		// Note that as we are converting a 64-bit number into a 16-byte array we can always zero the last 8 bytes.
 		dataUnitNo = startDataUnitNo;
-		*((uint64 *) byteBufUnitNo) = Endian::Little (dataUnitNo);
-		*((uint64 *) byteBufUnitNo + 1) = 0;
 
 		if (length % BYTES_PER_XTS_BLOCK)
 			TC_THROW_FATAL_EXCEPTION;
 
+		if (cipher.IsXtsHwSupportAvailable())
+		{
+			// Whitening values are generated inside the cipher kernel
+			cipher.DecryptBlocksXTS (buffer, buffer, length / BYTES_PER_XTS_BLOCK, startDataUnitNo, startCipherBlockNo, secondaryCipher);
+			return;
+		}
+
 		remainingBlocks = length / BYTES_PER_XTS_BLOCK;
 
 		// Process all blocks in the buffer
@@ -284,11 +379,32 @@ namespace VeraCrypt
 			whiteningValuesPtr64 = (uint64 *) whiteningValues;
 			whiteningValuePtr64 = (uint64 *) whiteningValue;
 
-			// Encrypt the data unit number using the secondary key (in order to generate the first
-			// whitening value for this data unit)
-			*whiteningValuePtr64 = *((uint64 *) byteBufUnitNo);
-			*(whiteningValuePtr64 + 1) = 0;
-			secondaryCipher.EncryptBlock (whiteningValue);
+			if (tweakSeedIndex == tweakSeedCount)
+			{
+				// Encrypt the data unit numbers of the following data units using the secondary key in a single
+				// multi-block call (in order to generate the first whitening value for each of these data units).
+				// The 64-bit data unit numbers are converted into little-endian 16-byte arrays.
+				uint64 dataUnitCount = (startBlock + remainingBlocks + BLOCKS_PER_XTS_DATA_UNIT - 1) / BLOCKS_PER_XTS_DATA_UNIT;
+				uint64 *tweakSeedPtr64 = (uint64 *) tweakSeeds;
+
+				tweakSeedCount = (size_t) VC_MIN (dataUnitCount, (uint64) TweakSeedBatchSize);
+				tweakSeedIndex = 0;
+
+				if (tweakSeedCount > tweakSeedsUsed)
+					tweakSeedsUsed = tweakSeedCount;
+
+				for (size_t i = 0; i < tweakSeedCount; i++)
+				{
+					*tweakSeedPtr64++ = Endian::Little (dataUnitNo + i);
+					*tweakSeedPtr64++ = 0;
+				}
+
+				secondaryCipher.EncryptBlocks (tweakSeeds, tweakSeedCount);
+			}
+
+			*whiteningValuePtr64 = *((uint64 *) tweakSeeds + 2 * tweakSeedIndex);
+			*(whiteningValuePtr64 + 1) = *((uint64 *) tweakSeeds + 2 * tweakSeedIndex + 1);
+			tweakSeedIndex++;
 
 			// Generate subsequent whitening values for blocks in this data unit. Note that all generated 128-bit
 			// whitening values are stored in memory as a sequence of 64-bit integers.
@@ -368,12 +484,11 @@ namespace VeraCrypt
 			remainingBlocks -= countBlock;
 			startBlock = 0;
 			dataUnitNo++;
-
-			*((uint64 *) byteBufUnitNo) = Endian::Little (dataUnitNo);
 		}
 
 		FAST_ERASE64 (whiteningValue, sizeof (whiteningValue));
 		FAST_ERASE64 (whiteningValues, sizeof (whiteningValues));
+		FAST_ERASE64 (tweakSeeds, (tweakSeedsUsed * BYTES_PER_XTS_BLOCK));
         }
 
 	void EncryptionModeXTS::DecryptSectorsCurrentThread (uint8 *data, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize) const
@@ -28,6 +28,7 @@ namespace VeraCrypt
 		virtual void DecryptSectorsCurrentThread (uint8 *data, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize) const;
 		virtual void Encrypt (uint8 *data, uint64 length) const;
 		virtual void EncryptSectorsCurrentThread (uint8 *data, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize) const;
+		virtual void EncryptSectorsCurrentThread (const uint8 *source, uint8 *data, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize) const;
 		virtual const SecureBuffer &GetKey () const { return SecondaryKey; }
 		virtual size_t GetKeySize () const;
 		virtual wstring GetName () const { return L"XTS"; };
@@ -38,13 +39,19 @@ namespace VeraCrypt
 	protected:
 		void DecryptBuffer (uint8 *data, uint64 length, uint64 startDataUnitNo) const;
 		void DecryptBufferXTS (const Cipher &cipher, const Cipher &secondaryCipher, uint8 *buffer, uint64 length, uint64 startDataUnitNo, unsigned int startCipherBlockNo) const;
-		void EncryptBuffer (uint8 *data, uint64 length, uint64 startDataUnitNo) const;
-		void EncryptBufferXTS (const Cipher &cipher, const Cipher &secondaryCipher, uint8 *buffer, uint64 length, uint64 startDataUnitNo, unsigned int startCipherBlockNo) const;
+		void EncryptBuffer (const uint8 *source, uint8 *data, uint64 length, uint64 startDataUnitNo) const;
+		void EncryptBufferXTS (const Cipher &cipher, const Cipher &secondaryCipher, const uint8 *source, uint8 *buffer, uint64 length, uint64 startDataUnitNo, unsigned int startCipherBlockNo) const;
 		void SetSecondaryCipherKeys ();
 
 		SecureBuffer SecondaryKey;
 		CipherList SecondaryCiphers;
 
+		// Cascades are applied to fragments of this size so that the data stays in L1 cache between stages
+		static const size_t CascadeFragmentSize = 8 * ENCRYPTION_DATA_UNIT_SIZE;
+
+		// Number of data unit numbers encrypted together with the secondary key to obtain the initial tweaks
+		static const size_t TweakSeedBatchSize = 64;
+
 	private:
 		EncryptionModeXTS (const EncryptionModeXTS &);
 		EncryptionModeXTS &operator= (const EncryptionModeXTS &);
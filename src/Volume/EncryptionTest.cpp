@@ -12,7 +12,11 @@
 
 #include "Cipher.h"
 #include "Common/Crc.h"
+#include "Common/Pkcs5.h"
 #include "Crc32.h"
+#ifndef WOLFCRYPT_BACKEND
+#include "Crypto/sm4.h"
+#endif
 #include "EncryptionAlgorithm.h"
 #include "EncryptionMode.h"
 #include "EncryptionModeXTS.h"
@@ -259,6 +263,43 @@ namespace VeraCrypt
 			
 			CipherKuznyechik kuznyechik;
 			TestCipher (kuznyechik, KuznyechikTestVectors, array_capacity (KuznyechikTestVectors));
+
+			// SM4 (GB/T 32907-2016, example 1)
+			const uint8 sm4Key[] = { 0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef, 0xfe, 0xdc, 0xba, 0x98, 0x76, 0x54, 0x32, 0x10 };
+			const uint8 sm4Ciphertext[] = { 0x68, 0x1e, 0xdf, 0x34, 0xd2, 0x06, 0x96, 0x5e, 0x86, 0xb3, 0xe9, 0x4f, 0x53, 0x6e, 0x42, 0x46 };
+			sm4_kds sm4Kds;
+			uint8 sm4Block[16];
+
+			sm4_set_key (sm4Key, &sm4Kds);
+			sm4_encrypt_block (sm4Block, sm4Key, &sm4Kds);
+
+			if (memcmp (sm4Block, sm4Ciphertext, sizeof (sm4Block)) != 0)
+				throw TestFailed (SRC_POS);
+
+			sm4_decrypt_block (sm4Block, sm4Block, &sm4Kds);
+
+			if (memcmp (sm4Block, sm4Key, sizeof (sm4Block)) != 0)
+				throw TestFailed (SRC_POS);
+
+			// The 64 blocks are processed in two requests of 35 and 29 blocks, which cover both the 16-block
+			// kernels and the blocks they leave to the narrower code
+			for (size_t i = 0; i < testData.Size(); ++i)
+			{
+				testData[i] = (uint8) i;
+			}
+
+			sm4_set_key (testData, &sm4Kds);
+			sm4_encrypt_blocks (testData, testData, 35, &sm4Kds);
+			sm4_encrypt_blocks (testData + 35 * 16, testData + 35 * 16, 29, &sm4Kds);
+
+			if (Crc32::ProcessBuffer (testData) != 0xfd3978ef)
+				throw TestFailed (SRC_POS);
+
+			sm4_decrypt_blocks (testData, testData, 29, &sm4Kds);
+			sm4_decrypt_blocks (testData + 29 * 16, testData + 29 * 16, 35, &sm4Kds);
+
+			if (origCrc != Crc32::ProcessBuffer (testData))
+				throw TestFailed (SRC_POS);
         #endif
 	}
 
@@ -523,6 +564,34 @@ namespace VeraCrypt
 
 			if (memcmp (XtsTestVectors[i].ciphertext, p, sizeof (p)) != 0)
 				throw TestFailed (SRC_POS);
+
+			// Out-of-place encryption must leave the source unchanged
+			unsigned __int8 c[ENCRYPTION_DATA_UNIT_SIZE];
+			memcpy (p, XtsTestVectors[i].plaintext, sizeof (p));
+
+			aes.EncryptSectors (p, c, dataUnitNo, sizeof (c) / ENCRYPTION_DATA_UNIT_SIZE, ENCRYPTION_DATA_UNIT_SIZE);
+
+			if (memcmp (XtsTestVectors[i].ciphertext, c, sizeof (c)) != 0
+				|| memcmp (XtsTestVectors[i].plaintext, p, sizeof (p)) != 0)
+				throw TestFailed (SRC_POS);
+
+			// Scatter/gather
+			SectorRunList runs;
+			runs.push_back (SectorRun (p, dataUnitNo, 1));
+			runs.push_back (SectorRun (c, dataUnitNo, 1));
+			memcpy (c, XtsTestVectors[i].plaintext, sizeof (c));
+
+			aes.EncryptSectors (runs, ENCRYPTION_DATA_UNIT_SIZE);
+
+			if (memcmp (XtsTestVectors[i].ciphertext, p, sizeof (p)) != 0
+				|| memcmp (XtsTestVectors[i].ciphertext, c, sizeof (c)) != 0)
+				throw TestFailed (SRC_POS);
+
+			aes.DecryptSectors (runs, ENCRYPTION_DATA_UNIT_SIZE);
+
+			if (memcmp (XtsTestVectors[i].plaintext, p, sizeof (p)) != 0
+				|| memcmp (XtsTestVectors[i].plaintext, c, sizeof (c)) != 0)
+				throw TestFailed (SRC_POS);
 		}
 	}
 
@@ -1200,6 +1269,29 @@ namespace VeraCrypt
 		if (memcmp (derivedKey.Ptr(), "\xd0\x53\xa2\x30", 4) != 0)
 			throw TestFailed (SRC_POS);
 
+		// Keys spanning several PRF blocks are split across the thread pool
+		struct
+		{
+			const Pkcs5Kdf *Kdf;
+			uint32 Crc;
+		} longKeyTests[] =
+		{
+			{ &pkcs5HmacBlake2s, 0x263ec1a1 },
+			{ &pkcs5HmacSha512, 0x680ea14b },
+			{ &pkcs5HmacWhirlpool, 0x8bb7457d },
+			{ &pkcs5HmacSha256, 0x3acdd72c },
+			{ &pkcs5HmacStreebog, 0x2e3560f4 }
+		};
+		Buffer longDerivedKey (192);
+
+		for (size_t i = 0; i < array_capacity (longKeyTests); ++i)
+		{
+			if (longKeyTests[i].Kdf->DeriveKey (longDerivedKey, password, salt, 5) != 0)
+				throw TestFailed (SRC_POS);
+			if (Crc32::ProcessBuffer (longDerivedKey) != longKeyTests[i].Crc)
+				throw TestFailed (SRC_POS);
+		}
+
 	#ifndef VC_DCS_DISABLE_ARGON2
 		Pkcs5Argon2 pkcs5Argon2;
 		static const uint8 argon2SaltData[] = { 's', 'o', 'm', 'e', 's', 'a', 'l', 't' };
@@ -1231,6 +1323,22 @@ namespace VeraCrypt
 		if (memcmp (argon2HeaderKey.Ptr(), argon2Pim1HeaderKeyPrefix, sizeof (argon2Pim1HeaderKeyPrefix)) != 0)
 			throw TestFailed (SRC_POS);
 
+		// Lanes filled by the thread pool must give the same key as lanes filled one after the other
+		Pkcs5Argon2 pkcs5Argon2Lanes (4);
+		Buffer argon2LanesKey (sizeof (argon2Pim1DerivedKey));
+		Buffer argon2SequentialLanesKey (sizeof (argon2Pim1DerivedKey));
+		int argon2Iterations, argon2MemoryCost;
+		get_argon2_params (1, &argon2Iterations, &argon2MemoryCost);
+
+		if (pkcs5Argon2Lanes.DeriveKey (argon2LanesKey, password, 1, argon2Salt) != 0)
+			throw TestFailed (SRC_POS);
+		if (derive_key_argon2_lanes (password.DataPtr(), (int) password.Size(), argon2Salt.Get(), (int) argon2Salt.Size(), argon2Iterations, argon2MemoryCost, 4, NULL, NULL, NULL, NULL,
+			argon2SequentialLanesKey.Ptr(), (int) argon2SequentialLanesKey.Size(), NULL) != 0)
+			throw TestFailed (SRC_POS);
+		if (memcmp (argon2LanesKey.Ptr(), argon2SequentialLanesKey.Ptr(), argon2LanesKey.Size()) != 0
+			|| memcmp (argon2LanesKey.Ptr(), argon2Pim1DerivedKey, sizeof (argon2Pim1DerivedKey)) == 0)
+			throw TestFailed (SRC_POS);
+
 		try
 		{
 			if (pkcs5Argon2.DeriveKey (derivedKey, password, salt, 5) != 0)
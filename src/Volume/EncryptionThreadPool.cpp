@@ -10,6 +10,8 @@
  code distribution packages.
 */
 
+#include <chrono>
+
 #ifdef TC_UNIX
 #	include <unistd.h>
 #endif
@@ -19,6 +21,19 @@
 #	include <sys/sysctl.h>
 #endif
 
+#ifdef TC_LINUX
+#	include <sched.h>
+#	include <pthread.h>
+#	include <stdio.h>
+#	include <sys/syscall.h>
+#	ifndef MPOL_F_NODE
+#		define MPOL_F_NODE (1 << 0)
+#	endif
+#	ifndef MPOL_F_ADDR
+#		define MPOL_F_ADDR (1 << 1)
+#	endif
+#endif
+
 #include "Platform/SyncEvent.h"
 #include "Platform/SystemLog.h"
 #include "Common/Crypto.h"
@@ -27,47 +42,230 @@
 
 namespace VeraCrypt
 {
-	EncryptionThreadPool::KeyDerivationWorkItem::KeyDerivationWorkItem (shared_ptr <Pkcs5Kdf> kdf, size_t derivedKeySize)
-		: Completed (false), DerivedKey (derivedKeySize), Kdf (kdf), Processed (false), Result (0)
+#ifdef TC_LINUX
+	// CPUs the process may run on in each NUMA node, node index of each CPU and node index of each system node number
+	static vector <cpu_set_t> NodeCpuSets;
+	static vector <size_t> CpuNodeIndexes;
+	static vector <int> SystemNodeIndexes;
+
+	// Parses a list in the kernel cpulist format ("0-3,8,10-11")
+	static bool ParseCpuList (const char *path, cpu_set_t &cpus)
 	{
+		FILE *file = fopen (path, "r");
+		if (!file)
+			return false;
+
+		CPU_ZERO (&cpus);
+
+		int first, last;
+		while (fscanf (file, "%d", &first) == 1)
+		{
+			int separator = fgetc (file);
+			last = first;
+
+			if (separator == '-')
+			{
+				if (fscanf (file, "%d", &last) != 1)
+					break;
+				separator = fgetc (file);
+			}
+
+			for (int cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu)
+				CPU_SET (cpu, &cpus);
+
+			if (separator != ',')
+				break;
+		}
+
+		fclose (file);
+		return true;
 	}
 
-	EncryptionThreadPool::KeyDerivationWorkItem::~KeyDerivationWorkItem ()
+	// Returns the number of CPUs the process may run on and groups them by NUMA node
+	static size_t GetProcessorTopology (size_t maxNodeCount)
+	{
+		cpu_set_t allowedCpus;
+		cpu_set_t nodes;
+
+		NodeCpuSets.clear();
+		CpuNodeIndexes.assign (CPU_SETSIZE, 0);
+		SystemNodeIndexes.clear();
+
+		if (sched_getaffinity (0, sizeof (allowedCpus), &allowedCpus) != 0)
+			return 0;
+
+		if (ParseCpuList ("/sys/devices/system/node/online", nodes))
+		{
+			for (int node = 0; node < CPU_SETSIZE; ++node)
+			{
+				char path[128];
+				cpu_set_t nodeCpus;
+
+				if (!CPU_ISSET (node, &nodes))
+					continue;
+
+				snprintf (path, sizeof (path), "/sys/devices/system/node/node%d/cpulist", node);
+				if (!ParseCpuList (path, nodeCpus))
+					continue;
+
+				// Skip memory-only nodes and nodes outside of the affinity mask
+				CPU_AND (&nodeCpus, &nodeCpus, &allowedCpus);
+				if (CPU_COUNT (&nodeCpus) == 0)
+					continue;
+
+				if (NodeCpuSets.size() < maxNodeCount)
+					NodeCpuSets.push_back (nodeCpus);
+				else
+					CPU_OR (&NodeCpuSets.back(), &NodeCpuSets.back(), &nodeCpus);
+
+				size_t nodeIndex = NodeCpuSets.size() - 1;
+
+				SystemNodeIndexes.resize (node + 1, -1);
+				SystemNodeIndexes[node] = (int) nodeIndex;
+
+				for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+				{
+					if (CPU_ISSET (cpu, &nodeCpus))
+						CpuNodeIndexes[cpu] = nodeIndex;
+				}
+			}
+		}
+
+		if (NodeCpuSets.empty())
+		{
+			NodeCpuSets.push_back (allowedCpus);
+			CpuNodeIndexes.assign (CPU_SETSIZE, 0);
+		}
+
+		return (size_t) CPU_COUNT (&allowedCpus);
+	}
+
+	static bool ReadCgroupCpuQuota (const string &maxPath, long long &quota, long long &period)
 	{
+		FILE *file = fopen (maxPath.c_str(), "r");
+		if (!file)
+			return false;
+
+		char quotaStr[32];
+		quota = -1;
+
+		if (fscanf (file, "%31s %lld", quotaStr, &period) == 2 && strcmp (quotaStr, "max") != 0)
+			quota = atoll (quotaStr);
+
+		fclose (file);
+		return true;
 	}
 
-	void EncryptionThreadPool::BeginKeyDerivation (KeyDerivationWorkItem &keyDerivationWorkItem, const VolumePassword &password, int pim, const ConstBufferPtr &salt, SyncEvent &completionEvent, SyncEvent &noOutstandingWorkItemEvent, SharedVal <size_t> &outstandingWorkItemCount, long volatile *abortFlag)
+	// Returns the number of CPUs allowed by the CPU bandwidth limits of the cgroup of the process (0 if unlimited)
+	static size_t GetCgroupCpuLimit ()
 	{
-		if (!ThreadPoolRunning)
-			throw NotInitialized (SRC_POS);
+		long long quota, period;
+		size_t limit = 0;
+		bool cgroup2 = false;
+		string cgroupPath;
 
-		ScopeLock lock (EnqueueMutex);
+		FILE *file = fopen ("/proc/self/cgroup", "r");
+		if (file)
+		{
+			char line[1024];
+			while (fgets (line, sizeof (line), file))
+			{
+				if (strncmp (line, "0::", 3) == 0)
+				{
+					cgroupPath = string (line + 3);
+					cgroupPath.erase (cgroupPath.find_last_not_of ("/\n") + 1);
+					break;
+				}
+			}
+			fclose (file);
+		}
 
-		WorkItem *workItem = &WorkItemQueue[EnqueuePosition++];
+		// cgroup v2: the limits of the cgroup and of all its ancestors apply
+		while (true)
+		{
+			if (ReadCgroupCpuQuota ("/sys/fs/cgroup" + cgroupPath + "/cpu.max", quota, period))
+			{
+				cgroup2 = true;
 
-		if (EnqueuePosition >= QueueSize)
-			EnqueuePosition = 0;
+				if (quota > 0 && period > 0)
+				{
+					size_t cpus = (size_t) ((quota + period - 1) / period);
+					if (limit == 0 || cpus < limit)
+						limit = cpus;
+				}
+			}
 
-		while (workItem->State != WorkItem::State::Free)
+			size_t separator = cgroupPath.rfind ('/');
+			if (separator == string::npos)
+				break;
+
+			cgroupPath.erase (separator);
+		}
+
+		if (!cgroup2)
 		{
-			WorkItemCompletedEvent.Wait();
+			quota = -1;
+			period = 0;
+
+			file = fopen ("/sys/fs/cgroup/cpu/cpu.cfs_quota_us", "r");
+			if (file)
+			{
+				if (fscanf (file, "%lld", &quota) != 1)
+					quota = -1;
+				fclose (file);
+			}
+
+			file = fopen ("/sys/fs/cgroup/cpu/cpu.cfs_period_us", "r");
+			if (file)
+			{
+				if (fscanf (file, "%lld", &period) != 1)
+					period = 0;
+				fclose (file);
+			}
+
+			if (quota > 0 && period > 0)
+				limit = (size_t) ((quota + period - 1) / period);
 		}
 
+		return limit;
+	}
+#endif
+
+	static uint64 GetTimeNs ()
+	{
+		return (uint64) std::chrono::duration_cast <std::chrono::nanoseconds> (std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	EncryptionThreadPool::KeyDerivationWorkItem::KeyDerivationWorkItem (shared_ptr <Pkcs5Kdf> kdf, size_t derivedKeySize)
+		: Completed (false), DerivedKey (derivedKeySize), Kdf (kdf), Processed (false), Result (0)
+	{
+	}
+
+	EncryptionThreadPool::KeyDerivationWorkItem::~KeyDerivationWorkItem ()
+	{
+	}
+
+	void EncryptionThreadPool::BeginKeyDerivation (KeyDerivationWorkItem &keyDerivationWorkItem, const VolumePassword &password, int pim, const ConstBufferPtr &salt, SyncEvent &completionEvent, SyncEvent &noOutstandingWorkItemEvent, SharedVal <size_t> &outstandingWorkItemCount, long volatile *abortFlag)
+	{
+		if (!ThreadPoolRunning)
+			throw NotInitialized (SRC_POS);
+
 		keyDerivationWorkItem.Completed.Set (false);
 		keyDerivationWorkItem.ItemException.reset();
 		keyDerivationWorkItem.Processed = false;
 		keyDerivationWorkItem.Result = 0;
 
-		workItem->Type = WorkType::DeriveKey;
-		workItem->KeyDerivation.AbortFlag = abortFlag;
-		workItem->KeyDerivation.CompletionEvent = &completionEvent;
-		workItem->KeyDerivation.NoOutstandingWorkItemEvent = &noOutstandingWorkItemEvent;
-		workItem->KeyDerivation.OutstandingWorkItemCount = &outstandingWorkItemCount;
-		workItem->KeyDerivation.Password = &password;
-		workItem->KeyDerivation.Pim = pim;
-		workItem->KeyDerivation.Salt = salt.Get();
-		workItem->KeyDerivation.SaltSize = salt.Size();
-		workItem->KeyDerivation.WorkItem = &keyDerivationWorkItem;
+		WorkItem workItem;
+		workItem.Type = WorkType::DeriveKey;
+		workItem.KeyDerivation.AbortFlag = abortFlag;
+		workItem.KeyDerivation.CompletionEvent = &completionEvent;
+		workItem.KeyDerivation.NoOutstandingWorkItemEvent = &noOutstandingWorkItemEvent;
+		workItem.KeyDerivation.OutstandingWorkItemCount = &outstandingWorkItemCount;
+		workItem.KeyDerivation.Password = &password;
+		workItem.KeyDerivation.Pim = pim;
+		workItem.KeyDerivation.Salt = salt.Get();
+		workItem.KeyDerivation.SaltSize = salt.Size();
+		workItem.KeyDerivation.WorkItem = &keyDerivationWorkItem;
 
 		{
 			ScopeLock outstandingWorkItemLock (KeyDerivationCompletionMutex);
@@ -75,27 +273,30 @@ namespace VeraCrypt
 				noOutstandingWorkItemEvent.Reset();
 		}
 
-		workItem->State.Set (WorkItem::State::Ready);
-		WorkItemReadyEvent.Signal();
+		EnqueueKeyDerivation (workItem);
 	}
 
 	void EncryptionThreadPool::DoWork (WorkType::Enum type, const EncryptionMode *encryptionMode, uint8 *data, uint64 startUnitNo, uint64 unitCount, size_t sectorSize)
 	{
-		size_t fragmentCount;
-		size_t unitsPerFragment;
-		size_t remainder;
-
-		uint8 *fragmentData;
-		uint64 fragmentStartUnitNo;
-
-		WorkItem *workItem;
-		WorkItem *firstFragmentWorkItem;
+		DoWork (type, encryptionMode, data, data, startUnitNo, unitCount, sectorSize);
+	}
 
+	void EncryptionThreadPool::DoWork (WorkType::Enum type, const EncryptionMode *encryptionMode, const uint8 *source, uint8 *data, uint64 startUnitNo, uint64 unitCount, size_t sectorSize)
+	{
 		if (unitCount == 0)
 			return;
 
-		if (!ThreadPoolRunning || unitCount == 1)
+		if (type == WorkType::DecryptDataUnits && source != data)
+			throw ParameterIncorrect (SRC_POS);
+
+		bool poolRunning = ThreadPoolRunning;
+		size_t fragmentCount = poolRunning ? GetFragmentCount (encryptionMode, unitCount, sectorSize) : 1;
+
+		if (fragmentCount < 2)
 		{
+			// Handing the work to other threads would cost more than it saves
+			uint64 startTime = poolRunning ? GetTimeNs() : 0;
+
 			switch (type)
 			{
 			case WorkType::DecryptDataUnits:
@@ -103,90 +304,499 @@ namespace VeraCrypt
 				break;
 
 			case WorkType::EncryptDataUnits:
-				encryptionMode->EncryptSectorsCurrentThread (data, startUnitNo, unitCount, sectorSize);
+				encryptionMode->EncryptSectorsCurrentThread (source, data, startUnitNo, unitCount, sectorSize);
 				break;
 
 			default:
 				throw ParameterIncorrect (SRC_POS);
 			}
 
+			if (poolRunning)
+				encryptionMode->UpdateProcessingCost (unitCount * sectorSize, GetTimeNs() - startTime);
+
 			return;
 		}
 
-		if (unitCount <= ThreadCount)
+		EncryptionRequest request (fragmentCount, GetSubmissionNode (source));
+		SubmitFragments (request, fragmentCount, type, encryptionMode, source, data, startUnitNo, unitCount, sectorSize);
+		request.Wait();
+	}
+
+	shared_ptr <EncryptionThreadPool::EncryptionRequest> EncryptionThreadPool::BeginWork (WorkType::Enum type, const EncryptionMode *encryptionMode, const uint8 *source, uint8 *data, uint64 startUnitNo, uint64 unitCount, size_t sectorSize, shared_ptr <CompletionCallback> callback)
+	{
+		if (type == WorkType::DecryptDataUnits && source != data)
+			throw ParameterIncorrect (SRC_POS);
+
+		// Even a small request is handed to a worker, as the caller has other work to do in the meantime
+		size_t fragmentCount = 1;
+		if (ThreadPoolRunning && unitCount > 0)
 		{
-			fragmentCount = (size_t) unitCount;
-			unitsPerFragment = 1;
-			remainder = 0;
+			fragmentCount = GetFragmentCount (encryptionMode, unitCount, sectorSize);
+			if (fragmentCount < 1)
+				fragmentCount = 1;
 		}
+
+		shared_ptr <EncryptionRequest> request (new EncryptionRequest (fragmentCount, GetSubmissionNode (source)));
+		request->Callback = callback;
+		request->Self = request;
+
+		if (unitCount == 0)
+			CompleteFragment (request.get());
 		else
+			SubmitFragments (*request, fragmentCount, type, encryptionMode, source, data, startUnitNo, unitCount, sectorSize);
+
+		return request;
+	}
+
+	shared_ptr <EncryptionThreadPool::EncryptionRequest> EncryptionThreadPool::BeginWork (WorkType::Enum type, const EncryptionMode *encryptionMode, const SectorRunList &runs, size_t sectorSize, shared_ptr <CompletionCallback> callback)
+	{
+		uint64 unitCount = 0;
+		foreach (const SectorRun &run, runs)
+			unitCount += run.SectorCount;
+
+		size_t fragmentCount = 1;
+		if (ThreadPoolRunning && unitCount > 0)
 		{
-			fragmentCount = ThreadCount;
-			unitsPerFragment = (size_t) unitCount / ThreadCount;
-			remainder = (size_t) unitCount % ThreadCount;
+			fragmentCount = GetFragmentCount (encryptionMode, unitCount, sectorSize);
+			if (fragmentCount < 1)
+				fragmentCount = 1;
+		}
+
+		// The request is held by a submission reference until all its fragments are queued
+		shared_ptr <EncryptionRequest> request (new EncryptionRequest (1, GetSubmissionNode (runs.empty() ? nullptr : runs.front().Data)));
+		request->Callback = callback;
+		request->Self = request;
+
+		SubmitRuns (*request, fragmentCount, type, encryptionMode, runs, unitCount, sectorSize);
+		CompleteFragment (request.get());
+
+		return request;
+	}
+
+	void EncryptionThreadPool::CompleteFragment (EncryptionRequest *request)
+	{
+		if (request->OutstandingFragmentCount.fetch_sub (1, std::memory_order_acq_rel) != 1)
+			return;
+
+		// The owner of an asynchronous request may release it as soon as the callback is called
+		shared_ptr <EncryptionRequest> self;
+		self.swap (request->Self);
+
+		if (request->Callback)
+		{
+			try
+			{
+				(*request->Callback) (request->ItemException.get());
+			}
+			catch (...) { }
+		}
+
+		// A synchronous request is owned by the waiting thread and must not be accessed after it is signaled
+		request->CompletedEvent.Signal();
+	}
+
+	void EncryptionThreadPool::EncryptionRequest::Wait ()
+	{
+		// Process queued fragments in this thread instead of only waiting for the workers
+		while (OutstandingFragmentCount.load (std::memory_order_acquire) > 0)
+		{
+			WorkItem queuedItem;
+			if (!TryDequeue (Node, queuedItem))
+				break;
+
+			ProcessWorkItem (queuedItem);
+		}
+
+		if (!Waited)
+		{
+			CompletedEvent.Wait();
+			Waited = true;
+		}
+
+		if (ItemException.get())
+			ItemException->Throw();
+	}
+
+	void EncryptionThreadPool::DoWork (WorkType::Enum type, const EncryptionMode *encryptionMode, const SectorRunList &runs, size_t sectorSize)
+	{
+		uint64 unitCount = 0;
+		foreach (const SectorRun &run, runs)
+			unitCount += run.SectorCount;
+
+		if (unitCount == 0)
+			return;
+
+		size_t fragmentCount = ThreadPoolRunning ? GetFragmentCount (encryptionMode, unitCount, sectorSize) : 1;
+
+		if (fragmentCount < 2)
+		{
+			foreach (const SectorRun &run, runs)
+				DoWork (type, encryptionMode, run.Data, run.SectorIndex, run.SectorCount, sectorSize);
 
-			if (remainder > 0)
-				++unitsPerFragment;
+			return;
 		}
 
-		fragmentData = data;
-		fragmentStartUnitNo = startUnitNo;
+		EncryptionRequest request (1, GetSubmissionNode (runs.front().Data));
+		SubmitRuns (request, fragmentCount, type, encryptionMode, runs, unitCount, sectorSize);
+		CompleteFragment (&request);
+
+		request.Wait();
+	}
+
+	void EncryptionThreadPool::Enqueue (size_t node, const WorkItem &workItem)
+	{
+		while (true)
+		{
+			size_t i;
+			for (i = 0; i < NodeCount; ++i)
+			{
+				if (WorkQueues[(node + i) % NodeCount].TryEnqueue (workItem))
+					break;
+			}
+
+			if (i < NodeCount)
+			{
+				node = (node + i) % NodeCount;
+				break;
+			}
+
+			// All queues are full: help the workers instead of waiting for a free slot
+			WorkItem queuedItem;
+			if (TryDequeue (node, queuedItem))
+				ProcessWorkItem (queuedItem);
+		}
+
+		// Pairs with the fence in WorkThreadProc () so that either the producer sees the idle worker
+		// or the worker sees the new item
+		std::atomic_thread_fence (std::memory_order_seq_cst);
+
+		if (IdleWorkerCount.load (std::memory_order_relaxed) > 0)
+			WakeUpIdleWorker (node);
+	}
+
+	void EncryptionThreadPool::EnqueueKeyDerivation (const WorkItem &workItem)
+	{
+		while (!KeyDerivationQueue.TryEnqueue (workItem))
+		{
+			// The queue is full: help the workers instead of waiting for a free slot. The item is taken regardless
+			// of the key derivation thread limit, as the caller may hold the only slot that could drain the queue.
+			WorkItem queuedItem;
+			if (KeyDerivationQueue.TryDequeue (queuedItem))
+				ProcessWorkItem (queuedItem);
+		}
+
+		// Pairs with the fence in WorkThreadProc ()
+		std::atomic_thread_fence (std::memory_order_seq_cst);
+
+		if (IdleWorkerCount.load (std::memory_order_relaxed) > 0)
+			WakeUpIdleWorker (GetSubmissionNode (nullptr));
+	}
+
+	size_t EncryptionThreadPool::GetFragmentCount (const EncryptionMode *encryptionMode, uint64 unitCount, size_t sectorSize)
+	{
+		uint64 cost = encryptionMode->GetProcessingCost();
+		if (cost == 0)
+			cost = DefaultProcessingCost;
+
+		// A fragment must take long enough for the time gained by processing it in parallel to exceed the cost of handing it to a worker
+		uint64 minFragmentSize = MinFragmentTime * 1000 / cost;
+		if (minFragmentSize < MinFragmentSize)
+			minFragmentSize = MinFragmentSize;
+
+		uint64 fragmentCount = unitCount * sectorSize / minFragmentSize;
+
+		if (fragmentCount > ThreadCount)
+			fragmentCount = ThreadCount;
+
+		if (fragmentCount > unitCount)
+			fragmentCount = unitCount;
 
+		return (size_t) fragmentCount;
+	}
+
+	size_t EncryptionThreadPool::GetMaxTaskConcurrency (bool keyDerivation)
+	{
+		if (!ThreadPoolRunning)
+			return 1;
+
+		return 1 + (keyDerivation ? MaxKeyDerivationThreadCount.load() : ThreadCount);
+	}
+
+	size_t EncryptionThreadPool::GetSubmissionNode (const void *data)
+	{
+#ifdef TC_LINUX
+		if (NodeCount > 1)
 		{
-			ScopeLock lock (EnqueueMutex);
-			firstFragmentWorkItem = &WorkItemQueue[EnqueuePosition];
+			// Prefer the node holding the data, which is where the caller has just written or
+			// read it, and otherwise the node of the calling CPU
+			int systemNode = -1;
+			if (data && syscall (SYS_get_mempolicy, &systemNode, nullptr, 0, data, MPOL_F_NODE | MPOL_F_ADDR) == 0
+				&& systemNode >= 0 && (size_t) systemNode < SystemNodeIndexes.size() && SystemNodeIndexes[systemNode] >= 0)
+			{
+				return (size_t) SystemNodeIndexes[systemNode];
+			}
+
+			int cpu = sched_getcpu();
+			if (cpu >= 0 && cpu < CPU_SETSIZE)
+				return CpuNodeIndexes[cpu];
+		}
+#endif
+		return 0;
+	}
+
+	void EncryptionThreadPool::ProcessBatch (EncryptionBatch *batch)
+	{
+		// Each piece is completed as soon as its data units are processed
+		for (size_t i = 0; i < batch->SegmentCount; ++i)
+			ProcessWorkItem (batch->Segments[i]);
+
+		delete batch;
+	}
 
-			while (firstFragmentWorkItem->State != WorkItem::State::Free)
+	void EncryptionThreadPool::ProcessTasks (TaskGroup &group)
+	{
+		size_t taskIndex;
+		while ((taskIndex = group.NextTaskIndex.fetch_add (1)) < group.TaskCount)
+		{
+			try
+			{
+				group.Task (taskIndex);
+			}
+			catch (Exception &e)
+			{
+				ScopeLock lock (group.Request.ItemExceptionMutex);
+				group.Request.ItemException.reset (e.CloneNew());
+			}
+			catch (exception &e)
 			{
-				WorkItemCompletedEvent.Wait();
+				ScopeLock lock (group.Request.ItemExceptionMutex);
+				group.Request.ItemException.reset (new ExternalException (SRC_POS, StringConverter::ToExceptionString (e)));
+			}
+			catch (...)
+			{
+				ScopeLock lock (group.Request.ItemExceptionMutex);
+				group.Request.ItemException.reset (new UnknownException (SRC_POS));
 			}
 
-			firstFragmentWorkItem->OutstandingFragmentCount.Set (fragmentCount);
-			firstFragmentWorkItem->ItemException.reset();
+			CompleteFragment (&group.Request);
+		}
+	}
 
-			while (fragmentCount-- > 0)
+	void EncryptionThreadPool::ProcessWorkItem (WorkItem &workItem)
+	{
+		if (workItem.Type == WorkType::ParallelTasks)
+		{
+			ProcessTasks (*workItem.Tasks.Group);
+			ReleaseTaskGroup (workItem.Tasks.Group);
+			return;
+		}
+
+		if (workItem.Type != WorkType::DeriveKey && workItem.Encryption.Batch)
+		{
+			ProcessBatch (workItem.Encryption.Batch);
+			return;
+		}
+
+		try
+		{
+			uint64 startTime = workItem.Type != WorkType::DeriveKey ? GetTimeNs() : 0;
+
+			switch (workItem.Type)
 			{
-				workItem = &WorkItemQueue[EnqueuePosition++];
+			case WorkType::DecryptDataUnits:
+				workItem.Encryption.Mode->DecryptSectorsCurrentThread (workItem.Encryption.Data, workItem.Encryption.StartUnitNo, workItem.Encryption.UnitCount, workItem.Encryption.SectorSize);
+				break;
 
-				if (EnqueuePosition >= QueueSize)
-					EnqueuePosition = 0;
+			case WorkType::EncryptDataUnits:
+				workItem.Encryption.Mode->EncryptSectorsCurrentThread (workItem.Encryption.Source, workItem.Encryption.Data, workItem.Encryption.StartUnitNo, workItem.Encryption.UnitCount, workItem.Encryption.SectorSize);
+				break;
 
-				while (workItem->State != WorkItem::State::Free)
+			case WorkType::DeriveKey:
 				{
-					WorkItemCompletedEvent.Wait();
+					KeyDerivationWorkItem *keyDerivationWorkItem = workItem.KeyDerivation.WorkItem;
+					if (workItem.KeyDerivation.AbortFlag && *workItem.KeyDerivation.AbortFlag)
+						keyDerivationWorkItem->Result = ERR_USER_ABORT;
+					else
+						keyDerivationWorkItem->Result = keyDerivationWorkItem->Kdf->DeriveKey (keyDerivationWorkItem->DerivedKey, *workItem.KeyDerivation.Password, workItem.KeyDerivation.Pim, ConstBufferPtr (workItem.KeyDerivation.Salt, workItem.KeyDerivation.SaltSize), workItem.KeyDerivation.AbortFlag);
 				}
+				break;
+
+			default:
+				throw ParameterIncorrect (SRC_POS);
+			}
+
+			if (workItem.Type != WorkType::DeriveKey)
+				workItem.Encryption.Mode->UpdateProcessingCost (workItem.Encryption.UnitCount * workItem.Encryption.SectorSize, GetTimeNs() - startTime);
+		}
+		catch (Exception &e)
+		{
+			if (workItem.Type == WorkType::DeriveKey)
+				workItem.KeyDerivation.WorkItem->ItemException.reset (e.CloneNew());
+			else
+			{
+				ScopeLock lock (workItem.Encryption.Request->ItemExceptionMutex);
+				workItem.Encryption.Request->ItemException.reset (e.CloneNew());
+			}
+		}
+		catch (exception &e)
+		{
+			if (workItem.Type == WorkType::DeriveKey)
+				workItem.KeyDerivation.WorkItem->ItemException.reset (new ExternalException (SRC_POS, StringConverter::ToExceptionString (e)));
+			else
+			{
+				ScopeLock lock (workItem.Encryption.Request->ItemExceptionMutex);
+				workItem.Encryption.Request->ItemException.reset (new ExternalException (SRC_POS, StringConverter::ToExceptionString (e)));
+			}
+		}
+		catch (...)
+		{
+			if (workItem.Type == WorkType::DeriveKey)
+				workItem.KeyDerivation.WorkItem->ItemException.reset (new UnknownException (SRC_POS));
+			else
+			{
+				ScopeLock lock (workItem.Encryption.Request->ItemExceptionMutex);
+				workItem.Encryption.Request->ItemException.reset (new UnknownException (SRC_POS));
+			}
+		}
+
+		if (workItem.Type == WorkType::DeriveKey)
+		{
+			workItem.KeyDerivation.WorkItem->Completed.Set (true);
+			workItem.KeyDerivation.CompletionEvent->Signal();
+			{
+				ScopeLock outstandingWorkItemLock (KeyDerivationCompletionMutex);
+				if (workItem.KeyDerivation.OutstandingWorkItemCount->Decrement() == 0)
+					workItem.KeyDerivation.NoOutstandingWorkItemEvent->Signal();
+			}
+			return;
+		}
 
-				workItem->Type = type;
-				workItem->FirstFragment = firstFragmentWorkItem;
+		CompleteFragment (workItem.Encryption.Request);
+	}
 
-				workItem->Encryption.Mode = encryptionMode;
-				workItem->Encryption.Data = fragmentData;
-				workItem->Encryption.UnitCount = unitsPerFragment;
-				workItem->Encryption.StartUnitNo = fragmentStartUnitNo;
-				workItem->Encryption.SectorSize = sectorSize;
+	void EncryptionThreadPool::ReleaseTaskGroup (TaskGroup *group)
+	{
+		if (group->ReferenceCount.fetch_sub (1, std::memory_order_acq_rel) == 1)
+			delete group;
+	}
 
-				fragmentData += unitsPerFragment * sectorSize;
-				fragmentStartUnitNo += unitsPerFragment;
+	void EncryptionThreadPool::RunTasks (ParallelTask &task, size_t taskCount, bool keyDerivation)
+	{
+		size_t helperCount = 0;
 
-				if (remainder > 0 && --remainder == 0)
-					--unitsPerFragment;
+		if (ThreadPoolRunning && taskCount > 1)
+		{
+			// The calling thread processes tasks too, so that it completes the group by itself if no worker is
+			// available (in particular when all key derivation workers are running tasks of their own)
+			helperCount = min (taskCount, GetMaxTaskConcurrency (keyDerivation)) - 1;
 
-				workItem->State.Set (WorkItem::State::Ready);
-				WorkItemReadyEvent.Signal();
+			if (keyDerivation)
+			{
+				// Key derivation helpers are only run by workers taking a free key derivation slot. Queuing more helpers than
+				// there are free slots would leave items in the queue that no worker dequeues while the slots are held.
+				size_t activeCount = KeyDerivationThreadCount.load();
+				size_t maxCount = MaxKeyDerivationThreadCount.load();
+				size_t freeCount = activeCount < maxCount ? maxCount - activeCount : 0;
+
+				if (helperCount > freeCount)
+					helperCount = freeCount;
 			}
 		}
 
-		firstFragmentWorkItem->ItemCompletedEvent.Wait();
+		// The work is split according to the number of threads that take part in it
+		taskCount = min (task.GetTaskCount (taskCount, helperCount + 1), taskCount);
+
+		if (helperCount >= taskCount)
+			helperCount = taskCount > 0 ? taskCount - 1 : 0;
+
+		if (helperCount == 0)
+		{
+			for (size_t i = 0; i < taskCount; ++i)
+				task (i);
+
+			return;
+		}
+
+		TaskGroup *group = new TaskGroup (task, taskCount, helperCount + 1);
+		finally_do_arg (TaskGroup *, group, { ReleaseTaskGroup (finally_arg); });
+
+		WorkItem workItem;
+		workItem.Type = WorkType::ParallelTasks;
+		workItem.Tasks.Group = group;
+
+		for (size_t i = 0; i < helperCount; ++i)
+		{
+			if (keyDerivation)
+				EnqueueKeyDerivation (workItem);
+			else
+				Enqueue (group->Request.Node, workItem);
+		}
+
+		ProcessTasks (*group);
+		group->Request.Wait();
+	}
+
+	void EncryptionThreadPool::SubmitBatch (size_t node, EncryptionBatch *batch)
+	{
+		WorkItem workItem;
+
+		if (batch->SegmentCount == 1)
+		{
+			workItem = batch->Segments[0];
+			delete batch;
+		}
+		else
+		{
+			workItem.Type = batch->Type;
+			workItem.Encryption.Batch = batch;
+		}
+
+		if (ThreadPoolRunning)
+			Enqueue (node, workItem);
+		else
+			ProcessWorkItem (workItem);
+	}
 
-		unique_ptr <Exception> itemException;
-		if (firstFragmentWorkItem->ItemException.get())
-			itemException = move_ptr(firstFragmentWorkItem->ItemException);
+	void EncryptionThreadPool::SubmitFragments (EncryptionRequest &request, size_t fragmentCount, WorkType::Enum type, const EncryptionMode *encryptionMode, const uint8 *source, uint8 *data, uint64 startUnitNo, uint64 unitCount, size_t sectorSize)
+	{
+		size_t unitsPerFragment = (size_t) unitCount / fragmentCount;
+		size_t remainder = (size_t) unitCount % fragmentCount;
+
+		if (remainder > 0)
+			++unitsPerFragment;
+
+		WorkItem workItem;
+		workItem.Type = type;
+		workItem.Encryption.Batch = nullptr;
+		workItem.Encryption.Mode = encryptionMode;
+		workItem.Encryption.Request = &request;
+		workItem.Encryption.Source = source;
+		workItem.Encryption.Data = data;
+		workItem.Encryption.StartUnitNo = startUnitNo;
+		workItem.Encryption.SectorSize = sectorSize;
+
+		while (fragmentCount-- > 0)
+		{
+			workItem.Encryption.UnitCount = unitsPerFragment;
 
-		firstFragmentWorkItem->State.Set (WorkItem::State::Free);
-		WorkItemCompletedEvent.Signal();
+			if (ThreadPoolRunning)
+				Enqueue (request.Node, workItem);
+			else
+				ProcessWorkItem (workItem);
 
-		if (itemException.get())
-			itemException->Throw();
+			workItem.Encryption.Source += unitsPerFragment * sectorSize;
+			workItem.Encryption.Data += unitsPerFragment * sectorSize;
+			workItem.Encryption.StartUnitNo += unitsPerFragment;
+
+			if (remainder > 0 && --remainder == 0)
+				--unitsPerFragment;
+		}
+	}
+
+	void EncryptionThreadPool::SetKeyDerivationThreadLimit (size_t limit)
+	{
+		KeyDerivationThreadLimit = limit;
+		UpdateMaxKeyDerivationThreadCount();
 	}
 
 	void EncryptionThreadPool::Start ()
@@ -223,19 +833,59 @@ namespace VeraCrypt
 #	error Cannot determine CPU count
 #endif
 
+		// Node of each CPU the workers may use, in node order
+		vector <size_t> cpuNodes;
+
+#ifdef TC_LINUX
+		// Do not use more threads than CPUs in the affinity mask of the process or than its cgroup CPU quota allows
+		size_t allowedCpuCount = GetProcessorTopology (MaxNodeCount);
+		if (allowedCpuCount > 0 && allowedCpuCount < cpuCount)
+			cpuCount = allowedCpuCount;
+
+		size_t cpuLimit = GetCgroupCpuLimit();
+		if (cpuLimit > 0 && cpuLimit < cpuCount)
+			cpuCount = cpuLimit;
+
+		NodeCount = NodeCpuSets.size();
+
+		for (size_t node = 0; node < NodeCount; ++node)
+			cpuNodes.insert (cpuNodes.end(), (size_t) CPU_COUNT (&NodeCpuSets[node]), node);
+#else
+		NodeCount = 1;
+#endif
+
 		if (cpuCount < 2)
 			return;
 
 		if (cpuCount > MaxThreadCount)
 			cpuCount = MaxThreadCount;
 
+		if (cpuNodes.empty())
+			cpuNodes.assign (cpuCount, 0);
+
 		StopPending = false;
-		DequeuePosition = 0;
-		EnqueuePosition = 0;
+		IdleWorkerCount = 0;
+		KeyDerivationQueue.Reset();
+		KeyDerivationThreadCount = 0;
 
-		for (size_t i = 0; i < sizeof (WorkItemQueue) / sizeof (WorkItemQueue[0]); ++i)
+		for (size_t node = 0; node < MaxNodeCount; ++node)
 		{
-			WorkItemQueue[i].State.Set (WorkItem::State::Free);
+			WorkQueues[node].Reset();
+			NodeFirstWorker[node] = 0;
+		}
+
+		// Spread the workers over the nodes in proportion to their number of usable CPUs
+		Workers.clear();
+		for (size_t i = 0; i < cpuCount; ++i)
+		{
+			make_shared_auto (Worker, worker);
+			worker->Idle = false;
+			worker->Node = cpuNodes[i * cpuNodes.size() / cpuCount];
+
+			if (i > 0 && worker->Node != Workers.back()->Node)
+				NodeFirstWorker[worker->Node] = i;
+
+			Workers.push_back (worker);
 		}
 
 		try
@@ -244,14 +894,16 @@ namespace VeraCrypt
 			{
 				struct ThreadFunctor : public Functor
 				{
+					ThreadFunctor (size_t workerIndex) : WorkerIndex (workerIndex) { }
 					virtual void operator() ()
 					{
-						WorkThreadProc();
+						WorkThreadProc (WorkerIndex);
 					}
+					size_t WorkerIndex;
 				};
 
 				make_shared_auto (Thread, thread);
-				thread->Start (new ThreadFunctor ());
+				thread->Start (new ThreadFunctor (ThreadCount));
 				RunningThreads.push_back (thread);
 			}
 		}
@@ -266,6 +918,7 @@ namespace VeraCrypt
 			throw;
 		}
 
+		UpdateMaxKeyDerivationThreadCount();
 		ThreadPoolRunning = true;
 	}
 
@@ -275,114 +928,249 @@ namespace VeraCrypt
 			return;
 
 		StopPending = true;
-		WorkItemReadyEvent.Signal();
+
+		for (size_t i = 0; i < ThreadCount; ++i)
+			Workers[i]->WakeUpEvent.Signal();
 
 		foreach_ref (const Thread &thread, RunningThreads)
 		{
 			thread.Join();
 		}
 
+		// Complete the work left in the queues, as its submitters may still be waiting for it
+		WorkItem workItem;
+		while (TryDequeue (0, workItem) || KeyDerivationQueue.TryDequeue (workItem))
+			ProcessWorkItem (workItem);
+
+		RunningThreads.clear();
+		Workers.clear();
 		ThreadCount = 0;
 		ThreadPoolRunning = false;
 	}
 
-	void EncryptionThreadPool::WorkThreadProc ()
+	void EncryptionThreadPool::WorkQueue::Reset ()
 	{
-		try
-		{
-			WorkItem *workItem;
-
-			while (!StopPending)
-			{
-				{
-					ScopeLock lock (DequeueMutex);
+		DequeuePosition = 0;
+		EnqueuePosition = 0;
 
-					workItem = &WorkItemQueue[DequeuePosition++];
+		for (size_t i = 0; i < QueueSize; ++i)
+			Slots[i].Sequence.store (i, std::memory_order_relaxed);
+	}
 
-					if (DequeuePosition >= QueueSize)
-						DequeuePosition = 0;
+	void EncryptionThreadPool::SubmitRuns (EncryptionRequest &request, size_t fragmentCount, WorkType::Enum type, const EncryptionMode *encryptionMode, const SectorRunList &runs, uint64 unitCount, size_t sectorSize)
+	{
+		// Runs are cut into pieces so that each fragment has about the same number of data units. Pieces
+		// of a fragment that belong to different runs are queued together as a batch.
+		uint64 unitsPerFragment = (unitCount + fragmentCount - 1) / fragmentCount;
+		uint64 fragmentUnitCount = 0;
+		EncryptionBatch *batch = nullptr;
+
+		WorkItem workItem;
+		workItem.Type = type;
+		workItem.Encryption.Batch = nullptr;
+		workItem.Encryption.Mode = encryptionMode;
+		workItem.Encryption.Request = &request;
+		workItem.Encryption.SectorSize = sectorSize;
+
+		foreach (const SectorRun &run, runs)
+		{
+			for (uint64 offset = 0; offset < run.SectorCount; )
+			{
+				uint64 pieceUnitCount = min (run.SectorCount - offset, unitsPerFragment - fragmentUnitCount);
 
-					while (!StopPending && workItem->State != WorkItem::State::Ready)
-					{
-						WorkItemReadyEvent.Wait();
-					}
+				workItem.Encryption.Source = run.Data + offset * sectorSize;
+				workItem.Encryption.Data = run.Data + offset * sectorSize;
+				workItem.Encryption.StartUnitNo = run.SectorIndex + offset;
+				workItem.Encryption.UnitCount = pieceUnitCount;
 
-					workItem->State.Set (WorkItem::State::Busy);
+				if (!batch)
+				{
+					batch = new EncryptionBatch;
+					batch->Type = type;
+					batch->Mode = encryptionMode;
+					batch->SegmentCount = 0;
 				}
 
-				if (StopPending)
-					break;
+				batch->Segments[batch->SegmentCount++] = workItem;
+				request.OutstandingFragmentCount.fetch_add (1, std::memory_order_relaxed);
 
-				try
-				{
-					switch (workItem->Type)
-					{
-					case WorkType::DecryptDataUnits:
-						workItem->Encryption.Mode->DecryptSectorsCurrentThread (workItem->Encryption.Data, workItem->Encryption.StartUnitNo, workItem->Encryption.UnitCount, workItem->Encryption.SectorSize);
-						break;
-
-					case WorkType::EncryptDataUnits:
-						workItem->Encryption.Mode->EncryptSectorsCurrentThread (workItem->Encryption.Data, workItem->Encryption.StartUnitNo, workItem->Encryption.UnitCount, workItem->Encryption.SectorSize);
-						break;
-
-					case WorkType::DeriveKey:
-						{
-							KeyDerivationWorkItem *keyDerivationWorkItem = workItem->KeyDerivation.WorkItem;
-							if (workItem->KeyDerivation.AbortFlag && *workItem->KeyDerivation.AbortFlag)
-								keyDerivationWorkItem->Result = ERR_USER_ABORT;
-							else
-								keyDerivationWorkItem->Result = keyDerivationWorkItem->Kdf->DeriveKey (keyDerivationWorkItem->DerivedKey, *workItem->KeyDerivation.Password, workItem->KeyDerivation.Pim, ConstBufferPtr (workItem->KeyDerivation.Salt, workItem->KeyDerivation.SaltSize), workItem->KeyDerivation.AbortFlag);
-						}
-						break;
-
-					default:
-						throw ParameterIncorrect (SRC_POS);
-					}
-				}
-				catch (Exception &e)
+				offset += pieceUnitCount;
+				fragmentUnitCount += pieceUnitCount;
+
+				if (fragmentUnitCount == unitsPerFragment || batch->SegmentCount == EncryptionBatch::MaxSegmentCount)
 				{
-					if (workItem->Type == WorkType::DeriveKey)
-						workItem->KeyDerivation.WorkItem->ItemException.reset (e.CloneNew());
-					else
-						workItem->FirstFragment->ItemException.reset (e.CloneNew());
+					SubmitBatch (request.Node, batch);
+					batch = nullptr;
+					fragmentUnitCount = 0;
 				}
-				catch (exception &e)
+			}
+		}
+
+		if (batch)
+			SubmitBatch (request.Node, batch);
+	}
+
+	bool EncryptionThreadPool::TryDequeue (size_t node, WorkItem &workItem)
+	{
+		// Take work from the queue of the given node first and steal from the other nodes when it is empty
+		for (size_t i = 0; i < NodeCount; ++i)
+		{
+			if (WorkQueues[(node + i) % NodeCount].TryDequeue (workItem))
+				return true;
+		}
+
+		return false;
+	}
+
+	bool EncryptionThreadPool::TryDequeueKeyDerivation (WorkItem &workItem)
+	{
+		// Take a key derivation slot before the item so that the limit is never exceeded
+		size_t count = KeyDerivationThreadCount.load (std::memory_order_relaxed);
+		do
+		{
+			if (count >= MaxKeyDerivationThreadCount.load (std::memory_order_relaxed))
+				return false;
+		}
+		while (!KeyDerivationThreadCount.compare_exchange_weak (count, count + 1));
+
+		if (KeyDerivationQueue.TryDequeue (workItem))
+			return true;
+
+		KeyDerivationThreadCount.fetch_sub (1);
+		return false;
+	}
+
+	bool EncryptionThreadPool::WorkQueue::TryDequeue (WorkItem &workItem)
+	{
+		size_t position = DequeuePosition.load (std::memory_order_relaxed);
+
+		while (true)
+		{
+			Slot &slot = Slots[position & (QueueSize - 1)];
+			size_t sequence = slot.Sequence.load (std::memory_order_acquire);
+			ptrdiff_t diff = (ptrdiff_t) sequence - (ptrdiff_t) (position + 1);
+
+			if (diff == 0)
+			{
+				if (DequeuePosition.compare_exchange_weak (position, position + 1, std::memory_order_relaxed))
 				{
-					if (workItem->Type == WorkType::DeriveKey)
-						workItem->KeyDerivation.WorkItem->ItemException.reset (new ExternalException (SRC_POS, StringConverter::ToExceptionString (e)));
-					else
-						workItem->FirstFragment->ItemException.reset (new ExternalException (SRC_POS, StringConverter::ToExceptionString (e)));
+					workItem = slot.Item;
+					slot.Sequence.store (position + QueueSize, std::memory_order_release);
+					return true;
 				}
-				catch (...)
+			}
+			else if (diff < 0)
+				return false;
+			else
+				position = DequeuePosition.load (std::memory_order_relaxed);
+		}
+	}
+
+	bool EncryptionThreadPool::WorkQueue::TryEnqueue (const WorkItem &workItem)
+	{
+		size_t position = EnqueuePosition.load (std::memory_order_relaxed);
+
+		while (true)
+		{
+			Slot &slot = Slots[position & (QueueSize - 1)];
+			size_t sequence = slot.Sequence.load (std::memory_order_acquire);
+			ptrdiff_t diff = (ptrdiff_t) sequence - (ptrdiff_t) position;
+
+			if (diff == 0)
+			{
+				if (EnqueuePosition.compare_exchange_weak (position, position + 1, std::memory_order_relaxed))
 				{
-					if (workItem->Type == WorkType::DeriveKey)
-						workItem->KeyDerivation.WorkItem->ItemException.reset (new UnknownException (SRC_POS));
-					else
-						workItem->FirstFragment->ItemException.reset (new UnknownException (SRC_POS));
+					slot.Item = workItem;
+					slot.Sequence.store (position + 1, std::memory_order_release);
+					return true;
 				}
+			}
+			else if (diff < 0)
+				return false;
+			else
+				position = EnqueuePosition.load (std::memory_order_relaxed);
+		}
+	}
+
+	void EncryptionThreadPool::UpdateMaxKeyDerivationThreadCount ()
+	{
+		// By default, one worker in eight is reserved for data units, in addition to the threads
+		// submitting them, which process their own fragments
+		size_t reservedCount = ThreadCount / 8;
+		if (reservedCount < 1)
+			reservedCount = 1;
+
+		size_t maxCount = ThreadCount > reservedCount ? ThreadCount - reservedCount : 1;
+		if (KeyDerivationThreadLimit > 0 && KeyDerivationThreadLimit < maxCount)
+			maxCount = KeyDerivationThreadLimit;
+
+		MaxKeyDerivationThreadCount = maxCount;
+	}
+
+	void EncryptionThreadPool::WakeUpIdleWorker (size_t node)
+	{
+		// Prefer a worker of the given node
+		for (size_t i = 0; i < ThreadCount; ++i)
+		{
+			Worker &worker = *Workers[(NodeFirstWorker[node] + i) % ThreadCount];
+
+			bool idle = true;
+			if (worker.Idle.load (std::memory_order_relaxed) && worker.Idle.compare_exchange_strong (idle, false))
+			{
+				IdleWorkerCount.fetch_sub (1);
+				worker.WakeUpEvent.Signal();
+				return;
+			}
+		}
+	}
+
+	void EncryptionThreadPool::WorkThreadProc (size_t workerIndex)
+	{
+		try
+		{
+			Worker &worker = *Workers[workerIndex];
+			WorkItem workItem;
+
+#ifdef TC_LINUX
+			// Keep the worker on the CPUs of its node so that its data and cache lines stay local
+			if (NodeCount > 1)
+				pthread_setaffinity_np (pthread_self(), sizeof (cpu_set_t), &NodeCpuSets[worker.Node]);
+#endif
 
-				if (workItem->Type == WorkType::DeriveKey)
+			while (!StopPending)
+			{
+				// Data units always take precedence over key derivation
+				bool keyDerivation = false;
+
+				if (!TryDequeue (worker.Node, workItem) && !(keyDerivation = TryDequeueKeyDerivation (workItem)))
 				{
-					workItem->KeyDerivation.WorkItem->Completed.Set (true);
-					workItem->KeyDerivation.CompletionEvent->Signal();
+					if (!worker.Idle.exchange (true))
+						IdleWorkerCount.fetch_add (1);
+
+					std::atomic_thread_fence (std::memory_order_seq_cst);
+
+					bool itemDequeued = TryDequeue (worker.Node, workItem) || (keyDerivation = TryDequeueKeyDerivation (workItem));
+
+					if (!itemDequeued && !StopPending)
 					{
-						ScopeLock outstandingWorkItemLock (KeyDerivationCompletionMutex);
-						if (workItem->KeyDerivation.OutstandingWorkItemCount->Decrement() == 0)
-							workItem->KeyDerivation.NoOutstandingWorkItemEvent->Signal();
+						worker.WakeUpEvent.Wait();
+						continue;
 					}
-					workItem->State.Set (WorkItem::State::Free);
-					WorkItemCompletedEvent.Signal();
-					continue;
-				}
 
-				if (workItem != workItem->FirstFragment)
-				{
-					workItem->State.Set (WorkItem::State::Free);
-					WorkItemCompletedEvent.Signal();
+					// If a producer has already claimed this worker, its wake-up signal remains pending
+					// and only causes one extra iteration
+					bool idle = true;
+					if (worker.Idle.compare_exchange_strong (idle, false))
+						IdleWorkerCount.fetch_sub (1);
+
+					if (!itemDequeued)
+						continue;
 				}
 
-				if (workItem->FirstFragment->OutstandingFragmentCount.Decrement() == 0)
-					workItem->FirstFragment->ItemCompletedEvent.Signal();
+				ProcessWorkItem (workItem);
+
+				if (keyDerivation)
+					KeyDerivationThreadCount.fetch_sub (1);
 			}
 		}
 		catch (exception &e)
@@ -398,19 +1186,20 @@ namespace VeraCrypt
 	volatile bool EncryptionThreadPool::ThreadPoolRunning = false;
 	volatile bool EncryptionThreadPool::StopPending = false;
 
+	size_t EncryptionThreadPool::NodeCount = 1;
+	size_t EncryptionThreadPool::NodeFirstWorker[MaxNodeCount];
 	size_t EncryptionThreadPool::ThreadCount;
 
-	EncryptionThreadPool::WorkItem EncryptionThreadPool::WorkItemQueue[QueueSize];
+	EncryptionThreadPool::WorkQueue EncryptionThreadPool::WorkQueues[MaxNodeCount];
+	vector < shared_ptr <EncryptionThreadPool::Worker> > EncryptionThreadPool::Workers;
 
-	volatile size_t EncryptionThreadPool::EnqueuePosition;
-	volatile size_t EncryptionThreadPool::DequeuePosition;
+	std::atomic <size_t> EncryptionThreadPool::IdleWorkerCount;
 
-	Mutex EncryptionThreadPool::EnqueueMutex;
-	Mutex EncryptionThreadPool::DequeueMutex;
 	Mutex EncryptionThreadPool::KeyDerivationCompletionMutex;
-
-	SyncEvent EncryptionThreadPool::WorkItemReadyEvent;
-	SyncEvent EncryptionThreadPool::WorkItemCompletedEvent;
+	EncryptionThreadPool::WorkQueue EncryptionThreadPool::KeyDerivationQueue;
+	std::atomic <size_t> EncryptionThreadPool::KeyDerivationThreadCount;
+	size_t EncryptionThreadPool::KeyDerivationThreadLimit = 0;
+	std::atomic <size_t> EncryptionThreadPool::MaxKeyDerivationThreadCount;
 
 	list < shared_ptr <Thread> > EncryptionThreadPool::RunningThreads;
 }
@@ -13,6 +13,7 @@
 #ifndef TC_HEADER_Volume_EncryptionThreadPool
 #define TC_HEADER_Volume_EncryptionThreadPool
 
+#include <atomic>
 #include "Platform/Platform.h"
 #include "EncryptionMode.h"
 
@@ -30,36 +31,87 @@ namespace VeraCrypt
 			{
 				EncryptDataUnits,
 				DecryptDataUnits,
-				DeriveKey
+				DeriveKey,
+				ParallelTasks
 			};
 		};
 
+		struct EncryptionBatch;
 		struct KeyDerivationWorkItem;
 
-		struct WorkItem
+		// Called by the thread completing an asynchronous request, with the exception thrown while processing
+		// one of its fragments or nullptr on success. The data is ready when it is called. Must not throw.
+		struct CompletionCallback
 		{
-			struct State
-			{
-				enum Enum
-				{
-					Free,
-					Ready,
-					Busy
-				};
-			};
+			virtual ~CompletionCallback () { }
+			virtual void operator() (const Exception *itemException) = 0;
+		};
+
+		// Independent parts of a computation, identified by their index, which may run concurrently
+		struct ParallelTask
+		{
+			virtual ~ParallelTask () { }
+			// Called by RunTasks () before any task is run, with the number of threads (the calling one included) taking part
+			// in the call. Returns the number of tasks to run, which must not exceed the one passed to RunTasks ().
+			virtual size_t GetTaskCount (size_t taskCount, size_t threadCount) { (void) threadCount; return taskCount; }
+			virtual void operator() (size_t taskIndex) = 0;
+		};
+
+		// State shared by the fragments of an encryption request. A synchronous request is owned by the calling
+		// thread; an asynchronous one is kept alive by Self until its last fragment is completed.
+		struct EncryptionRequest
+		{
+			EncryptionRequest (size_t fragmentCount, size_t node) : Node (node), OutstandingFragmentCount (fragmentCount), Waited (false) { }
 
-			struct WorkItem *FirstFragment;
+			bool IsCompleted () const { return OutstandingFragmentCount.load (std::memory_order_acquire) == 0; }
+			// Processes queued fragments while the request is outstanding, waits for its completion and rethrows the exception of a failed fragment
+			void Wait ();
+
+			shared_ptr <CompletionCallback> Callback;
+			SyncEvent CompletedEvent;
 			unique_ptr <Exception> ItemException;
-			SyncEvent ItemCompletedEvent;
-			SharedVal <size_t> OutstandingFragmentCount;
-			SharedVal <State::Enum> State;
+			Mutex ItemExceptionMutex;
+			size_t Node;
+			std::atomic <size_t> OutstandingFragmentCount;
+			shared_ptr <EncryptionRequest> Self;
+			bool Waited;
+
+		private:
+			EncryptionRequest (const EncryptionRequest &);
+			EncryptionRequest &operator= (const EncryptionRequest &);
+		};
+
+		// Tasks of a RunTasks () call, claimed by index by the calling thread and by the work items queued for the workers.
+		// The group is released by the calling thread and by each of the work items, the last of which deletes it, so that
+		// work items dequeued after all the tasks are completed do not access the calling thread.
+		struct TaskGroup
+		{
+			TaskGroup (ParallelTask &task, size_t taskCount, size_t referenceCount)
+				: NextTaskIndex (0), ReferenceCount (referenceCount), Request (taskCount, GetSubmissionNode (nullptr)), Task (task), TaskCount (taskCount) { }
+
+			std::atomic <size_t> NextTaskIndex;
+			std::atomic <size_t> ReferenceCount;
+			EncryptionRequest Request;
+			ParallelTask &Task;
+			size_t TaskCount;
+
+		private:
+			TaskGroup (const TaskGroup &);
+			TaskGroup &operator= (const TaskGroup &);
+		};
+
+		struct WorkItem
+		{
 			WorkType::Enum Type;
 
 			union
 			{
 				struct
 				{
+					EncryptionBatch *Batch;		// If set, the other members are not used
 					const EncryptionMode *Mode;
+					EncryptionRequest *Request;
+					const uint8 *Source;
 					uint8 *Data;
 					uint64 StartUnitNo;
 					uint64 UnitCount;
@@ -78,9 +130,25 @@ namespace VeraCrypt
 					size_t SaltSize;
 					KeyDerivationWorkItem *WorkItem;
 				} KeyDerivation;
+
+				struct
+				{
+					TaskGroup *Group;
+				} Tasks;
 			};
 		};
 
+		// Pieces of discontiguous runs that make up one fragment, processed as a single work item
+		struct EncryptionBatch
+		{
+			static const size_t MaxSegmentCount = 32;
+
+			WorkType::Enum Type;
+			const EncryptionMode *Mode;
+			size_t SegmentCount;
+			WorkItem Segments[MaxSegmentCount];
+		};
+
 		struct KeyDerivationWorkItem
 		{
 			KeyDerivationWorkItem (shared_ptr <Pkcs5Kdf> kdf, size_t derivedKeySize);
@@ -96,30 +164,98 @@ namespace VeraCrypt
 
 		// Caller-owned references and pointers must remain valid until noOutstandingWorkItemEvent is signaled.
 		static void BeginKeyDerivation (KeyDerivationWorkItem &keyDerivationWorkItem, const VolumePassword &password, int pim, const ConstBufferPtr &salt, SyncEvent &completionEvent, SyncEvent &noOutstandingWorkItemEvent, SharedVal <size_t> &outstandingWorkItemCount, long volatile *abortFlag);
+		// Starts encrypting or decrypting data units and returns without waiting for them. The buffers and the mode must remain
+		// valid until the request is completed. The callback, if any, is called from the thread completing the request.
+		static shared_ptr <EncryptionRequest> BeginWork (WorkType::Enum type, const EncryptionMode *mode, const uint8 *source, uint8 *data, uint64 startUnitNo, uint64 unitCount, size_t sectorSize, shared_ptr <CompletionCallback> callback = shared_ptr <CompletionCallback> ());
+		// Processes discontiguous runs of data units in place as a single request
+		static shared_ptr <EncryptionRequest> BeginWork (WorkType::Enum type, const EncryptionMode *mode, const SectorRunList &runs, size_t sectorSize, shared_ptr <CompletionCallback> callback = shared_ptr <CompletionCallback> ());
 		static void DoWork (WorkType::Enum type, const EncryptionMode *mode, uint8 *data, uint64 startUnitNo, uint64 unitCount, size_t sectorSize);
+		// Encrypts data units read from source into data (source is not modified)
+		static void DoWork (WorkType::Enum type, const EncryptionMode *mode, const uint8 *source, uint8 *data, uint64 startUnitNo, uint64 unitCount, size_t sectorSize);
+		static void DoWork (WorkType::Enum type, const EncryptionMode *mode, const SectorRunList &runs, size_t sectorSize);
+		// Returns the number of threads, the calling one included, that may run the tasks of a RunTasks () call
+		static size_t GetMaxTaskConcurrency (bool keyDerivation);
 		static bool IsRunning () { return ThreadPoolRunning; }
+		// Runs up to taskCount tasks (see ParallelTask::GetTaskCount ()) on the workers and the calling thread and returns when
+		// all of them are completed, rethrowing the exception of a failed task. Key derivation tasks are subject to the key
+		// derivation thread limit.
+		static void RunTasks (ParallelTask &task, size_t taskCount, bool keyDerivation);
+		// Limits the number of workers deriving keys at the same time (0 selects the default). Some workers are always kept for data units.
+		static void SetKeyDerivationThreadLimit (size_t limit);
 		static void Start ();
 		static void Stop ();
 
 	protected:
-		static void WorkThreadProc ();
+		static const uint64 DefaultProcessingCost = 1000;	// Picoseconds per byte assumed until the cost of a mode is measured
+		static const size_t MinFragmentSize = 16 * 1024;
+		static const uint64 MinFragmentTime = 25000;		// Nanoseconds, well above the latency of waking a worker and collecting its result
+		static const size_t MaxNodeCount = 8;		// Further NUMA nodes share the queue of the last one
+		static const size_t MaxThreadCount = 1024;
+		static const size_t QueueSize = 256;		// Per node, must be a power of two
+
+		// Bounded lock-free multi-producer/multi-consumer ring of work items. Sequence tells whether
+		// a slot is free for the enqueue position it is reached at (Sequence == position) or holds
+		// an item ready for the dequeue position (Sequence == position + 1).
+		struct WorkQueue
+		{
+			struct Slot
+			{
+				std::atomic <size_t> Sequence;
+				WorkItem Item;
+			};
+
+			void Reset ();
+			bool TryDequeue (WorkItem &workItem);
+			bool TryEnqueue (const WorkItem &workItem);
+
+			std::atomic <size_t> DequeuePosition;
+			std::atomic <size_t> EnqueuePosition;
+			Slot Slots[QueueSize];
+		};
+
+		// A worker parks on its own event when all queues are empty. Producers wake only as many
+		// idle workers as they enqueued items, so no shared condition variable is involved.
+		struct Worker
+		{
+			std::atomic <bool> Idle;
+			size_t Node;
+			SyncEvent WakeUpEvent;
+		};
 
-		static const size_t MaxThreadCount = 32;
-		static const size_t QueueSize = MaxThreadCount * 2;
+		static void CompleteFragment (EncryptionRequest *request);
+		static void Enqueue (size_t node, const WorkItem &workItem);
+		static void EnqueueKeyDerivation (const WorkItem &workItem);
+		static size_t GetFragmentCount (const EncryptionMode *mode, uint64 unitCount, size_t sectorSize);
+		static size_t GetSubmissionNode (const void *data);
+		static void ProcessBatch (EncryptionBatch *batch);
+		static void ProcessTasks (TaskGroup &group);
+		static void ProcessWorkItem (WorkItem &workItem);
+		static void ReleaseTaskGroup (TaskGroup *group);
+		static void SubmitBatch (size_t node, EncryptionBatch *batch);
+		static void SubmitFragments (EncryptionRequest &request, size_t fragmentCount, WorkType::Enum type, const EncryptionMode *mode, const uint8 *source, uint8 *data, uint64 startUnitNo, uint64 unitCount, size_t sectorSize);
+		static void SubmitRuns (EncryptionRequest &request, size_t fragmentCount, WorkType::Enum type, const EncryptionMode *mode, const SectorRunList &runs, uint64 unitCount, size_t sectorSize);
+		static bool TryDequeue (size_t node, WorkItem &workItem);
+		static bool TryDequeueKeyDerivation (WorkItem &workItem);
+		static void UpdateMaxKeyDerivationThreadCount ();
+		static void WakeUpIdleWorker (size_t node);
+		static void WorkThreadProc (size_t workerIndex);
 
-		static Mutex DequeueMutex;
-		static volatile size_t DequeuePosition;
-		static volatile size_t EnqueuePosition;
-		static Mutex EnqueueMutex;
+		static std::atomic <size_t> IdleWorkerCount;
 		// Orders KDF outstanding-count transitions against no-outstanding event updates.
 		static Mutex KeyDerivationCompletionMutex;
+		// Key derivation items have their own queue, served only when no data units are queued and by a limited number of workers
+		static WorkQueue KeyDerivationQueue;
+		static std::atomic <size_t> KeyDerivationThreadCount;
+		static size_t KeyDerivationThreadLimit;
+		static std::atomic <size_t> MaxKeyDerivationThreadCount;
+		static size_t NodeCount;
+		static size_t NodeFirstWorker[MaxNodeCount];
 		static list < shared_ptr <Thread> > RunningThreads;
 		static volatile bool StopPending;
 		static size_t ThreadCount;
 		static volatile bool ThreadPoolRunning;
-		static SyncEvent WorkItemCompletedEvent;
-		static WorkItem WorkItemQueue[QueueSize];
-		static SyncEvent WorkItemReadyEvent;
+		static vector < shared_ptr <Worker> > Workers;
+		static WorkQueue WorkQueues[MaxNodeCount];
 	};
 }
 
@@ -10,8 +10,11 @@
  code distribution packages.
 */
 
+#include "Common/Crypto.h"
 #include "Common/Pkcs5.h"
 #include "Platform/StringConverter.h"
+#include "Argon2Arena.h"
+#include "EncryptionThreadPool.h"
 #include "Pkcs5Kdf.h"
 #include "VolumePassword.h"
 #if !defined (WOLFCRYPT_BACKEND) && !defined (VC_DCS_DISABLE_ARGON2)
@@ -52,11 +55,12 @@ namespace VeraCrypt
 
 	shared_ptr <Pkcs5Kdf> Pkcs5Kdf::GetAlgorithm (const wstring &name)
 	{
-		foreach (shared_ptr <Pkcs5Kdf> kdf, GetAvailableAlgorithms())
+		foreach (shared_ptr <Pkcs5Kdf> kdf, GetSelectableAlgorithms())
 		{
 			if (kdf->GetName() == name || (kdf->IsArgon2() && name == L"Argon2id"))
 				return kdf;
 		}
+
 		throw ParameterIncorrect (SRC_POS);
 	}
 
@@ -91,6 +95,18 @@ namespace VeraCrypt
 		return l;
 	}
 
+	Pkcs5KdfList Pkcs5Kdf::GetSelectableAlgorithms ()
+	{
+		Pkcs5KdfList l = GetAvailableAlgorithms ();
+
+    #if !defined (WOLFCRYPT_BACKEND) && !defined (VC_DCS_DISABLE_ARGON2)
+		// Multi-lane Argon2 is not tried when the KDF of a volume is detected, so it is only available when selected
+		for (uint32 lanes = 2; lanes <= ARGON2_MAX_HEADER_LANES; ++lanes)
+			l.push_back (shared_ptr <Pkcs5Kdf> (new Pkcs5Argon2 (lanes)));
+    #endif
+		return l;
+	}
+
 	void Pkcs5Kdf::ValidateParameters (const BufferPtr &key, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount) const
 	{
 		if (key.Size() < 1 || password.Size() < 1 || salt.Size() < 1 || iterationCount < 1)
@@ -98,6 +114,51 @@ namespace VeraCrypt
 	}
 
     #ifndef WOLFCRYPT_BACKEND
+	// Each task derives a contiguous range of output blocks, so that a range can use a multi-block kernel
+	struct DeriveKeyBlockTask : public EncryptionThreadPool::ParallelTask
+	{
+		DeriveKeyBlockTask (Pkcs5Kdf::DeriveKeyBlocksFunction deriveKeyBlocks, size_t blockSize, size_t blockCount, size_t minTaskBlockCount, const BufferPtr &key, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount, long volatile *pAbortKeyDerivation)
+			: AbortFlag (pAbortKeyDerivation), BlockCount (blockCount), BlockSize (blockSize), DeriveKeyBlocks (deriveKeyBlocks), IterationCount (iterationCount), Key (key), MinTaskBlockCount (minTaskBlockCount), Password (password), Salt (salt), TaskCount (1) { }
+
+		virtual size_t GetTaskCount (size_t taskCount, size_t threadCount)
+		{
+			// A range is not made smaller than the number of blocks from which the multi-block kernel is used, whose lanes
+			// derive them for less than the cost of a chain per block. The remaining threads are left to other derivations.
+			TaskCount = max ((size_t) 1, min (min (taskCount, threadCount), BlockCount / MinTaskBlockCount));
+			return TaskCount;
+		}
+
+		virtual void operator() (size_t taskIndex)
+		{
+			size_t firstBlock = taskIndex * BlockCount / TaskCount;
+			size_t endBlock = (taskIndex + 1) * BlockCount / TaskCount;
+			size_t offset = firstBlock * BlockSize;
+			size_t size = min (endBlock * BlockSize, Key.Size()) - offset;
+
+			DeriveKeyBlocks (Password.DataPtr(), (int) Password.Size(), Salt.Get(), (int) Salt.Size(), IterationCount, Key.Get() + offset, (int) size, (int) firstBlock, AbortFlag);
+		}
+
+		long volatile *AbortFlag;
+		size_t BlockCount;
+		size_t BlockSize;
+		Pkcs5Kdf::DeriveKeyBlocksFunction DeriveKeyBlocks;
+		int IterationCount;
+		const BufferPtr &Key;
+		size_t MinTaskBlockCount;
+		const VolumePassword &Password;
+		const ConstBufferPtr &Salt;
+		size_t TaskCount;
+	};
+
+	void Pkcs5Kdf::DeriveKeyBlocks (DeriveKeyBlocksFunction deriveKeyBlocks, int minTaskBlockCount, const BufferPtr &key, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount, long volatile *pAbortKeyDerivation) const
+	{
+		size_t blockSize = GetHash()->GetDigestSize();
+		size_t blockCount = (key.Size() + blockSize - 1) / blockSize;
+
+		DeriveKeyBlockTask task (deriveKeyBlocks, blockSize, blockCount, (size_t) max (minTaskBlockCount, 1), key, password, salt, iterationCount, pAbortKeyDerivation);
+		EncryptionThreadPool::RunTasks (task, blockCount, true);
+	}
+
 	int Pkcs5HmacBlake2s_Boot::DeriveKey (const BufferPtr &key, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount) const
 	{
 		return DeriveKey (key, password, salt, iterationCount, nullptr);
@@ -106,7 +167,7 @@ namespace VeraCrypt
 	int Pkcs5HmacBlake2s_Boot::DeriveKey (const BufferPtr &key, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount, long volatile *pAbortKeyDerivation) const
 	{
 		ValidateParameters (key, password, salt, iterationCount);
-		derive_key_blake2s (password.DataPtr(), (int) password.Size(), salt.Get(), (int) salt.Size(), iterationCount, key.Get(), (int) key.Size(), pAbortKeyDerivation);
+		DeriveKeyBlocks (derive_key_blake2s_blocks, derive_key_blake2s_min_blocks (), key, password, salt, iterationCount, pAbortKeyDerivation);
 		return 0;
 	}
 
@@ -118,7 +179,7 @@ namespace VeraCrypt
 	int Pkcs5HmacBlake2s::DeriveKey (const BufferPtr &key, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount, long volatile *pAbortKeyDerivation) const
 	{
 		ValidateParameters (key, password, salt, iterationCount);
-		derive_key_blake2s (password.DataPtr(), (int) password.Size(), salt.Get(), (int) salt.Size(), iterationCount, key.Get(), (int) key.Size(), pAbortKeyDerivation);
+		DeriveKeyBlocks (derive_key_blake2s_blocks, derive_key_blake2s_min_blocks (), key, password, salt, iterationCount, pAbortKeyDerivation);
 		return 0;
 	}
     #endif
@@ -131,7 +192,11 @@ namespace VeraCrypt
 	int Pkcs5HmacSha256_Boot::DeriveKey (const BufferPtr &key, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount, long volatile *pAbortKeyDerivation) const
 	{
 		ValidateParameters (key, password, salt, iterationCount);
+#ifdef WOLFCRYPT_BACKEND
 		derive_key_sha256 (password.DataPtr(), (int) password.Size(), salt.Get(), (int) salt.Size(), iterationCount, key.Get(), (int) key.Size(), pAbortKeyDerivation);
+#else
+		DeriveKeyBlocks (derive_key_sha256_blocks, derive_key_sha256_min_blocks (), key, password, salt, iterationCount, pAbortKeyDerivation);
+#endif
 		return 0;
 	}
 
@@ -143,7 +208,11 @@ namespace VeraCrypt
 	int Pkcs5HmacSha256::DeriveKey (const BufferPtr &key, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount, long volatile *pAbortKeyDerivation) const
 	{
 		ValidateParameters (key, password, salt, iterationCount);
+#ifdef WOLFCRYPT_BACKEND
 		derive_key_sha256 (password.DataPtr(), (int) password.Size(), salt.Get(), (int) salt.Size(), iterationCount, key.Get(), (int) key.Size(), pAbortKeyDerivation);
+#else
+		DeriveKeyBlocks (derive_key_sha256_blocks, derive_key_sha256_min_blocks (), key, password, salt, iterationCount, pAbortKeyDerivation);
+#endif
 		return 0;
 	}
 
@@ -155,7 +224,11 @@ namespace VeraCrypt
 	int Pkcs5HmacSha512::DeriveKey (const BufferPtr &key, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount, long volatile *pAbortKeyDerivation) const
 	{
 		ValidateParameters (key, password, salt, iterationCount);
+#ifdef WOLFCRYPT_BACKEND
 		derive_key_sha512 (password.DataPtr(), (int) password.Size(), salt.Get(), (int) salt.Size(), iterationCount, key.Get(), (int) key.Size(), pAbortKeyDerivation);
+#else
+		DeriveKeyBlocks (derive_key_sha512_blocks, derive_key_sha512_min_blocks (), key, password, salt, iterationCount, pAbortKeyDerivation);
+#endif
 		return 0;
 	}
 
@@ -168,7 +241,7 @@ namespace VeraCrypt
 	int Pkcs5HmacWhirlpool::DeriveKey (const BufferPtr &key, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount, long volatile *pAbortKeyDerivation) const
 	{
 		ValidateParameters (key, password, salt, iterationCount);
-		derive_key_whirlpool (password.DataPtr(), (int) password.Size(), salt.Get(), (int) salt.Size(), iterationCount, key.Get(), (int) key.Size(), pAbortKeyDerivation);
+		DeriveKeyBlocks (derive_key_whirlpool_blocks, 1, key, password, salt, iterationCount, pAbortKeyDerivation);
 		return 0;
 	}
 	
@@ -180,11 +253,141 @@ namespace VeraCrypt
 	int Pkcs5HmacStreebog::DeriveKey (const BufferPtr &key, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount, long volatile *pAbortKeyDerivation) const
 	{
 		ValidateParameters (key, password, salt, iterationCount);
-		derive_key_streebog (password.DataPtr(), (int) password.Size(), salt.Get(), (int) salt.Size(), iterationCount, key.Get(), (int) key.Size(), pAbortKeyDerivation);
+		DeriveKeyBlocks (derive_key_streebog_blocks, 1, key, password, salt, iterationCount, pAbortKeyDerivation);
 		return 0;
 	}
 
 	#ifndef VC_DCS_DISABLE_ARGON2
+	// Fills the lanes of each Argon2 slice on threads owned by the derivation. Pool workers are not used since the derivation
+	// usually runs on a key derivation worker itself, and waiting there for other workers, slice after slice, deadlocks
+	// when all key derivation slots are held by derivations doing the same.
+	class Argon2LaneThreads
+	{
+	public:
+		Argon2LaneThreads (size_t threadCount) : FillLane (nullptr), LaneData (nullptr), Lanes (0), NextLane (0), PendingLanes (0), Result (ARGON2_OK), StopPending (false)
+		{
+			try
+			{
+				for (size_t i = 0; i < threadCount; ++i)
+				{
+					shared_ptr <LaneThread> laneThread (new LaneThread (*this));
+					laneThread->SystemThread.Start (ThreadProc, laneThread.get());
+					LaneThreads.push_back (laneThread);
+				}
+			}
+			catch (...)
+			{
+				Stop();
+				throw;
+			}
+		}
+
+		~Argon2LaneThreads ()
+		{
+			Stop();
+		}
+
+		// Lanes are claimed by the calling thread and the lane threads as they become available
+		int RunSlice (argon2_fill_lane_fptr fillLane, void *laneData, uint32_t lanes)
+		{
+			FillLane = fillLane;
+			LaneData = laneData;
+			Lanes = lanes;
+			Result = ARGON2_OK;
+			PendingLanes = lanes;
+			NextLane = 0;
+
+			foreach (shared_ptr <LaneThread> laneThread, LaneThreads)
+				laneThread->StartEvent.Signal();
+
+			FillLanes();
+			SliceCompletedEvent.Wait();
+
+			return Result;
+		}
+
+		static int RunLanes (argon2_fill_lane_fptr fillLane, void *laneData, uint32_t lanes, void *schedulerData)
+		{
+			try
+			{
+				return ((Argon2LaneThreads *) schedulerData)->RunSlice (fillLane, laneData, lanes);
+			}
+			catch (...)
+			{
+				return ARGON2_THREAD_FAIL;
+			}
+		}
+
+	protected:
+		struct LaneThread
+		{
+			LaneThread (Argon2LaneThreads &owner) : Owner (owner) { }
+
+			Argon2LaneThreads &Owner;
+			SyncEvent StartEvent;
+			Thread SystemThread;
+		};
+
+		void FillLanes ()
+		{
+			size_t lane;
+			while ((lane = NextLane.fetch_add (1)) < Lanes)
+			{
+				int result = FillLane (LaneData, (uint32_t) lane);
+				if (result != ARGON2_OK)
+					Result = result;
+
+				if (PendingLanes.fetch_sub (1) == 1)
+					SliceCompletedEvent.Signal();
+			}
+		}
+
+		void Stop ()
+		{
+			StopPending = true;
+
+			foreach (shared_ptr <LaneThread> laneThread, LaneThreads)
+			{
+				laneThread->StartEvent.Signal();
+				laneThread->SystemThread.Join();
+			}
+
+			LaneThreads.clear();
+		}
+
+		static TC_THREAD_PROC ThreadProc (void *parameter)
+		{
+			LaneThread &laneThread = *(LaneThread *) parameter;
+
+			while (true)
+			{
+				laneThread.StartEvent.Wait();
+
+				if (laneThread.Owner.StopPending)
+					break;
+
+				// A thread woken after all lanes of the slice have been claimed finds none left
+				laneThread.Owner.FillLanes();
+			}
+
+			return 0;
+		}
+
+		argon2_fill_lane_fptr FillLane;
+		void *LaneData;
+		size_t Lanes;
+		vector < shared_ptr <LaneThread> > LaneThreads;
+		std::atomic <size_t> NextLane;
+		std::atomic <size_t> PendingLanes;
+		std::atomic <int> Result;
+		SyncEvent SliceCompletedEvent;
+		std::atomic <bool> StopPending;
+
+	private:
+		Argon2LaneThreads (const Argon2LaneThreads &);
+		Argon2LaneThreads &operator= (const Argon2LaneThreads &);
+	};
+
 	int Pkcs5Argon2::DeriveKey (const BufferPtr &key, const VolumePassword &password, int pim, const ConstBufferPtr &salt) const
 	{
 		return DeriveKey (key, password, pim, salt, nullptr);
@@ -197,7 +400,15 @@ namespace VeraCrypt
 		get_argon2_params (pim, &iterationCount, &memoryCost);
 
 		ValidateParameters (key, password, salt, iterationCount);
-		return derive_key_argon2 (password.DataPtr(), (int) password.Size(), salt.Get(), (int) salt.Size(), iterationCount, memoryCost, key.Get(), (int) key.Size(), pAbortKeyDerivation);
+
+		// Lanes of a slice are filled sequentially if no other thread is to be used
+		unique_ptr <Argon2LaneThreads> laneThreads;
+		size_t laneThreadCount = min ((size_t) Lanes, EncryptionThreadPool::GetMaxTaskConcurrency (true)) - 1;
+		if (laneThreadCount > 0)
+			laneThreads.reset (new Argon2LaneThreads (laneThreadCount));
+
+		return derive_key_argon2_lanes (password.DataPtr(), (int) password.Size(), salt.Get(), (int) salt.Size(), iterationCount, memoryCost, Lanes,
+			laneThreads.get() ? Argon2LaneThreads::RunLanes : nullptr, laneThreads.get(), Argon2Arena::Allocate, Argon2Arena::Free, key.Get(), (int) key.Size(), pAbortKeyDerivation);
 	}
 
 	int Pkcs5Argon2::DeriveKey (const BufferPtr &key, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount) const
@@ -220,6 +431,20 @@ namespace VeraCrypt
 		return L"Argon2 key derivation failed: " + StringConverter::ToWide (argon2_error_message (result));
 	}
 
+	bool Pkcs5Argon2::IsFatalDerivationFailure (int result) const
+	{
+		// Out of resources: the password may be correct
+		return result == ARGON2_MEMORY_ALLOCATION_ERROR || result == ARGON2_THREAD_FAIL;
+	}
+
+	wstring Pkcs5Argon2::GetName () const
+	{
+		if (Lanes == 1)
+			return L"Argon2";
+
+		return L"Argon2:" + StringConverter::FromNumber (Lanes);
+	}
+
 	int Pkcs5Argon2::GetIterationCount (int pim) const
 	{
 		int iterationCount;
@@ -237,7 +462,7 @@ namespace VeraCrypt
 	int Pkcs5HmacStreebog_Boot::DeriveKey (const BufferPtr &key, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount, long volatile *pAbortKeyDerivation) const
 	{
 		ValidateParameters (key, password, salt, iterationCount);
-		derive_key_streebog (password.DataPtr(), (int) password.Size(), salt.Get(), (int) salt.Size(), iterationCount, key.Get(), (int) key.Size(), pAbortKeyDerivation);
+		DeriveKeyBlocks (derive_key_streebog_blocks, 1, key, password, salt, iterationCount, pAbortKeyDerivation);
 		return 0;
 	}
     #endif
@@ -25,6 +25,10 @@ namespace VeraCrypt
 	class Pkcs5Kdf
 	{
 	public:
+    #ifndef WOLFCRYPT_BACKEND
+		typedef void (*DeriveKeyBlocksFunction) (const unsigned char *pwd, int pwd_len, const unsigned char *salt, int salt_len, uint32 iterations, unsigned char *dk, int dklen, int first_block, long volatile *pAbortKeyDerivation);
+    #endif
+
 		virtual ~Pkcs5Kdf ();
 
 		virtual int DeriveKey (const BufferPtr &key, const VolumePassword &password, int pim, const ConstBufferPtr &salt) const;
@@ -34,6 +38,7 @@ namespace VeraCrypt
 		static shared_ptr <Pkcs5Kdf> GetAlgorithm (const wstring &name);
 		static shared_ptr <Pkcs5Kdf> GetAlgorithm (const Hash &hash);
 		static Pkcs5KdfList GetAvailableAlgorithms ();
+		static Pkcs5KdfList GetSelectableAlgorithms ();
 		virtual shared_ptr <Hash> GetHash () const = 0;
 		virtual wstring GetDerivationFailureMessage (int result) const;
 		virtual int GetDefaultPim () const { return 485; }
@@ -45,13 +50,21 @@ namespace VeraCrypt
 		virtual wstring GetName () const = 0;
 		virtual Pkcs5Kdf* Clone () const = 0;
 		virtual bool IsArgon2 () const { return false; }
+		virtual bool IsAutoDetected () const { return true; }
 		virtual bool IsDeprecated () const { return GetHash()->IsDeprecated(); }
+		virtual bool IsFatalDerivationFailure (int result) const { (void) result; return false; }
 
 	protected:
 		Pkcs5Kdf ();
 
 		void ValidateParameters (const BufferPtr &key, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount) const;
 
+    #ifndef WOLFCRYPT_BACKEND
+		// PBKDF2 output blocks are independent of each other, so those of a key spanning several blocks are derived
+		// in parallel when the encryption thread pool is running, in ranges of at least minTaskBlockCount blocks
+		void DeriveKeyBlocks (DeriveKeyBlocksFunction deriveKeyBlocks, int minTaskBlockCount, const BufferPtr &key, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount, long volatile *pAbortKeyDerivation) const;
+    #endif
+
 	private:
 		Pkcs5Kdf (const Pkcs5Kdf &);
 		Pkcs5Kdf &operator= (const Pkcs5Kdf &);
@@ -191,7 +204,9 @@ namespace VeraCrypt
 	class Pkcs5Argon2 : public Pkcs5Kdf
 	{
 	public:
-		Pkcs5Argon2 () : Pkcs5Kdf() { }
+		// Headers use a single lane unless another number of lanes, up to ARGON2_MAX_HEADER_LANES, is selected
+		// when the volume is created. The lanes of each slice are filled on the key derivation threads.
+		Pkcs5Argon2 (uint32 lanes = 1) : Pkcs5Kdf(), Lanes (lanes) { }
 		virtual ~Pkcs5Argon2 () { }
 
 		virtual int DeriveKey (const BufferPtr &key, const VolumePassword &password, int pim, const ConstBufferPtr &salt) const;
@@ -206,9 +221,15 @@ namespace VeraCrypt
 		virtual const char *GetPimSmallWarningMessageId () const { return "PIM_ARGON2_SMALL_WARNING"; }
 		virtual const char *GetPimRequireLongPasswordMessageId () const { return "PIM_ARGON2_REQUIRE_LONG_PASSWORD"; }
 		virtual int GetIterationCount (int pim) const;
-		virtual wstring GetName () const { return L"Argon2"; }
-		virtual Pkcs5Kdf* Clone () const { return new Pkcs5Argon2(); }
+		uint32 GetLanes () const { return Lanes; }
+		virtual wstring GetName () const;
+		virtual Pkcs5Kdf* Clone () const { return new Pkcs5Argon2 (Lanes); }
 		virtual bool IsArgon2 () const { return true; }
+		virtual bool IsAutoDetected () const { return Lanes == 1; }
+		virtual bool IsFatalDerivationFailure (int result) const;
+
+	protected:
+		uint32 Lanes;
 
 	private:
 		Pkcs5Argon2 (const Pkcs5Argon2 &);
@@ -13,6 +13,7 @@
 #ifndef TC_WINDOWS
 #include <errno.h>
 #endif
+#include "Argon2Arena.h"
 #include "EncryptionModeXTS.h"
 #include "Volume.h"
 #include "VolumeHeader.h"
@@ -115,12 +116,19 @@ namespace VeraCrypt
 
 		try
 		{
+			// Header key derivations of all the layouts reuse the same Argon2 memory
+			Argon2Arena::Scope argon2Arena;
+
 			VolumeHostSize = VolumeFile->Length();
 			shared_ptr <VolumePassword> passwordKey = Keyfile::ApplyListToPassword (keyfiles, password, emvSupportEnabled);
 
 			bool skipLayoutV1Normal = false;
 
-			// Test volume layouts
+			// Read the headers of all volume layouts, so that they can be tested at once
+			vector < shared_ptr <VolumeLayout> > layouts;
+			vector < shared_ptr <SecureBuffer> > headerBuffers;
+			vector <VolumeHeaderCandidate> candidates;
+
 			foreach (shared_ptr <VolumeLayout> layout, VolumeLayout::GetAvailableLayouts (volumeType))
 			{
 				if (skipLayoutV1Normal && typeid (*layout) == typeid (VolumeLayoutV1Normal))
@@ -132,7 +140,7 @@ namespace VeraCrypt
 				if (useBackupHeaders && !layout->HasBackupHeader())
 					continue;
 
-				SecureBuffer headerBuffer (layout->GetHeaderSize());
+				shared_ptr <SecureBuffer> headerBuffer (new SecureBuffer (layout->GetHeaderSize()));
 
 				if (layout->HasDriveHeader())
 				{
@@ -152,7 +160,7 @@ namespace VeraCrypt
 					else
 						driveDevice.SeekEnd (headerOffset);
 
-					if (driveDevice.Read (headerBuffer) != layout->GetHeaderSize())
+					if (driveDevice.Read (*headerBuffer) != layout->GetHeaderSize())
 						continue;
 				}
 				else
@@ -167,7 +175,7 @@ namespace VeraCrypt
 					else
 						VolumeFile->SeekEnd (headerOffset);
 
-					if (VolumeFile->Read (headerBuffer) != layout->GetHeaderSize())
+					if (VolumeFile->Read (*headerBuffer) != layout->GetHeaderSize())
 						continue;
 				}
 
@@ -183,88 +191,102 @@ namespace VeraCrypt
 					layoutEncryptionModes = EncryptionMode::GetAvailableModes();
 				}
 
+				VolumeHeaderCandidate candidate;
+				candidate.Header = layout->GetHeader().get();
+				candidate.EncryptedData = *headerBuffer;
+				candidate.KeyDerivationFunctions = layout->GetSupportedKeyDerivationFunctions();
+				candidate.EncryptionAlgorithms = layoutEncryptionAlgorithms;
+				candidate.EncryptionModes = layoutEncryptionModes;
+
+				layouts.push_back (layout);
+				headerBuffers.push_back (headerBuffer);
+				candidates.push_back (candidate);
+			}
+
+			// Header keys of all layouts are derived concurrently, so that opening a hidden volume or failing
+			// with an incorrect password does not cost one full key derivation sweep per layout
+			size_t decryptedCandidate;
+			if (VolumeHeader::DecryptAny (candidates, *passwordKey, pim, kdf, decryptedCandidate))
+			{
+				// Header decrypted
+				shared_ptr <VolumeLayout> layout = layouts[decryptedCandidate];
 				shared_ptr <VolumeHeader> header = layout->GetHeader();
 
-				if (header->Decrypt (headerBuffer, *passwordKey, pim, kdf, layout->GetSupportedKeyDerivationFunctions(), layoutEncryptionAlgorithms, layoutEncryptionModes))
+				if (typeid (*layout) == typeid (VolumeLayoutV2Normal) && header->GetRequiredMinProgramVersion() < 0x10b)
 				{
-					// Header decrypted
+					// VolumeLayoutV1Normal has been opened as VolumeLayoutV2Normal
+					layout.reset (new VolumeLayoutV1Normal);
+					header->SetSize (layout->GetHeaderSize());
+					layout->SetHeader (header);
+				}
+
+				Pim = pim;
+				Type = layout->GetType();
+				SectorSize = header->GetSectorSize();
+
+				VolumeDataOffset = layout->GetDataOffset (VolumeHostSize);
+				VolumeDataSize = layout->GetDataSize (VolumeHostSize);
+				EncryptedDataSize = header->GetEncryptedAreaLength();
 
-					if (typeid (*layout) == typeid (VolumeLayoutV2Normal) && header->GetRequiredMinProgramVersion() < 0x10b)
+				Header = header;
+				Layout = layout;
+				EA = header->GetEncryptionAlgorithm();
+				EncryptionMode &mode = *EA->GetMode();
+
+				if (layout->HasDriveHeader())
+				{
+					if (header->GetEncryptedAreaLength() != header->GetVolumeDataSize())
 					{
-						// VolumeLayoutV1Normal has been opened as VolumeLayoutV2Normal
-						layout.reset (new VolumeLayoutV1Normal);
-						header->SetSize (layout->GetHeaderSize());
-						layout->SetHeader (header);
+						EncryptionNotCompleted = true;
+						// we avoid writing data to the partition since it is only partially encrypted
+						Protection = VolumeProtection::ReadOnly;
 					}
 
-					Pim = pim;
-					Type = layout->GetType();
-					SectorSize = header->GetSectorSize();
+					uint64 partitionStartOffset = VolumeFile->GetPartitionDeviceStartOffset();
+
+					if (partitionStartOffset < header->GetEncryptedAreaStart()
+						|| partitionStartOffset >= header->GetEncryptedAreaStart() + header->GetEncryptedAreaLength())
+						throw PasswordIncorrect (SRC_POS);
 
-					VolumeDataOffset = layout->GetDataOffset (VolumeHostSize);
-					VolumeDataSize = layout->GetDataSize (VolumeHostSize);
-					EncryptedDataSize = header->GetEncryptedAreaLength();
+					EncryptedDataSize -= partitionStartOffset - header->GetEncryptedAreaStart();
 
-					Header = header;
-					Layout = layout;
-					EA = header->GetEncryptionAlgorithm();
-					EncryptionMode &mode = *EA->GetMode();
+					mode.SetSectorOffset (partitionStartOffset / ENCRYPTION_DATA_UNIT_SIZE);
+				}
 
-					if (layout->HasDriveHeader())
+				// Volume protection
+				if (Protection == VolumeProtection::HiddenVolumeReadOnly)
+				{
+					if (Type == VolumeType::Hidden)
+						throw PasswordIncorrect (SRC_POS);
+					else
 					{
-						if (header->GetEncryptedAreaLength() != header->GetVolumeDataSize())
+						try
 						{
-							EncryptionNotCompleted = true;
-							// we avoid writing data to the partition since it is only partially encrypted
-							Protection = VolumeProtection::ReadOnly;
-						}
+							Volume protectedVolume;
 
-						uint64 partitionStartOffset = VolumeFile->GetPartitionDeviceStartOffset();
+							protectedVolume.Open (VolumeFile,
+								protectionPassword, protectionPim, protectionKdf, protectionKeyfiles,
+								emvSupportEnabled,
+								VolumeProtection::ReadOnly,
+								shared_ptr <VolumePassword> (), 0, shared_ptr <Pkcs5Kdf> (),shared_ptr <KeyfileList> (),
+								VolumeType::Hidden,
+								useBackupHeaders);
 
-						if (partitionStartOffset < header->GetEncryptedAreaStart()
-							|| partitionStartOffset >= header->GetEncryptedAreaStart() + header->GetEncryptedAreaLength())
-							throw PasswordIncorrect (SRC_POS);
+							if (protectedVolume.GetType() != VolumeType::Hidden)
+								ParameterIncorrect (SRC_POS);
 
-						EncryptedDataSize -= partitionStartOffset - header->GetEncryptedAreaStart();
-
-						mode.SetSectorOffset (partitionStartOffset / ENCRYPTION_DATA_UNIT_SIZE);
-					}
-
-					// Volume protection
-					if (Protection == VolumeProtection::HiddenVolumeReadOnly)
-					{
-						if (Type == VolumeType::Hidden)
-							throw PasswordIncorrect (SRC_POS);
-						else
+							ProtectedRangeStart = protectedVolume.VolumeDataOffset;
+							ProtectedRangeEnd = protectedVolume.VolumeDataOffset + protectedVolume.VolumeDataSize;
+						}
+						catch (PasswordException&)
 						{
-							try
-							{
-								Volume protectedVolume;
-
-								protectedVolume.Open (VolumeFile,
-									protectionPassword, protectionPim, protectionKdf, protectionKeyfiles,
-									emvSupportEnabled,
-									VolumeProtection::ReadOnly,
-									shared_ptr <VolumePassword> (), 0, shared_ptr <Pkcs5Kdf> (),shared_ptr <KeyfileList> (),
-									VolumeType::Hidden,
-									useBackupHeaders);
-
-								if (protectedVolume.GetType() != VolumeType::Hidden)
-									ParameterIncorrect (SRC_POS);
-
-								ProtectedRangeStart = protectedVolume.VolumeDataOffset;
-								ProtectedRangeEnd = protectedVolume.VolumeDataOffset + protectedVolume.VolumeDataSize;
-							}
-							catch (PasswordException&)
-							{
-								if (protectionKeyfiles && !protectionKeyfiles->empty())
-									throw ProtectionPasswordKeyfilesIncorrect (SRC_POS);
-								throw ProtectionPasswordIncorrect (SRC_POS);
-							}
+							if (protectionKeyfiles && !protectionKeyfiles->empty())
+								throw ProtectionPasswordKeyfilesIncorrect (SRC_POS);
+							throw ProtectionPasswordIncorrect (SRC_POS);
 						}
 					}
-					return;
 				}
+				return;
 			}
 
 			if (partitionInSystemEncryptionScope)
@@ -395,10 +417,10 @@ namespace VeraCrypt
 		if (Protection == VolumeProtection::HiddenVolumeReadOnly)
 			CheckProtectedRange (hostOffset, length);
 
+		// The ciphertext is written directly to encBuf; the caller's buffer is left unchanged
 		SecureBuffer encBuf (buffer.Size());
-		encBuf.CopyFrom (buffer);
 
-		EA->EncryptSectors (encBuf, hostOffset / SectorSize, length / SectorSize, SectorSize);
+		EA->EncryptSectors (buffer, encBuf, hostOffset / SectorSize, length / SectorSize, SectorSize);
 		VolumeFile->WriteAt (encBuf, hostOffset);
 
 		TotalDataWritten += length;
@@ -103,32 +103,93 @@ namespace VeraCrypt
 	}
 
 	bool VolumeHeader::Decrypt (const ConstBufferPtr &encryptedData, const VolumePassword &password, int pim, shared_ptr <Pkcs5Kdf> kdf, const Pkcs5KdfList &keyDerivationFunctions, const EncryptionAlgorithmList &encryptionAlgorithms, const EncryptionModeList &encryptionModes)
+	{
+		vector <VolumeHeaderCandidate> candidates (1);
+		candidates.front().Header = this;
+		candidates.front().EncryptedData = encryptedData;
+		candidates.front().KeyDerivationFunctions = keyDerivationFunctions;
+		candidates.front().EncryptionAlgorithms = encryptionAlgorithms;
+		candidates.front().EncryptionModes = encryptionModes;
+
+		size_t decryptedCandidate;
+		return DecryptAny (candidates, password, pim, kdf, decryptedCandidate);
+	}
+
+	bool VolumeHeader::DecryptAny (const vector <VolumeHeaderCandidate> &candidates, const VolumePassword &password, int pim, shared_ptr <Pkcs5Kdf> kdf, size_t &decryptedCandidate)
 	{
 		if (password.Size() < 1)
 			throw PasswordEmpty (SRC_POS);
 
-		ConstBufferPtr salt (encryptedData.GetRange (SaltOffset, SaltSize));
+		// Salts are referenced by the key derivation work items and must not be reallocated
+		vector <ConstBufferPtr> salts;
+		salts.reserve (candidates.size());
+		vector < vector < shared_ptr <Pkcs5Kdf> > > candidateKdfs (candidates.size());
+		size_t derivationCount = 0;
+		size_t maxCandidateDerivationCount = 0;
+
+		for (size_t i = 0; i < candidates.size(); ++i)
+		{
+			salts.push_back (candidates[i].EncryptedData.GetRange (SaltOffset, SaltSize));
+
+			foreach (shared_ptr <Pkcs5Kdf> layoutKdf, candidates[i].KeyDerivationFunctions)
+			{
+				// Layouts list single-lane Argon2, which stands for any number of lanes selected by the user
+				shared_ptr <Pkcs5Kdf> pkcs5 = (kdf && kdf->IsArgon2() && layoutKdf->IsArgon2()) ? kdf : layoutKdf;
+				if (!kdf || kdf->GetName() == pkcs5->GetName())
+					candidateKdfs[i].push_back (pkcs5);
+			}
+
+			derivationCount += candidateKdfs[i].size();
+			maxCandidateDerivationCount = max (maxCandidateDerivationCount, candidateKdfs[i].size());
+		}
 
-		if (!kdf && EncryptionThreadPool::IsRunning() && keyDerivationFunctions.size() > 1)
+		if (EncryptionThreadPool::IsRunning() && derivationCount > 1)
 		{
 			typedef EncryptionThreadPool::KeyDerivationWorkItem KeyDerivationWorkItem;
 
-			list < shared_ptr <KeyDerivationWorkItem> > keyDerivationWorkItems;
+			vector < shared_ptr <KeyDerivationWorkItem> > keyDerivationWorkItems;
+			vector <size_t> workItemCandidates;
 			SharedVal <size_t> outstandingWorkItemCount (0);
 			SyncEvent keyDerivationCompletedEvent;
 			SyncEvent noOutstandingWorkItemEvent;
 			long volatile abortKeyDerivation = 0;
 			size_t enqueuedWorkItemCount = 0;
 			size_t processedWorkItemCount = 0;
+			vector <size_t> deferredWorkItems;
+			size_t nextDeferredWorkItem = 0;
 			bool workItemsDrained = false;
 
 			try
 			{
-				foreach (shared_ptr <Pkcs5Kdf> pkcs5, keyDerivationFunctions)
+				// The KDFs of all candidates are interleaved, so that the most likely ones of each header are derived first
+				for (size_t kdfIndex = 0; kdfIndex < maxCandidateDerivationCount; ++kdfIndex)
+				{
+					for (size_t i = 0; i < candidates.size(); ++i)
+					{
+						if (kdfIndex >= candidateKdfs[i].size())
+							continue;
+
+						shared_ptr <Pkcs5Kdf> pkcs5 = candidateKdfs[i][kdfIndex];
+						shared_ptr <KeyDerivationWorkItem> keyDerivationWorkItem (new KeyDerivationWorkItem (pkcs5, GetHeaderKeyDerivationSize (pkcs5)));
+						keyDerivationWorkItems.push_back (keyDerivationWorkItem);
+						workItemCandidates.push_back (i);
+
+						// Memory-hard derivations need up to gigabytes each and are run one at a time
+						if (pkcs5->IsArgon2())
+						{
+							deferredWorkItems.push_back (keyDerivationWorkItems.size() - 1);
+							continue;
+						}
+
+						EncryptionThreadPool::BeginKeyDerivation (*keyDerivationWorkItem, password, pim, salts[i], keyDerivationCompletedEvent, noOutstandingWorkItemEvent, outstandingWorkItemCount, &abortKeyDerivation);
+						++enqueuedWorkItemCount;
+					}
+				}
+
+				if (!deferredWorkItems.empty())
 				{
-					shared_ptr <KeyDerivationWorkItem> keyDerivationWorkItem (new KeyDerivationWorkItem (pkcs5, GetHeaderKeyDerivationSize (pkcs5)));
-					keyDerivationWorkItems.push_back (keyDerivationWorkItem);
-					EncryptionThreadPool::BeginKeyDerivation (*keyDerivationWorkItem, password, pim, salt, keyDerivationCompletedEvent, noOutstandingWorkItemEvent, outstandingWorkItemCount, &abortKeyDerivation);
+					size_t w = deferredWorkItems[nextDeferredWorkItem++];
+					EncryptionThreadPool::BeginKeyDerivation (*keyDerivationWorkItems[w], password, pim, salts[workItemCandidates[w]], keyDerivationCompletedEvent, noOutstandingWorkItemEvent, outstandingWorkItemCount, &abortKeyDerivation);
 					++enqueuedWorkItemCount;
 				}
 
@@ -136,29 +197,49 @@ namespace VeraCrypt
 				{
 					bool processed = false;
 
-					foreach (shared_ptr <KeyDerivationWorkItem> keyDerivationWorkItem, keyDerivationWorkItems)
+					for (size_t w = 0; w < keyDerivationWorkItems.size(); ++w)
 					{
-						if (!keyDerivationWorkItem->Processed && keyDerivationWorkItem->Completed.Get())
+						KeyDerivationWorkItem &keyDerivationWorkItem = *keyDerivationWorkItems[w];
+
+						if (!keyDerivationWorkItem.Processed && keyDerivationWorkItem.Completed.Get())
 						{
-							keyDerivationWorkItem->Processed = true;
+							keyDerivationWorkItem.Processed = true;
 							++processedWorkItemCount;
 							processed = true;
 
-							if (keyDerivationWorkItem->ItemException.get())
+							if (keyDerivationWorkItem.ItemException.get())
 							{
 								// KDF exceptions are fatal setup/runtime errors; candidate failures are reported via Result.
 								abortKeyDerivation = 1;
 								DrainKeyDerivationWorkItems (noOutstandingWorkItemEvent, enqueuedWorkItemCount, workItemsDrained);
-								keyDerivationWorkItem->ItemException->Throw();
+								keyDerivationWorkItem.ItemException->Throw();
+							}
+
+							if (keyDerivationWorkItem.Result != 0 && (kdf || keyDerivationWorkItem.Kdf->IsFatalDerivationFailure (keyDerivationWorkItem.Result)))
+							{
+								abortKeyDerivation = 1;
+								DrainKeyDerivationWorkItems (noOutstandingWorkItemEvent, enqueuedWorkItemCount, workItemsDrained);
+								throw ExternalException (SRC_POS, keyDerivationWorkItem.Kdf->GetDerivationFailureMessage (keyDerivationWorkItem.Result));
+							}
+
+							// The memory of the completed derivation has been released
+							if (keyDerivationWorkItem.Kdf->IsArgon2() && nextDeferredWorkItem < deferredWorkItems.size())
+							{
+								size_t deferredWorkItem = deferredWorkItems[nextDeferredWorkItem++];
+								EncryptionThreadPool::BeginKeyDerivation (*keyDerivationWorkItems[deferredWorkItem], password, pim, salts[workItemCandidates[deferredWorkItem]], keyDerivationCompletedEvent, noOutstandingWorkItemEvent, outstandingWorkItemCount, &abortKeyDerivation);
+								++enqueuedWorkItemCount;
 							}
 
-							if (keyDerivationWorkItem->Result != 0)
+							if (keyDerivationWorkItem.Result != 0)
 								continue;
 
-							if (DecryptWithHeaderKey (encryptedData, keyDerivationWorkItem->Kdf, keyDerivationWorkItem->DerivedKey, encryptionAlgorithms, encryptionModes))
+							const VolumeHeaderCandidate &candidate = candidates[workItemCandidates[w]];
+
+							if (candidate.Header->DecryptWithHeaderKey (candidate.EncryptedData, keyDerivationWorkItem.Kdf, keyDerivationWorkItem.DerivedKey, candidate.EncryptionAlgorithms, candidate.EncryptionModes))
 							{
 								abortKeyDerivation = 1;
 								DrainKeyDerivationWorkItems (noOutstandingWorkItemEvent, enqueuedWorkItemCount, workItemsDrained);
+								decryptedCandidate = workItemCandidates[w];
 								return true;
 							}
 						}
@@ -179,23 +260,28 @@ namespace VeraCrypt
 			return false;
 		}
 
-		foreach (shared_ptr <Pkcs5Kdf> pkcs5, keyDerivationFunctions)
+		for (size_t i = 0; i < candidates.size(); ++i)
 		{
-			if (kdf && (kdf->GetName() != pkcs5->GetName()))
-				continue;
+			const VolumeHeaderCandidate &candidate = candidates[i];
 
-			SecureBuffer headerKey (GetHeaderKeyDerivationSize (pkcs5));
-			int derivationResult = pkcs5->DeriveKey (headerKey, password, pim, salt);
-			if (derivationResult != 0)
+			foreach (shared_ptr <Pkcs5Kdf> pkcs5, candidateKdfs[i])
 			{
-				if (!kdf)
-					continue;
+				SecureBuffer headerKey (GetHeaderKeyDerivationSize (pkcs5));
+				int derivationResult = pkcs5->DeriveKey (headerKey, password, pim, salts[i]);
+				if (derivationResult != 0)
+				{
+					if (!kdf && !pkcs5->IsFatalDerivationFailure (derivationResult))
+						continue;
 
-				throw ExternalException (SRC_POS, pkcs5->GetDerivationFailureMessage (derivationResult));
-			}
+					throw ExternalException (SRC_POS, pkcs5->GetDerivationFailureMessage (derivationResult));
+				}
 
-			if (DecryptWithHeaderKey (encryptedData, pkcs5, headerKey, encryptionAlgorithms, encryptionModes))
-				return true;
+				if (candidate.Header->DecryptWithHeaderKey (candidate.EncryptedData, pkcs5, headerKey, candidate.EncryptionAlgorithms, candidate.EncryptionModes))
+				{
+					decryptedCandidate = i;
+					return true;
+				}
+			}
 		}
 
 		return false;
@@ -53,6 +53,18 @@ namespace VeraCrypt
 		VolumeType::Enum Type;
 	};
 
+	class VolumeHeader;
+
+	// Encrypted header to be tried by VolumeHeader::DecryptAny ()
+	struct VolumeHeaderCandidate
+	{
+		VolumeHeader *Header;
+		ConstBufferPtr EncryptedData;
+		Pkcs5KdfList KeyDerivationFunctions;
+		EncryptionAlgorithmList EncryptionAlgorithms;
+		EncryptionModeList EncryptionModes;
+	};
+
 	class VolumeHeader
 	{
 	public:
@@ -61,6 +73,8 @@ namespace VeraCrypt
 
 		void Create (const BufferPtr &headerBuffer, VolumeHeaderCreationOptions &options);
 		bool Decrypt (const ConstBufferPtr &encryptedData, const VolumePassword &password, int pim, shared_ptr <Pkcs5Kdf> kdf, const Pkcs5KdfList &keyDerivationFunctions, const EncryptionAlgorithmList &encryptionAlgorithms, const EncryptionModeList &encryptionModes);
+		// Derives the header keys of all candidates at once and decrypts the first header opened by the password
+		static bool DecryptAny (const vector <VolumeHeaderCandidate> &candidates, const VolumePassword &password, int pim, shared_ptr <Pkcs5Kdf> kdf, size_t &decryptedCandidate);
 		void EncryptNew (const BufferPtr &newHeaderBuffer, const ConstBufferPtr &newSalt, const ConstBufferPtr &newHeaderKey, shared_ptr <Pkcs5Kdf> newPkcs5Kdf);
 		uint64 GetEncryptedAreaStart () const { return EncryptedAreaStart; }
 		uint64 GetEncryptedAreaLength () const { return EncryptedAreaLength; }